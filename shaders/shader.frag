@@ -1,10 +1,28 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+/* array sizes, see struct Bindless */
+layout(constant_id = 0) const uint BINDLESS_TEXTURES = 1;
+layout(constant_id = 1) const uint BINDLESS_BUFFERS = 1;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[BINDLESS_TEXTURES];
+layout(set = 0, binding = 1) readonly buffer Material {
+    vec4 color;
+} materials[BINDLESS_BUFFERS];
+
+/* struct BindlessConstants, the same for the whole draw, after the
+ * vertex stage's struct DrawPayload */
+layout(push_constant) uniform Constants {
+    layout(offset = 72) uint textureIndex;
+    uint bufferIndex;
+} constants;
+
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUv;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    outColor = vec4(fragColor, 1.0) * texture(textures[constants.textureIndex], fragUv) *
+               materials[constants.bufferIndex].color;
 }
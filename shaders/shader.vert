@@ -1,21 +1,43 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(location = 0) out vec3 fragColor;
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+/* per instance, mat4 uses locations 2..5 */
+layout(location = 2) in mat4 instanceModel;
+layout(location = 6) in vec4 instanceColor;
+
+/* bindless storage buffer count, see struct Bindless, and where the draw
+ * transform comes from: 0 push constants, 1 the transform buffer */
+layout(constant_id = 1) const uint BINDLESS_BUFFERS = 1;
+layout(constant_id = 2) const uint TRANSFORM_SOURCE = 0;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(set = 0, binding = 1) readonly buffer Transforms {
+    mat4 transforms[];
+} transformBuffers[BINDLESS_BUFFERS];
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+/* struct DrawPayload */
+layout(push_constant) uniform Draw {
+    mat4 transform;
+    uint object;
+    uint transforms;
+} draw;
+
+/* struct FrameUniforms, at the frame's dynamic offset in the uniform ring */
+layout(set = 1, binding = 0) uniform Frame {
+    mat4 viewProjection;
+} frame;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUv;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    mat4 transform = draw.transform;
+    if (TRANSFORM_SOURCE == 1)
+        transform = transformBuffers[draw.transforms].transforms[draw.object + gl_InstanceIndex];
+    gl_Position = frame.viewProjection * transform * instanceModel * vec4(inPosition, 1.0);
+    fragColor = inColor * instanceColor.rgb;
+    /* planar, the vertex format has no texture coordinates */
+    fragUv = inPosition.xy + 0.5;
 }
@@ -0,0 +1,579 @@
+#include "allocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALLOCATOR_MIN_NODE (1ull << ALLOCATOR_MIN_NODE_SHIFT)
+
+int32_t find_memory_type(const VkPhysicalDeviceMemoryProperties* memoryProperties,
+                         uint32_t                                typeBits,
+                         VkMemoryPropertyFlags                   flags)
+{
+    for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; ++i)
+    {
+        if ((typeBits & (1u << i)) &&
+            (memoryProperties->memoryTypes[i].propertyFlags & flags) == flags)
+        {
+            return (int32_t) i;
+        }
+    }
+    return -1;
+}
+
+static uint32_t log2_ceil(VkDeviceSize value)
+{
+    uint32_t shift = 0;
+    while ((1ull << shift) < value)
+        ++shift;
+    return shift;
+}
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+
+/*****************************************************************************/
+/*                                   buddy                                   */
+/*****************************************************************************/
+/* nodes of order k are ALLOCATOR_MIN_NODE << k bytes, there are
+ * 1 << (levels - 1 - k) of them and their bits start at
+ * (1 << levels) - (1 << (levels - k)) */
+static size_t buddy_bit(const struct AllocatorBlock* block, uint32_t order, uint32_t node)
+{
+    return ((size_t) 1 << block->levels) - ((size_t) 1 << (block->levels - order)) + node;
+}
+
+static bool buddy_is_free(const struct AllocatorBlock* block, uint32_t order, uint32_t node)
+{
+    size_t bit = buddy_bit(block, order, node);
+    return block->freeBits[bit >> 3] & (1u << (bit & 7));
+}
+
+static void buddy_mark(struct AllocatorBlock* block, uint32_t order, uint32_t node, bool free)
+{
+    size_t bit = buddy_bit(block, order, node);
+    if (free)
+        block->freeBits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+    else
+        block->freeBits[bit >> 3] &= (uint8_t) ~(1u << (bit & 7));
+}
+
+/* drops stale and duplicate entries. kept nodes are unmarked while
+ * filtering so a second entry of the same node is seen as stale. */
+static void buddy_compact(struct AllocatorBlock* block, uint32_t order)
+{
+    uint32_t* list  = block->free[order];
+    uint32_t  count = 0;
+    for (uint32_t i = 0; i < block->freeCount[order]; ++i)
+    {
+        if (buddy_is_free(block, order, list[i]))
+        {
+            buddy_mark(block, order, list[i], false);
+            list[count++] = list[i];
+        }
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        buddy_mark(block, order, list[i], true);
+    }
+    block->freeCount[order] = count;
+}
+
+static void buddy_push(struct AllocatorBlock* block, uint32_t order, uint32_t node)
+{
+    buddy_mark(block, order, node, true);
+
+    if (block->freeCount[order] == block->freeCapacity[order])
+    {
+        buddy_compact(block, order);
+    }
+    if (block->freeCount[order] == block->freeCapacity[order])
+    {
+        uint32_t capacity = block->freeCapacity[order] ? block->freeCapacity[order] * 2 : 8;
+        block->free[order] = realloc(block->free[order], capacity * sizeof(uint32_t));
+        if (block->free[order] == NULL)
+        {
+            fprintf(stderr, "allocator out of host memory\n");
+            exit(EXIT_FAILURE);
+        }
+        block->freeCapacity[order] = capacity;
+    }
+    block->free[order][block->freeCount[order]++] = node;
+}
+
+static bool buddy_pop(struct AllocatorBlock* block, uint32_t order, uint32_t* node)
+{
+    while (block->freeCount[order] > 0)
+    {
+        uint32_t candidate = block->free[order][--block->freeCount[order]];
+        if (buddy_is_free(block, order, candidate))
+        {
+            buddy_mark(block, order, candidate, false);
+            *node = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool buddy_alloc(struct AllocatorBlock* block, uint32_t order, VkDeviceSize* offset)
+{
+    uint32_t level = order;
+    uint32_t node  = 0;
+    while (level < block->levels && !buddy_pop(block, level, &node))
+        ++level;
+
+    if (level == block->levels)
+        return false;
+
+    /* split down, keeping the left half and freeing the right one */
+    while (level > order)
+    {
+        --level;
+        node *= 2;
+        buddy_push(block, level, node + 1);
+    }
+
+    *offset = (VkDeviceSize) node << (order + ALLOCATOR_MIN_NODE_SHIFT);
+    return true;
+}
+
+static void buddy_free(struct AllocatorBlock* block, uint32_t order, VkDeviceSize offset)
+{
+    uint32_t node = (uint32_t)(offset >> (order + ALLOCATOR_MIN_NODE_SHIFT));
+
+    /* merge with free buddies, their list entries go stale */
+    while (order + 1 < block->levels && buddy_is_free(block, order, node ^ 1u))
+    {
+        buddy_mark(block, order, node ^ 1u, false);
+        node >>= 1;
+        ++order;
+    }
+    buddy_push(block, order, node);
+}
+
+static VkDeviceSize buddy_largest_free(const struct AllocatorBlock* block)
+{
+    for (uint32_t order = block->levels; order-- > 0;)
+    {
+        for (uint32_t i = 0; i < block->freeCount[order]; ++i)
+        {
+            if (buddy_is_free(block, order, block->free[order][i]))
+                return ALLOCATOR_MIN_NODE << order;
+        }
+    }
+    return 0;
+}
+
+
+/*****************************************************************************/
+/*                                  blocks                                   */
+/*****************************************************************************/
+static bool allocator_memory_create(struct Allocator* allocator,
+                                    uint32_t          memoryType,
+                                    VkDeviceSize      size,
+                                    VkDeviceMemory*   memory,
+                                    void**            mapped)
+{
+    uint32_t live = allocator->dedicatedCount;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+    {
+        live += allocator->pools[i][0].blocksCount + allocator->pools[i][1].blocksCount;
+    }
+    if (live >= allocator->maxMemoryAllocationCount)
+    {
+        fprintf(stderr, "allocator: maxMemoryAllocationCount (%d) reached\n", live);
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize       = size;
+    allocInfo.memoryTypeIndex      = memoryType;
+
+    if (vkAllocateMemory(allocator->device, &allocInfo, NULL, memory) != VK_SUCCESS)
+        return false;
+
+    *mapped = NULL;
+    if (allocator->memoryProperties.memoryTypes[memoryType].propertyFlags &
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(allocator->device, *memory, 0, size, 0, mapped) != VK_SUCCESS)
+        {
+            vkFreeMemory(allocator->device, *memory, NULL);
+            return false;
+        }
+    }
+    return true;
+}
+
+static struct AllocatorBlock* allocator_block_create(struct Allocator*     allocator,
+                                                    struct AllocatorPool* pool,
+                                                    uint32_t              memoryType)
+{
+    if (pool->blocksCount == pool->blocksCapacity)
+    {
+        uint32_t capacity = pool->blocksCapacity ? pool->blocksCapacity * 2 : 4;
+        pool->blocks      = realloc(pool->blocks, capacity * sizeof(pool->blocks[0]));
+        if (pool->blocks == NULL)
+        {
+            fprintf(stderr, "allocator out of host memory\n");
+            exit(EXIT_FAILURE);
+        }
+        pool->blocksCapacity = capacity;
+    }
+
+    struct AllocatorBlock block = {};
+    block.size                  = allocator->blockSize[memoryType];
+    block.levels                = log2_ceil(block.size) - ALLOCATOR_MIN_NODE_SHIFT + 1;
+
+    if (!allocator_memory_create(allocator, memoryType, block.size, &block.memory, &block.mapped))
+        return NULL;
+
+    block.freeBits = calloc(((size_t) 1 << block.levels) / 8 + 1, 1);
+    if (block.freeBits == NULL)
+    {
+        fprintf(stderr, "allocator out of host memory\n");
+        exit(EXIT_FAILURE);
+    }
+    buddy_push(&block, block.levels - 1, 0);
+
+    pool->blocks[pool->blocksCount] = block;
+    return &pool->blocks[pool->blocksCount++];
+}
+
+static void allocator_block_destroy(struct Allocator* allocator, struct AllocatorBlock* block)
+{
+    if (block->mapped)
+        vkUnmapMemory(allocator->device, block->memory);
+    vkFreeMemory(allocator->device, block->memory, NULL);
+    for (uint32_t i = 0; i < block->levels; ++i)
+    {
+        free(block->free[i]);
+    }
+    free(block->freeBits);
+}
+
+
+/*****************************************************************************/
+/*                                 allocator                                 */
+/*****************************************************************************/
+void allocator_init(struct Allocator* allocator, VkPhysicalDevice devicePhysical, VkDevice device)
+{
+    memset(allocator, 0, sizeof(*allocator));
+    allocator->device = device;
+    vkGetPhysicalDeviceMemoryProperties(devicePhysical, &allocator->memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(devicePhysical, &properties);
+    allocator->bufferImageGranularity   = properties.limits.bufferImageGranularity;
+    allocator->maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    /* small heaps (e.g. host visible device local) get smaller blocks */
+    for (uint32_t i = 0; i < allocator->memoryProperties.memoryTypeCount; ++i)
+    {
+        uint32_t     heap      = allocator->memoryProperties.memoryTypes[i].heapIndex;
+        VkDeviceSize heapSize  = allocator->memoryProperties.memoryHeaps[heap].size;
+        VkDeviceSize blockSize = ALLOCATOR_BLOCK_SIZE;
+        while (blockSize > (1ull << 20) && blockSize > heapSize / 8)
+            blockSize /= 2;
+        allocator->blockSize[i] = blockSize;
+    }
+}
+
+void allocator_destroy(struct Allocator* allocator)
+{
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+    {
+        for (uint32_t kind = 0; kind < 2; ++kind)
+        {
+            struct AllocatorPool* pool = &allocator->pools[i][kind];
+            for (uint32_t j = 0; j < pool->blocksCount; ++j)
+            {
+                if (pool->blocks[j].allocations > 0)
+                {
+                    fprintf(stderr,
+                            "allocator: %d allocation(s) leaked in memory type %d\n",
+                            pool->blocks[j].allocations,
+                            i);
+                }
+                allocator_block_destroy(allocator, &pool->blocks[j]);
+            }
+            free(pool->blocks);
+        }
+    }
+    if (allocator->dedicatedCount > 0)
+    {
+        fprintf(stderr,
+                "allocator: %d dedicated allocation(s) leaked\n",
+                allocator->dedicatedCount);
+    }
+    memset(allocator, 0, sizeof(*allocator));
+}
+
+bool allocator_alloc(struct Allocator*           allocator,
+                     const VkMemoryRequirements* requirements,
+                     VkMemoryPropertyFlags       flags,
+                     enum AllocatorKind          kind,
+                     struct Allocation*          allocation)
+{
+    int32_t memoryType =
+        find_memory_type(&allocator->memoryProperties, requirements->memoryTypeBits, flags);
+    if (memoryType < 0)
+        return false;
+
+    memset(allocation, 0, sizeof(*allocation));
+    allocation->size       = requirements->size;
+    allocation->memoryType = (uint32_t) memoryType;
+    allocation->kind       = (uint8_t) kind;
+
+    VkDeviceSize nodeSize = requirements->size > requirements->alignment
+                                ? requirements->size
+                                : requirements->alignment;
+    uint32_t     order    = log2_ceil(nodeSize);
+    order = order > ALLOCATOR_MIN_NODE_SHIFT ? order - ALLOCATOR_MIN_NODE_SHIFT : 0;
+
+    /* anything above half a block gets its own memory */
+    if ((ALLOCATOR_MIN_NODE << order) > allocator->blockSize[memoryType] / 2)
+    {
+        if (!allocator_memory_create(allocator,
+                                     (uint32_t) memoryType,
+                                     requirements->size,
+                                     &allocation->memory,
+                                     &allocation->mapped))
+        {
+            return false;
+        }
+        allocation->block = -1;
+        allocator->dedicatedCount += 1;
+        allocator->dedicatedReserved += requirements->size;
+        allocator->dedicatedUsed += requirements->size;
+        return true;
+    }
+
+    /* granularity only matters if a page could be shared by two nodes */
+    uint32_t poolIndex = allocator->bufferImageGranularity > ALLOCATOR_MIN_NODE ? kind : 0;
+    struct AllocatorPool* pool = &allocator->pools[memoryType][poolIndex];
+
+    struct AllocatorBlock* block  = NULL;
+    VkDeviceSize           offset = 0;
+    for (uint32_t i = 0; i < pool->blocksCount && block == NULL; ++i)
+    {
+        if (buddy_alloc(&pool->blocks[i], order, &offset))
+            block = &pool->blocks[i];
+    }
+    if (block == NULL)
+    {
+        block = allocator_block_create(allocator, pool, (uint32_t) memoryType);
+        if (block == NULL || !buddy_alloc(block, order, &offset))
+            return false;
+    }
+
+    block->used += requirements->size;
+    block->allocated += ALLOCATOR_MIN_NODE << order;
+    block->allocations += 1;
+
+    allocation->memory = block->memory;
+    allocation->offset = offset;
+    allocation->mapped = block->mapped ? (char*) block->mapped + offset : NULL;
+    allocation->block  = (int32_t)(block - pool->blocks);
+    allocation->order  = (uint8_t) order;
+    return true;
+}
+
+void allocator_free(struct Allocator* allocator, struct Allocation* allocation)
+{
+    if (allocation->memory == VK_NULL_HANDLE)
+        return;
+
+    if (allocation->block < 0)
+    {
+        if (allocation->mapped)
+            vkUnmapMemory(allocator->device, allocation->memory);
+        vkFreeMemory(allocator->device, allocation->memory, NULL);
+        allocator->dedicatedCount -= 1;
+        allocator->dedicatedReserved -= allocation->size;
+        allocator->dedicatedUsed -= allocation->size;
+        memset(allocation, 0, sizeof(*allocation));
+        return;
+    }
+
+    uint32_t poolIndex =
+        allocator->bufferImageGranularity > ALLOCATOR_MIN_NODE ? allocation->kind : 0;
+    struct AllocatorPool*  pool  = &allocator->pools[allocation->memoryType][poolIndex];
+    struct AllocatorBlock* block = &pool->blocks[allocation->block];
+
+    buddy_free(block, allocation->order, allocation->offset);
+    block->used -= allocation->size;
+    block->allocated -= ALLOCATOR_MIN_NODE << allocation->order;
+    block->allocations -= 1;
+
+    /* release empty blocks, but keep the last one of a pool around. only
+     * the tail block is released so indices of live allocations stay valid */
+    while (pool->blocksCount > 1 && pool->blocks[pool->blocksCount - 1].allocations == 0)
+    {
+        allocator_block_destroy(allocator, &pool->blocks[--pool->blocksCount]);
+    }
+
+    memset(allocation, 0, sizeof(*allocation));
+}
+
+void allocator_stats(const struct Allocator* allocator, struct AllocatorStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->reserved          = allocator->dedicatedReserved;
+    stats->used              = allocator->dedicatedUsed;
+    stats->allocated         = allocator->dedicatedReserved;
+    stats->deviceMemoryCount = allocator->dedicatedCount;
+    stats->allocations       = allocator->dedicatedCount;
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+    {
+        for (uint32_t kind = 0; kind < 2; ++kind)
+        {
+            const struct AllocatorPool* pool = &allocator->pools[i][kind];
+            for (uint32_t j = 0; j < pool->blocksCount; ++j)
+            {
+                const struct AllocatorBlock* block = &pool->blocks[j];
+
+                VkDeviceSize largest = buddy_largest_free(block);
+                stats->reserved += block->size;
+                stats->used += block->used;
+                stats->allocated += block->allocated;
+                stats->free += block->size - block->allocated;
+                stats->largestFree = largest > stats->largestFree ? largest : stats->largestFree;
+                stats->deviceMemoryCount += 1;
+                stats->allocations += block->allocations;
+            }
+        }
+    }
+
+    stats->fragmentationInternal =
+        stats->allocated ? 1.0 - (double) stats->used / (double) stats->allocated : 0.0;
+    stats->fragmentationExternal =
+        stats->free ? 1.0 - (double) stats->largestFree / (double) stats->free : 0.0;
+}
+
+void allocator_stats_print(const struct Allocator* allocator)
+{
+    struct AllocatorStats stats;
+    allocator_stats(allocator, &stats);
+
+    printf("gpu memory\n");
+    printf("  reserved  %.2f MiB in %d vkAllocateMemory(s) (max %d)\n",
+           (double) stats.reserved / (1024.0 * 1024.0),
+           stats.deviceMemoryCount,
+           allocator->maxMemoryAllocationCount);
+    printf("  used      %.2f MiB in %d allocation(s)\n",
+           (double) stats.used / (1024.0 * 1024.0),
+           stats.allocations);
+    printf("  free      %.2f MiB, largest %.2f MiB\n",
+           (double) stats.free / (1024.0 * 1024.0),
+           (double) stats.largestFree / (1024.0 * 1024.0));
+    printf("  fragmentation internal %.1f%%, external %.1f%%\n",
+           stats.fragmentationInternal * 100.0,
+           stats.fragmentationExternal * 100.0);
+}
+
+
+/*****************************************************************************/
+/*                                   ring                                    */
+/*****************************************************************************/
+bool allocator_ring_init(struct Allocator*           allocator,
+                         struct AllocatorRing*       ring,
+                         const VkMemoryRequirements* requirements,
+                         VkMemoryPropertyFlags       flags)
+{
+    memset(ring, 0, sizeof(*ring));
+
+    /* the ring is bound by offset, nodes are aligned to their size */
+    VkMemoryRequirements ringRequirements = *requirements;
+    if (ringRequirements.alignment < ALLOCATOR_MIN_NODE)
+        ringRequirements.alignment = ALLOCATOR_MIN_NODE;
+
+    if (!allocator_alloc(
+            allocator, &ringRequirements, flags, ALLOCATOR_KIND_LINEAR, &ring->allocation))
+        return false;
+
+    ring->size = requirements->size;
+    return true;
+}
+
+void allocator_ring_destroy(struct Allocator* allocator, struct AllocatorRing* ring)
+{
+    allocator_free(allocator, &ring->allocation);
+    memset(ring, 0, sizeof(*ring));
+}
+
+bool allocator_ring_alloc(struct AllocatorRing* ring,
+                          VkDeviceSize          size,
+                          VkDeviceSize          alignment,
+                          VkDeviceSize*         offset)
+{
+    if (ring->used == 0)
+    {
+        ring->head = 0;
+        ring->tail = 0;
+    }
+
+    VkDeviceSize aligned = align_up(ring->head, alignment);
+    VkDeviceSize padding;
+
+    if (ring->used > 0 && ring->head == ring->tail)
+    {
+        return false;
+    }
+    else if (ring->head >= ring->tail)
+    {
+        /* free: [head, size) and [0, tail) */
+        if (aligned + size <= ring->size)
+        {
+            padding = aligned - ring->head;
+        }
+        else if (size <= ring->tail)
+        {
+            padding = ring->size - ring->head;
+            aligned = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    {
+        /* free: [head, tail) */
+        if (aligned + size > ring->tail)
+            return false;
+        padding = aligned - ring->head;
+    }
+
+    ring->head = aligned + size;
+    ring->used += padding + size;
+    ring->frameBytes += padding + size;
+
+    *offset = aligned;
+    return true;
+}
+
+void allocator_ring_frame_begin(struct AllocatorRing* ring, uint32_t slot)
+{
+    slot %= ALLOCATOR_RING_FRAMES;
+    if (ring->frameUsed[slot] > 0)
+    {
+        ring->tail = ring->frameEnd[slot];
+        ring->used -= ring->frameUsed[slot];
+        ring->frameUsed[slot] = 0;
+    }
+}
+
+void allocator_ring_frame_end(struct AllocatorRing* ring, uint32_t slot)
+{
+    slot %= ALLOCATOR_RING_FRAMES;
+    ring->frameEnd[slot]  = ring->head;
+    ring->frameUsed[slot] = ring->frameBytes;
+    ring->frameBytes      = 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define ALLOCATOR_BLOCK_SIZE     (64ull << 20) /* per vkAllocateMemory */
+#define ALLOCATOR_MIN_NODE_SHIFT 8             /* smallest buddy node, 256 bytes */
+#define ALLOCATOR_MAX_LEVELS     32
+#define ALLOCATOR_RING_FRAMES    4             /* frames a ring can track */
+/* clang-format on */
+
+/* buffers and linear images vs. optimal tiling images. kept in separate
+ * blocks when bufferImageGranularity is larger than the smallest node, so
+ * neighbours of different kinds can never share a granularity page. */
+enum AllocatorKind
+{
+    ALLOCATOR_KIND_LINEAR  = 0,
+    ALLOCATOR_KIND_OPTIMAL = 1,
+};
+
+struct Allocation
+{
+    VkDeviceMemory memory;
+    VkDeviceSize   offset;
+    VkDeviceSize   size;   /* requested size */
+    void*          mapped; /* persistent mapping for HOST_VISIBLE types, else NULL */
+    uint32_t       memoryType;
+    int32_t        block; /* -1: dedicated vkAllocateMemory */
+    uint8_t        order;
+    uint8_t        kind;
+};
+
+/* buddy allocator over one VkDeviceMemory. free lists may hold stale
+ * entries, freeBits is the truth: one bit per node, set while it is free. */
+struct AllocatorBlock
+{
+    VkDeviceMemory memory;
+    VkDeviceSize   size;
+    void*          mapped;
+    uint32_t       levels;
+    uint8_t*       freeBits;
+    uint32_t*      free[ALLOCATOR_MAX_LEVELS];
+    uint32_t       freeCount[ALLOCATOR_MAX_LEVELS];
+    uint32_t       freeCapacity[ALLOCATOR_MAX_LEVELS];
+    VkDeviceSize   used;      /* requested bytes */
+    VkDeviceSize   allocated; /* node bytes */
+    uint32_t       allocations;
+};
+
+struct AllocatorPool
+{
+    struct AllocatorBlock* blocks;
+    uint32_t               blocksCount;
+    uint32_t               blocksCapacity;
+};
+
+struct Allocator
+{
+    VkDevice                         device;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize                     bufferImageGranularity;
+    uint32_t                         maxMemoryAllocationCount;
+    VkDeviceSize                     blockSize[VK_MAX_MEMORY_TYPES];
+    struct AllocatorPool             pools[VK_MAX_MEMORY_TYPES][2];
+
+    /* dedicated allocations */
+    uint32_t     dedicatedCount;
+    VkDeviceSize dedicatedReserved;
+    VkDeviceSize dedicatedUsed;
+};
+
+struct AllocatorStats
+{
+    VkDeviceSize reserved;  /* bytes obtained from vkAllocateMemory */
+    VkDeviceSize used;      /* bytes requested by live allocations */
+    VkDeviceSize allocated; /* bytes of buddy nodes handed out */
+    VkDeviceSize free;      /* reserved - allocated in blocks */
+    VkDeviceSize largestFree;
+    uint32_t     deviceMemoryCount; /* live vkAllocateMemory objects */
+    uint32_t     allocations;
+    double       fragmentationInternal; /* 1 - used / allocated */
+    double       fragmentationExternal; /* 1 - largestFree / free */
+};
+
+/* linear ring for per-frame transient data. allocations of a frame are
+ * released together once that frame slot comes around again. */
+struct AllocatorRing
+{
+    struct Allocation allocation;
+    VkDeviceSize      size;
+    VkDeviceSize      head;
+    VkDeviceSize      tail;
+    VkDeviceSize      used;
+    VkDeviceSize      frameBytes;
+    VkDeviceSize      frameEnd[ALLOCATOR_RING_FRAMES];
+    VkDeviceSize      frameUsed[ALLOCATOR_RING_FRAMES];
+};
+
+/* index of the first memory type in typeBits that has all flags, -1 if none */
+int32_t find_memory_type(const VkPhysicalDeviceMemoryProperties* memoryProperties,
+                         uint32_t                                typeBits,
+                         VkMemoryPropertyFlags                   flags);
+
+void allocator_init(struct Allocator* allocator, VkPhysicalDevice devicePhysical, VkDevice device);
+
+void allocator_destroy(struct Allocator* allocator);
+
+/* suballocates memory that satisfies requirements and has all flags.
+ * returns false if no memory type fits or the device is out of memory.
+ * not thread safe. */
+bool allocator_alloc(struct Allocator*           allocator,
+                     const VkMemoryRequirements* requirements,
+                     VkMemoryPropertyFlags       flags,
+                     enum AllocatorKind          kind,
+                     struct Allocation*          allocation);
+
+void allocator_free(struct Allocator* allocator, struct Allocation* allocation);
+
+void allocator_stats(const struct Allocator* allocator, struct AllocatorStats* stats);
+
+void allocator_stats_print(const struct Allocator* allocator);
+
+/* ring of requirements->size bytes in memory with flags that fits
+ * requirements, those of the buffer bound to it (see buffer_ring_create).
+ * HOST_VISIBLE rings stay mapped */
+bool allocator_ring_init(struct Allocator*           allocator,
+                         struct AllocatorRing*       ring,
+                         const VkMemoryRequirements* requirements,
+                         VkMemoryPropertyFlags       flags);
+
+void allocator_ring_destroy(struct Allocator* allocator, struct AllocatorRing* ring);
+
+/* offset of size bytes inside ring->allocation, false if the ring is full */
+bool allocator_ring_alloc(struct AllocatorRing* ring,
+                          VkDeviceSize          size,
+                          VkDeviceSize          alignment,
+                          VkDeviceSize*         offset);
+
+/* call once the fence of frame slot has signaled, before allocating for it */
+void allocator_ring_frame_begin(struct AllocatorRing* ring, uint32_t slot);
+
+/* call after the last allocation of frame slot */
+void allocator_ring_frame_end(struct AllocatorRing* ring, uint32_t slot);
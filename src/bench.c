@@ -0,0 +1,1477 @@
+#include "bench.h"
+
+#include "buffer.h"
+#include "gpu_timer.h"
+#include "pipelines.h"
+#include "profiler.h"
+#include "scene.h"
+#include "texture.h"
+#include "uniform.h"
+#include "upload.h"
+#include "util.h"
+#include "vecmath.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void instances_grid(struct Instance* instances, uint32_t count)
+{
+    uint32_t side = 1;
+    while (side * side < count)
+        ++side;
+
+    float cell = 2.0f / (float) side;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        struct Instance* instance = &instances[i];
+        memset(instance, 0, sizeof(*instance));
+
+        instance->model[0]  = cell;
+        instance->model[5]  = cell;
+        instance->model[10] = 1.0f;
+        instance->model[12] = -1.0f + cell * ((float) (i % side) + 0.5f);
+        instance->model[13] = -1.0f + cell * ((float) (i / side) + 0.5f);
+        instance->model[15] = 1.0f;
+
+        /* tint fades across the grid, the first instance is untinted */
+        instance->color[0] = 1.0f - 0.5f * (float) (i % side) / (float) side;
+        instance->color[1] = 1.0f - 0.5f * (float) (i / side) / (float) side;
+        instance->color[2] = 1.0f;
+        instance->color[3] = 1.0f;
+    }
+}
+
+void headless_render(VkDevice            device,
+                     VkQueue             queue,
+                     struct Frame*       frames,
+                     uint32_t            framesInFlight,
+                     uint32_t            imagesCount,
+                     struct FrameRecord* record,
+                     uint32_t            count,
+                     FramePrepare        prepare,
+                     void*               context,
+                     struct FrameStats*  stats)
+{
+    double* frameTimes  = malloc(count * sizeof(frameTimes[0]));
+    double* recordTimes = malloc(count * sizeof(recordTimes[0]));
+
+    struct Samples latencies;
+    samples_init(&latencies, count);
+
+    VkFence imagesInFlight[SWAPCHAIN_IMAGES_MAX] = {};
+
+    uint32_t currentFrame = 0;
+    uint64_t loopStart    = util_time_ns();
+    uint64_t frameStart   = loopStart;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        PROFILE_SCOPE("frame");
+        struct Frame* frame = &frames[currentFrame];
+
+        PROFILE_BEGIN(wait, "wait");
+        frames_poll(device, frames, framesInFlight, &latencies);
+        frame_wait(device, frame, &latencies);
+
+        uint32_t imageIndex = i % imagesCount;
+        frame_claim_image(device, imagesInFlight, imageIndex, frame);
+        vkResetFences(device, 1, &frame->inFlight);
+        PROFILE_END(wait);
+
+        if (prepare != NULL)
+            prepare(context, i, currentFrame);
+
+        uint64_t recordStart = util_time_ns();
+        PROFILE_BEGIN(recording, "record");
+        frame_record(device, frame, currentFrame, imageIndex, record);
+        PROFILE_END(recording);
+        recordTimes[i] = (double) (util_time_ns() - recordStart) / 1e6;
+
+        PROFILE_BEGIN(submit, "submit");
+        frame_submit(queue, frame, false);
+        PROFILE_END(submit);
+
+        currentFrame = (currentFrame + 1) % framesInFlight;
+
+        uint64_t frameEnd = util_time_ns();
+        frameTimes[i]     = (double) (frameEnd - frameStart) / 1e6;
+        frameStart        = frameEnd;
+    }
+    for (uint32_t i = 0; i < framesInFlight; ++i)
+        frame_wait(device, &frames[i], &latencies);
+    vkDeviceWaitIdle(device);
+    uint64_t loopEnd = util_time_ns();
+    gpu_timer_flush(record->gpuTimer);
+
+    double frameTimeMax = 0.0;
+    for (uint32_t i = 0; i < count; ++i)
+        if (frameTimes[i] > frameTimeMax)
+            frameTimeMax = frameTimes[i];
+
+    stats->seconds         = (double) (loopEnd - loopStart) / 1e9;
+    stats->framesPerSecond = (double) count / stats->seconds;
+    stats->frameTimeP50    = util_percentile(frameTimes, count, 0.50);
+    stats->frameTimeP99    = util_percentile(frameTimes, count, 0.99);
+    stats->frameTimeMax    = frameTimeMax;
+    stats->recordTimeP50   = util_percentile(recordTimes, count, 0.50);
+    stats->latencyP50      = util_percentile(latencies.values, latencies.count, 0.50);
+    stats->latencyP99      = util_percentile(latencies.values, latencies.count, 0.99);
+
+    samples_destroy(&latencies);
+    free(recordTimes);
+    free(frameTimes);
+}
+
+/* cpu benchmarks ************************************************************/
+/* the error column is the largest difference to the scalar results, for
+ * the frustum test the spheres classified differently */
+void bench_math(uint32_t count, uint32_t iterations)
+{
+    /* points, rotations, scales and radii, one array per component */
+    float*   data = malloc(11 * (size_t) count * sizeof(data[0]));
+    uint32_t seed = 1;
+    for (size_t i = 0; i < 11 * (size_t) count; ++i)
+    {
+        seed    = seed * 1664525u + 1013904223u;
+        data[i] = (float) (seed >> 8) / (float) (1u << 23) - 1.0f;
+    }
+    struct Vec3Soa points    = {&data[0], &data[count], &data[2 * count]};
+    struct QuatSoa rotations = {&data[3 * count], &data[4 * count], &data[5 * count],
+                                &data[6 * count]};
+    struct Vec3Soa scales    = {&data[7 * count], &data[8 * count], &data[9 * count]};
+    float*         radii     = &data[10 * count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        struct Quat rotation = quat_normalize(
+            (struct Quat){rotations.x[i], rotations.y[i], rotations.z[i], rotations.w[i]});
+        rotations.x[i] = rotation.x;
+        rotations.y[i] = rotation.y;
+        rotations.z[i] = rotation.z;
+        rotations.w[i] = rotation.w;
+        radii[i]       = 0.1f * (radii[i] + 1.0f);
+    }
+
+    struct Mat4* parents = malloc(count * sizeof(parents[0]));
+    struct Mat4* locals  = malloc(count * sizeof(locals[0]));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        struct Vec3 translation = {points.x[i], points.y[i], points.z[i]};
+        struct Quat rotation = {rotations.x[i], rotations.y[i], rotations.z[i], rotations.w[i]};
+        struct Vec3 scale    = {scales.x[i], scales.y[i], scales.z[i]};
+        parents[i]           = mat4_trs(translation, rotation, scale);
+        locals[i]            = mat4_trs(scale, rotation, translation);
+    }
+    struct Mat4 camera = mat4_trs((struct Vec3){0.5f, -0.25f, 2.0f},
+                                  quat_axis_angle((struct Vec3){0.0f, 1.0f, 0.0f}, 0.5f),
+                                  (struct Vec3){1.0f, 1.0f, 1.0f});
+    float       planes[VECMATH_FRUSTUM_PLANES][4];
+    cull_planes_clip(planes);
+
+    /* results of the path timed and of the scalar one */
+    float*           transformed[2];
+    struct Mat4*     products[2];
+    struct Instance* instances[2];
+    uint8_t*         visible[2];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        transformed[i] = malloc(3 * (size_t) count * sizeof(transformed[i][0]));
+        products[i]    = malloc(count * sizeof(products[i][0]));
+        instances[i]   = calloc(count, sizeof(instances[i][0]));
+        visible[i]     = malloc(count * sizeof(visible[i][0]));
+    }
+
+    const char* kernels[]                     = {"points", "mat4 mul", "trs", "frustum"};
+    double      times[4][VECMATH_PATHS_COUNT] = {};
+    double      errors[4]                     = {};
+    uint32_t    visibleCount                  = 0;
+
+    enum VecmathPath best = vecmath_path();
+    for (uint32_t path = 0; path < VECMATH_PATHS_COUNT; ++path)
+    {
+        if (!vecmath_path_set(path))
+            continue;
+
+        uint32_t       r   = path == VECMATH_SCALAR ? 1 : 0;
+        struct Vec3Soa out = {transformed[r], &transformed[r][count], &transformed[r][2 * count]};
+        for (uint32_t kernel = 0; kernel < 4; ++kernel)
+        {
+            uint64_t start = util_time_ns();
+            for (uint32_t i = 0; i < iterations; ++i)
+            {
+                if (kernel == 0)
+                    vecmath_points_transform(&camera, &points, &out, count);
+                else if (kernel == 1)
+                    vecmath_mat4_mul_batch(parents, locals, products[r], count);
+                else if (kernel == 2)
+                    vecmath_trs_batch(&points,
+                                      &rotations,
+                                      &scales,
+                                      instances[r][0].model,
+                                      sizeof(instances[r][0]),
+                                      count);
+                else
+                    visibleCount =
+                        vecmath_spheres_frustum(planes, &points, radii, visible[r], count);
+            }
+            times[kernel][path] = (double) (util_time_ns() - start) / 1e6 / iterations;
+        }
+        if (path == VECMATH_SCALAR)
+            continue;
+
+        for (size_t i = 0; i < 3 * (size_t) count; ++i)
+            errors[0] = fmax(errors[0], fabs(transformed[0][i] - transformed[1][i]));
+        for (uint32_t i = 0; i < count; ++i)
+            for (uint32_t j = 0; j < 16; ++j)
+            {
+                errors[1] = fmax(errors[1], fabs(products[0][i].m[j] - products[1][i].m[j]));
+                errors[2] =
+                    fmax(errors[2], fabs(instances[0][i].model[j] - instances[1][i].model[j]));
+            }
+        for (uint32_t i = 0; i < count; ++i)
+            errors[3] += visible[0][i] != visible[1][i];
+    }
+    vecmath_path_set(best);
+
+    printf("math %d elements, %d iteration(s), %d visible\n", count, iterations, visibleCount);
+    printf("%-10s", "kernel");
+    for (uint32_t path = 0; path < VECMATH_PATHS_COUNT; ++path)
+        printf(" %7s ms", vecmath_path_name(path));
+    printf(" %8s %10s\n", "speedup", "error");
+    for (uint32_t kernel = 0; kernel < 4; ++kernel)
+    {
+        printf("%-10s", kernels[kernel]);
+        double fastest = times[kernel][VECMATH_SCALAR];
+        for (uint32_t path = 0; path < VECMATH_PATHS_COUNT; ++path)
+        {
+            if (!vecmath_path_supported(path))
+            {
+                printf(" %10s", "-");
+                continue;
+            }
+            printf(" %10.3f", times[kernel][path]);
+            fastest = times[kernel][path] < fastest ? times[kernel][path] : fastest;
+        }
+        printf(" %7.2fx %10g\n", times[kernel][VECMATH_SCALAR] / fastest, errors[kernel]);
+    }
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        free(visible[i]);
+        free(instances[i]);
+        free(products[i]);
+        free(transformed[i]);
+    }
+    free(locals);
+    free(parents);
+    free(data);
+}
+
+/* headless benchmarks *******************************************************/
+/* options->frames frames of record on the frames of bench, see headless_render */
+static void bench_frames(const struct BenchContext* bench,
+                         struct FrameRecord*        record,
+                         uint32_t                   framesInFlight,
+                         FramePrepare               prepare,
+                         void*                      context,
+                         struct FrameStats*         stats)
+{
+    headless_render(bench->device,
+                    bench->graphicsQueue,
+                    bench->frames,
+                    framesInFlight,
+                    bench->imagesCount,
+                    record,
+                    bench->options->frames,
+                    prepare,
+                    context,
+                    stats);
+}
+
+/* a copy of bench->record for a benchmark drawing instances of its own,
+ * frame_record leaves the scene alone */
+static struct FrameRecord bench_record(const struct BenchContext* bench)
+{
+    struct FrameRecord record = *bench->record;
+    record.scene              = NULL;
+    return record;
+}
+
+/* count single instance draws of the triangle, instance i on cell i of
+ * instances_grid in the returned buffer */
+static struct Draw* bench_draws_create(const struct BenchContext* bench,
+                                       uint32_t                   count,
+                                       struct Buffer*             instanceBuffer)
+{
+    struct Instance* instances = malloc(count * sizeof(instances[0]));
+    struct Draw*     draws     = malloc(count * sizeof(draws[0]));
+    instances_grid(instances, count);
+    for (uint32_t i = 0; i < count; ++i)
+        draw_init(&draws[i], bench->triangle, i, 1);
+
+    mesh_instances_upload(instances,
+                          count,
+                          bench->allocator,
+                          bench->commandPool,
+                          bench->graphicsQueue,
+                          instanceBuffer);
+    free(instances);
+    return draws;
+}
+
+/* one vkCmdDrawIndexed per frame, only the instance count grows */
+static void bench_instancing(const struct BenchContext* bench)
+{
+    VkExtent2D extent = bench->record->pass.extent;
+    printf("instancing %s, %d frame(s) per step at %dx%d\n",
+           bench->properties->deviceName,
+           bench->options->frames,
+           extent.width,
+           extent.height);
+    printf("%10s %10s %14s %10s %10s\n",
+           "instances",
+           "frames/s",
+           "instances/s",
+           "p50 ms",
+           "p99 ms");
+
+    for (uint32_t count = 1; count <= 1000000; count *= 10)
+    {
+        struct Instance* instances = malloc(count * sizeof(instances[0]));
+        instances_grid(instances, count);
+
+        struct Buffer benchBuffer;
+        mesh_instances_upload(instances,
+                              count,
+                              bench->allocator,
+                              bench->commandPool,
+                              bench->graphicsQueue,
+                              &benchBuffer);
+        free(instances);
+
+        struct Draw benchDraw;
+        draw_init(&benchDraw, bench->triangle, 0, count);
+
+        struct FrameRecord benchRecord  = bench_record(bench);
+        benchRecord.pass.instanceBuffer = benchBuffer.buffer;
+        benchRecord.pass.draws          = &benchDraw;
+        benchRecord.pass.drawsCount     = 1;
+
+        struct FrameStats stats;
+        bench_frames(bench, &benchRecord, bench->options->framesInFlight, NULL, NULL, &stats);
+
+        printf("%10u %10.1f %14.0f %10.3f %10.3f\n",
+               count,
+               stats.framesPerSecond,
+               stats.framesPerSecond * count,
+               stats.frameTimeP50,
+               stats.frameTimeP99);
+
+        /* headless_render waited for the device */
+        buffer_destroy(bench->allocator, &benchBuffer);
+    }
+}
+
+/* CPU time to record options->draws single instance draws, inline on the
+ * main thread and split over 1, 2, 4, ... threads into secondaries */
+static void bench_recording(const struct BenchContext* bench)
+{
+    const struct Options* options = bench->options;
+
+    struct Buffer benchBuffer;
+    struct Draw*  draws = bench_draws_create(bench, options->draws, &benchBuffer);
+
+    struct FrameRecord benchRecord  = bench_record(bench);
+    benchRecord.pass.instanceBuffer = benchBuffer.buffer;
+    benchRecord.pass.draws          = draws;
+    benchRecord.pass.drawsCount     = options->draws;
+    benchRecord.gpuTimer            = NULL; /* never submitted */
+
+    printf("recording %d draw(s), %d frame(s) per step, %d core(s)\n",
+           options->draws,
+           options->frames,
+           jobs_cpu_count());
+    printf("%10s %10s %10s %14s %10s\n", "threads", "p50 ms", "p99 ms", "draws/ms", "speedup");
+
+    double* recordTimes  = malloc(options->frames * sizeof(recordTimes[0]));
+    double  inlineMedian = 0.0;
+    /* threads 0 is the inline baseline */
+    uint32_t threads = 0;
+    for (;;)
+    {
+        benchRecord.recorder = threads == 0 ? NULL : bench->recorder;
+        benchRecord.jobs     = bench->jobs;
+        benchRecord.threads  = threads;
+
+        /* nothing is submitted, every frame can be reset right away */
+        for (uint32_t frame = 0; frame < options->frames; ++frame)
+        {
+            uint32_t slot  = frame % options->framesInFlight;
+            uint64_t start = util_time_ns();
+            frame_record(bench->device,
+                         &bench->frames[slot],
+                         slot,
+                         frame % bench->imagesCount,
+                         &benchRecord);
+            recordTimes[frame] = (double) (util_time_ns() - start) / 1e6;
+        }
+
+        double p50 = util_percentile(recordTimes, options->frames, 0.50);
+        double p99 = util_percentile(recordTimes, options->frames, 0.99);
+        if (threads == 0)
+            inlineMedian = p50;
+
+        char label[16];
+        snprintf(label, sizeof(label), threads == 0 ? "inline" : "%u", threads);
+        printf("%10s %10.3f %10.3f %14.1f %9.2fx\n",
+               label,
+               p50,
+               p99,
+               (double) options->draws / p50,
+               inlineMedian / p50);
+
+        if (threads == bench->recorder->threadsCount)
+            break;
+        threads = threads == 0 ? 1 : threads * 2;
+        if (threads > bench->recorder->threadsCount)
+            threads = bench->recorder->threadsCount;
+    }
+    free(recordTimes);
+    free(draws);
+
+    buffer_destroy(bench->allocator, &benchBuffer);
+}
+
+/* options->pipelines variants of the pipeline, one draw each, compiled
+ * into an empty cache: all up front on the main thread, then on worker
+ * threads while frames render with the fallback pipeline. the frames run
+ * until the last variant is ready, not through bench_frames */
+static void bench_pipelines(const struct BenchContext* bench)
+{
+    const struct Options*               options      = bench->options;
+    const VkGraphicsPipelineCreateInfo* pipelineInfo = bench->pipelineInfo;
+    VkDevice                            device       = bench->device;
+    uint32_t                            count        = options->pipelines;
+
+    VkCullModeFlags cullModes[] = {VK_CULL_MODE_NONE,
+                                   VK_CULL_MODE_BACK_BIT,
+                                   VK_CULL_MODE_FRONT_BIT,
+                                   VK_CULL_MODE_FRONT_AND_BACK};
+    VkColorComponentFlags writeMasks[] = {
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+            VK_COLOR_COMPONENT_A_BIT,
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT,
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT,
+        VK_COLOR_COMPONENT_R_BIT};
+
+    /* everything the create infos point to lives until the end */
+    VkPipelineRasterizationStateCreateInfo* rasterizers = malloc(count * sizeof(rasterizers[0]));
+    VkPipelineColorBlendAttachmentState*    blendAttachments =
+        malloc(count * sizeof(blendAttachments[0]));
+    VkPipelineColorBlendStateCreateInfo*    blendStates  = malloc(count * sizeof(blendStates[0]));
+    VkGraphicsPipelineCreateInfo*           variantInfos = malloc(count * sizeof(variantInfos[0]));
+    VkPipeline*                             variants     = malloc(count * sizeof(variants[0]));
+    uint32_t*                               handles      = malloc(count * sizeof(handles[0]));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        rasterizers[i]                 = *pipelineInfo->pRasterizationState;
+        rasterizers[i].cullMode        = cullModes[i % 4];
+        rasterizers[i].frontFace       = (i / 4) % 2 ? VK_FRONT_FACE_COUNTER_CLOCKWISE
+                                                     : VK_FRONT_FACE_CLOCKWISE;
+        rasterizers[i].depthBiasEnable = (i / 64) % 2 ? VK_TRUE : VK_FALSE;
+
+        blendAttachments[i]                = pipelineInfo->pColorBlendState->pAttachments[0];
+        blendAttachments[i].blendEnable    = (i / 8) % 2 ? VK_FALSE : VK_TRUE;
+        blendAttachments[i].colorWriteMask = writeMasks[(i / 16) % 4];
+
+        blendStates[i]              = *pipelineInfo->pColorBlendState;
+        blendStates[i].pAttachments = &blendAttachments[i];
+
+        variantInfos[i]                     = *pipelineInfo;
+        variantInfos[i].pRasterizationState = &rasterizers[i];
+        variantInfos[i].pColorBlendState    = &blendStates[i];
+    }
+
+    struct Buffer benchBuffer;
+    struct Draw*  draws = bench_draws_create(bench, count, &benchBuffer);
+
+    struct FrameRecord benchRecord  = bench_record(bench);
+    benchRecord.pass.instanceBuffer = benchBuffer.buffer;
+    benchRecord.pass.draws          = draws;
+    benchRecord.pass.drawsCount     = count;
+    benchRecord.gpuTimer            = NULL;
+
+    VkPipelineCacheCreateInfo emptyCacheInfo = {};
+    emptyCacheInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    printf("pipelines %s, %d variant(s), empty cache, %d core(s)\n",
+           bench->properties->deviceName,
+           count,
+           jobs_cpu_count());
+
+    /* sync: the first frame waits for every pipeline */
+    struct Frame*   frames = bench->frames;
+    VkPipelineCache benchCache;
+    if (vkCreatePipelineCache(device, &emptyCacheInfo, NULL, &benchCache) != VK_SUCCESS)
+    {
+        fprintf(stderr, "pipeline cache create error\n");
+        exit(EXIT_FAILURE);
+    }
+    VkFence  imagesInFlight[SWAPCHAIN_IMAGES_MAX] = {};
+    uint64_t start                                = util_time_ns();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (vkCreateGraphicsPipelines(
+                device, benchCache, 1, &variantInfos[i], NULL, &variants[i]) != VK_SUCCESS)
+        {
+            fprintf(stderr, "pipeline create error\n");
+            exit(EXIT_FAILURE);
+        }
+        draws[i].pipeline = variants[i];
+    }
+    double compiled = (double) (util_time_ns() - start) / 1e6;
+
+    frame_wait(device, &frames[0], NULL);
+    frame_claim_image(device, imagesInFlight, 0, &frames[0]);
+    vkResetFences(device, 1, &frames[0].inFlight);
+    frame_record(device, &frames[0], 0, 0, &benchRecord);
+    frame_submit(bench->graphicsQueue, &frames[0], false);
+    frame_wait(device, &frames[0], NULL);
+    printf("  sync   first frame %10.3f ms (compile %.3f ms)\n",
+           (double) (util_time_ns() - start) / 1e6,
+           compiled);
+
+    vkDeviceWaitIdle(device);
+    for (uint32_t i = 0; i < count; ++i)
+        vkDestroyPipeline(device, variants[i], NULL);
+    vkDestroyPipelineCache(device, benchCache, NULL);
+
+    /* async: frames start right away, draws take the fallback (the main
+     * pipeline) until their variant is ready */
+    if (vkCreatePipelineCache(device, &emptyCacheInfo, NULL, &benchCache) != VK_SUCCESS)
+    {
+        fprintf(stderr, "pipeline cache create error\n");
+        exit(EXIT_FAILURE);
+    }
+    struct Pipelines pipelines;
+    pipelines_init(&pipelines, device, benchCache, jobs_cpu_count(), count);
+    memset(imagesInFlight, 0, sizeof(imagesInFlight));
+
+    start = util_time_ns();
+    for (uint32_t i = 0; i < count; ++i)
+        handles[i] = pipelines_request(&pipelines, &variantInfos[i]);
+
+    uint32_t currentFrame = 0;
+    uint32_t frame        = 0;
+    uint32_t backlog      = count;
+    for (; backlog > 0; ++frame)
+    {
+        struct Frame* benchFrame = &frames[currentFrame];
+        uint32_t      imageIndex = frame % bench->imagesCount;
+        frame_wait(device, benchFrame, NULL);
+        frame_claim_image(device, imagesInFlight, imageIndex, benchFrame);
+        vkResetFences(device, 1, &benchFrame->inFlight);
+
+        /* sampled before resolving, so a frame never shows fewer
+         * pipelines than its backlog claims */
+        backlog = pipelines_backlog(&pipelines);
+        for (uint32_t i = 0; i < count; ++i)
+            draws[i].pipeline = pipelines_get(&pipelines, handles[i]);
+        frame_record(device, benchFrame, currentFrame, imageIndex, &benchRecord);
+        frame_submit(bench->graphicsQueue, benchFrame, false);
+
+        if (frame == 0)
+        {
+            frame_wait(device, benchFrame, NULL);
+            printf("  async  first frame %10.3f ms\n", (double) (util_time_ns() - start) / 1e6);
+        }
+        if ((frame & (frame - 1)) == 0 || backlog == 0)
+            printf("  frame %6u backlog %4u\n", frame, backlog);
+        currentFrame = (currentFrame + 1) % options->framesInFlight;
+    }
+    printf("  async  all ready   %10.3f ms after %u frame(s)\n",
+           (double) (util_time_ns() - start) / 1e6,
+           frame);
+
+    vkDeviceWaitIdle(device);
+    pipelines_destroy(&pipelines);
+    vkDestroyPipelineCache(device, benchCache, NULL);
+
+    free(handles);
+    free(variants);
+    free(variantInfos);
+    free(blendStates);
+    free(blendAttachments);
+    free(rasterizers);
+    free(draws);
+    buffer_destroy(bench->allocator, &benchBuffer);
+}
+
+struct BenchUpload
+{
+    const struct BenchContext* bench;
+    struct Uploader*           uploader; /* NULL: buffer_upload, waits for every copy */
+    const struct Buffer*       targets;
+    const uint8_t*             chunk;
+    uint64_t                   bytes;
+    uint32_t                   deferred;
+};
+
+static void bench_upload_frame(void* context, uint32_t frame, uint32_t slot)
+{
+    struct BenchUpload*        upload = context;
+    const struct BenchContext* bench  = upload->bench;
+    (void) slot;
+
+    if (upload->uploader == NULL)
+    {
+        struct Buffer       streamed;
+        struct BufferUpload bufferUpload = {
+            &streamed, upload->chunk, BENCH_UPLOAD_CHUNK, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT};
+        buffer_upload(bench->allocator, bench->commandPool, bench->graphicsQueue, &bufferUpload, 1);
+        buffer_destroy(bench->allocator, &streamed);
+        upload->bytes += BENCH_UPLOAD_CHUNK;
+    }
+    else if (upload_buffer(upload->uploader,
+                           upload->targets[frame % BENCH_UPLOAD_BUFFERS].buffer,
+                           0,
+                           upload->chunk,
+                           BENCH_UPLOAD_CHUNK) == 0)
+    {
+        /* ring or batches full, a streamer retries next frame */
+        upload->deferred++;
+    }
+}
+
+/* streams BENCH_UPLOAD_CHUNK bytes per frame while rendering, first with
+ * buffer_upload on the graphics queue, which waits for every copy, then
+ * through the staging ring on the transfer queue */
+static void bench_upload(const struct BenchContext* bench)
+{
+    const struct Options* options = bench->options;
+
+    uint8_t* chunk = malloc(BENCH_UPLOAD_CHUNK);
+    for (uint32_t i = 0; i < BENCH_UPLOAD_CHUNK; ++i)
+        chunk[i] = (uint8_t) i;
+
+    struct Buffer targets[BENCH_UPLOAD_BUFFERS];
+    for (uint32_t i = 0; i < BENCH_UPLOAD_BUFFERS; ++i)
+        buffer_create(bench->allocator,
+                      BENCH_UPLOAD_CHUNK,
+                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                      &targets[i]);
+
+    struct Uploader uploader;
+    upload_init(&uploader,
+                bench->allocator,
+                bench->transferQueue,
+                bench->transferFamily,
+                bench->graphicsFamily,
+                UPLOAD_STAGING_SIZE);
+
+    printf("upload %s, %d MiB per frame, %d frame(s), %d MiB staging, transfer family %d\n",
+           bench->properties->deviceName,
+           BENCH_UPLOAD_CHUNK >> 20,
+           options->frames,
+           UPLOAD_STAGING_SIZE >> 20,
+           bench->transferFamily);
+    printf("%-10s %10s %10s %10s %10s %10s\n",
+           "path",
+           "p50 ms",
+           "p99 ms",
+           "max ms",
+           "MiB/s",
+           "deferred");
+
+    const char* modeNames[] = {"blocking", "transfer"};
+    for (uint32_t mode = 0; mode < 2; ++mode)
+    {
+        struct FrameRecord benchRecord = *bench->record;
+        benchRecord.gpuTimer           = NULL;
+        benchRecord.uploader           = mode == 1 ? &uploader : NULL;
+
+        struct BenchUpload upload = {};
+        upload.bench              = bench;
+        upload.uploader           = benchRecord.uploader;
+        upload.targets            = targets;
+        upload.chunk              = chunk;
+        uint64_t bytesDone        = uploader.bytesDone;
+
+        struct FrameStats stats;
+        bench_frames(
+            bench, &benchRecord, options->framesInFlight, bench_upload_frame, &upload, &stats);
+        /* acquired by a frame, copies still in the ring do not count */
+        if (mode == 1)
+            upload.bytes = uploader.bytesDone - bytesDone;
+
+        printf("%-10s %10.3f %10.3f %10.3f %10.1f %10u\n",
+               modeNames[mode],
+               stats.frameTimeP50,
+               stats.frameTimeP99,
+               stats.frameTimeMax,
+               (double) upload.bytes / (1 << 20) / stats.seconds,
+               upload.deferred);
+    }
+
+    upload_destroy(&uploader);
+    for (uint32_t i = 0; i < BENCH_UPLOAD_BUFFERS; ++i)
+        buffer_destroy(bench->allocator, &targets[i]);
+    free(chunk);
+}
+
+struct BenchCulling
+{
+    float                  planes[CULL_PLANES][4];
+    const struct Instance* instances;
+    const uint32_t*        objectMeshes;
+    const float*           radii;
+    uint32_t               count;
+    struct FrameRecord*    record;
+    struct Draw*           draws; /* NULL: the cull pass, nothing to do on the CPU */
+    double*                cullTimes;
+};
+
+static void bench_culling_frame(void* context, uint32_t frame, uint32_t slot)
+{
+    struct BenchCulling* culling = context;
+    (void) slot;
+
+    uint64_t start = util_time_ns();
+    if (culling->draws != NULL)
+        culling->record->pass.drawsCount = cull_cpu(culling->planes,
+                                                    culling->instances,
+                                                    culling->objectMeshes,
+                                                    culling->radii,
+                                                    culling->count,
+                                                    culling->draws);
+    culling->cullTimes[frame] = (double) (util_time_ns() - start) / 1e6;
+}
+
+/* 10k to 1M single instance objects on a grid BENCH_CULLING_SPREAD times
+ * the size of the view. cpu: cull_cpu rebuilds the draw list every frame,
+ * which is then recorded draw by draw. gpu: the cull pass writes the
+ * draws, recording is the same few commands at any count */
+static void bench_culling(const struct BenchContext* bench)
+{
+    const struct Options* options = bench->options;
+
+    printf("culling %s, %d frame(s) per step\n", bench->properties->deviceName, options->frames);
+    printf("%-5s %10s %10s %10s %10s %10s %10s\n",
+           "path",
+           "objects",
+           "visible",
+           "cull ms",
+           "record ms",
+           "p50 ms",
+           "p99 ms");
+
+    double*     cullTimes   = malloc(options->frames * sizeof(cullTimes[0]));
+    const char* modeNames[] = {"cpu", "gpu"};
+    for (uint32_t count = 10000; count <= 1000000; count *= 10)
+    {
+        struct Instance* instances    = malloc(count * sizeof(instances[0]));
+        uint32_t*        objectMeshes = malloc(count * sizeof(objectMeshes[0]));
+        struct Draw*     draws        = malloc(count * sizeof(draws[0]));
+        instances_grid(instances, count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            /* uniform scale, the sphere takes the largest axis */
+            instances[i].model[10] = instances[i].model[0];
+            instances[i].model[12] *= BENCH_CULLING_SPREAD;
+            instances[i].model[13] *= BENCH_CULLING_SPREAD;
+            objectMeshes[i] = bench->triangle;
+        }
+
+        struct Buffer benchBuffer;
+        mesh_instances_upload(instances,
+                              count,
+                              bench->allocator,
+                              bench->commandPool,
+                              bench->graphicsQueue,
+                              &benchBuffer);
+        if (bench->cull != NULL)
+            cull_scene(bench->cull,
+                       bench->commandPool,
+                       bench->graphicsQueue,
+                       bench->record->pass.meshes,
+                       bench->meshRadii,
+                       bench->meshesCount,
+                       objectMeshes,
+                       benchBuffer.buffer,
+                       count);
+
+        for (uint32_t mode = 0; mode < (bench->cull != NULL ? 2u : 1u); ++mode)
+        {
+            struct FrameRecord benchRecord  = bench_record(bench);
+            benchRecord.gpuTimer            = NULL;
+            benchRecord.pass.instanceBuffer = benchBuffer.buffer;
+            benchRecord.pass.draws          = draws;
+            benchRecord.pass.drawsCount     = 0;
+            benchRecord.pass.cull           = mode == 1 ? bench->cull : NULL;
+
+            struct BenchCulling culling = {};
+            cull_planes_clip(culling.planes);
+            culling.instances           = instances;
+            culling.objectMeshes        = objectMeshes;
+            culling.radii               = bench->meshRadii;
+            culling.count               = count;
+            culling.record              = &benchRecord;
+            culling.draws               = mode == 0 ? draws : NULL;
+            culling.cullTimes           = cullTimes;
+
+            struct FrameStats stats;
+            bench_frames(bench,
+                         &benchRecord,
+                         options->framesInFlight,
+                         bench_culling_frame,
+                         &culling,
+                         &stats);
+
+            /* the slot of the last frame, every fence has signalled */
+            uint32_t lastSlot = (options->frames - 1) % options->framesInFlight;
+            printf("%-5s %10u %10u %10.3f %10.3f %10.3f %10.3f\n",
+                   modeNames[mode],
+                   count,
+                   mode == 0 ? benchRecord.pass.drawsCount : cull_visible(bench->cull, lastSlot),
+                   util_percentile(cullTimes, options->frames, 0.50),
+                   stats.recordTimeP50,
+                   stats.frameTimeP50,
+                   stats.frameTimeP99);
+        }
+
+        buffer_destroy(bench->allocator, &benchBuffer);
+        free(draws);
+        free(objectMeshes);
+        free(instances);
+    }
+    free(cullTimes);
+}
+
+struct BenchTextures
+{
+    struct TextureStreamer* streamer;
+    struct Draw*            draw;
+    uint32_t                frames;
+    uint64_t                start;
+    uint32_t                allTails; /* first frame with every texture in use at a tail */
+    double                  allTailsTime;
+};
+
+static void bench_textures_frame(void* context, uint32_t frame, uint32_t slot)
+{
+    struct BenchTextures*   textures = context;
+    struct TextureStreamer* streamer = textures->streamer;
+
+    texture_streamer_frame(streamer);
+    uint32_t first    = frame / BENCH_TEXTURES_STEP;
+    uint32_t missing  = 0;
+    uint32_t coarsest = 0;
+    uint32_t finest   = TEXTURE_NONE;
+    for (uint32_t w = 0; w < BENCH_TEXTURES_WINDOW; ++w)
+    {
+        uint32_t texture = (first + w) % BENCH_TEXTURES;
+        texture_use(streamer, texture);
+        /* a renderer binds it or its fallback here */
+        if (texture_descriptor(streamer, texture, slot) == VK_NULL_HANDLE)
+        {
+            missing++;
+            continue;
+        }
+        uint32_t mip = texture_resident_mip(streamer, texture);
+        coarsest     = mip > coarsest ? mip : coarsest;
+        finest       = mip < finest ? mip : finest;
+    }
+    textures->draw->constants.texture = texture_bindless_index(streamer, first % BENCH_TEXTURES);
+    if (missing == 0 && textures->allTails == UINT32_MAX)
+    {
+        textures->allTails     = frame;
+        textures->allTailsTime = (double) (util_time_ns() - textures->start) / 1e6;
+    }
+
+    if ((frame & (frame + 1)) == 0 || frame + 1 == textures->frames)
+        printf("%-8u %8u %8d %8d %12.1f %10u\n",
+               frame,
+               missing,
+               missing == BENCH_TEXTURES_WINDOW ? -1 : (int) coarsest,
+               missing == BENCH_TEXTURES_WINDOW ? -1 : (int) finest,
+               (double) streamer->stats.resident / (1 << 20),
+               streamer->stats.evictions);
+}
+
+/* BENCH_TEXTURES procedural textures, of which a window of
+ * BENCH_TEXTURES_WINDOW is used every frame, moving by one every
+ * BENCH_TEXTURES_STEP frames. the streamer keeps them under
+ * --texture-budget: tails first, finer mips while the budget allows,
+ * least recently used textures evicted as the window moves on */
+static void bench_textures(const struct BenchContext* bench)
+{
+    const struct Options* options = bench->options;
+
+    struct Uploader uploader;
+    upload_init(&uploader,
+                bench->allocator,
+                bench->transferQueue,
+                bench->transferFamily,
+                bench->graphicsFamily,
+                UPLOAD_STAGING_SIZE);
+
+    struct TextureStreamer streamer;
+    texture_streamer_init(&streamer,
+                          bench->allocator,
+                          &uploader,
+                          bench->bindless,
+                          (VkDeviceSize) options->textureBudget << 20,
+                          BENCH_TEXTURES,
+                          options->framesInFlight);
+
+    uint64_t start  = util_time_ns();
+    uint8_t* texels = malloc(BENCH_TEXTURES_SIZE * BENCH_TEXTURES_SIZE * TEXTURE_TEXEL_SIZE);
+    for (uint32_t t = 0; t < BENCH_TEXTURES; ++t)
+    {
+        /* checkers in a color of their own */
+        for (uint32_t y = 0; y < BENCH_TEXTURES_SIZE; ++y)
+        {
+            for (uint32_t x = 0; x < BENCH_TEXTURES_SIZE; ++x)
+            {
+                uint8_t* texel = &texels[(y * BENCH_TEXTURES_SIZE + x) * TEXTURE_TEXEL_SIZE];
+                bool     dark  = ((x >> 5) ^ (y >> 5)) & 1;
+                texel[0]       = dark ? 32 : (uint8_t) (t * 37);
+                texel[1]       = dark ? 32 : (uint8_t) (t * 91);
+                texel[2]       = dark ? 32 : (uint8_t) (t * 53);
+                texel[3]       = 255;
+            }
+        }
+        texture_create(&streamer, texels, BENCH_TEXTURES_SIZE, BENCH_TEXTURES_SIZE, 1);
+    }
+    free(texels);
+    VkDeviceSize chainBytes = streamer.textures[0].mipOffsets[streamer.textures[0].mipsCount];
+
+    printf("textures %s, %d of %dx%d (%.1f MiB with mips), %d in use, budget %u MiB\n",
+           bench->properties->deviceName,
+           BENCH_TEXTURES,
+           BENCH_TEXTURES_SIZE,
+           BENCH_TEXTURES_SIZE,
+           (double) (chainBytes * BENCH_TEXTURES) / (1 << 20),
+           BENCH_TEXTURES_WINDOW,
+           options->textureBudget);
+    printf("  mip chains built   %10.3f ms\n", (double) (util_time_ns() - start) / 1e6);
+    printf("%-8s %8s %8s %8s %12s %10s\n",
+           "frame",
+           "missing",
+           "coarsest",
+           "finest",
+           "resident MiB",
+           "evictions");
+
+    /* one full size triangle drawn with the first texture of the window */
+    struct Buffer      benchBuffer;
+    struct Draw*       textureDraw  = bench_draws_create(bench, 1, &benchBuffer);
+    struct FrameRecord benchRecord  = bench_record(bench);
+    benchRecord.gpuTimer            = NULL;
+    benchRecord.uploader            = &uploader;
+    benchRecord.pass.instanceBuffer = benchBuffer.buffer;
+    benchRecord.pass.draws          = textureDraw;
+    benchRecord.pass.drawsCount     = 1;
+
+    struct BenchTextures textures = {};
+    textures.streamer             = &streamer;
+    textures.draw                 = textureDraw;
+    textures.frames               = options->frames;
+    textures.start                = util_time_ns();
+    textures.allTails             = UINT32_MAX;
+
+    struct FrameStats stats;
+    bench_frames(
+        bench, &benchRecord, options->framesInFlight, bench_textures_frame, &textures, &stats);
+
+    if (textures.allTails != UINT32_MAX)
+        printf("  all in use at a tail after %u frame(s), %.3f ms\n",
+               textures.allTails,
+               textures.allTailsTime);
+    printf("  frame p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           stats.frameTimeP50,
+           stats.frameTimeP99,
+           stats.frameTimeMax);
+    printf("  uploaded %.1f MiB in %u upload(s), %u deferred, peak %.1f MiB resident\n",
+           (double) streamer.stats.uploadedBytes / (1 << 20),
+           streamer.stats.uploads,
+           streamer.stats.deferred,
+           (double) streamer.stats.residentPeak / (1 << 20));
+
+    free(textureDraw);
+    buffer_destroy(bench->allocator, &benchBuffer);
+    texture_streamer_destroy(&streamer);
+    upload_destroy(&uploader);
+}
+
+struct BenchDrawData
+{
+    struct UniformRing*       ring; /* NULL: nothing written per frame */
+    const struct DrawPayload* payloads;
+    uint32_t*                 uniformOffsets;
+    uint32_t                  count;
+    double*                   writeTimes;
+};
+
+static void bench_draw_data_frame(void* context, uint32_t frame, uint32_t slot)
+{
+    struct BenchDrawData* drawData = context;
+
+    uint64_t start = util_time_ns();
+    if (drawData->ring != NULL)
+    {
+        uniform_ring_frame_begin(drawData->ring, slot);
+        for (uint32_t d = 0; d < drawData->count; ++d)
+            if (!uniform_ring_write(drawData->ring,
+                                    drawData->payloads[d].transform,
+                                    sizeof(drawData->payloads[d].transform),
+                                    &drawData->uniformOffsets[d]))
+            {
+                fprintf(stderr, "uniform ring full\n");
+                exit(EXIT_FAILURE);
+            }
+        uniform_ring_frame_end(drawData->ring);
+    }
+    drawData->writeTimes[frame] = (double) (util_time_ns() - start) / 1e6;
+}
+
+/* BENCH_DRAW_DATA_DRAWS draws with a transform of their own, handed to the
+ * vertex shader three ways: pushed with every draw, copied into the
+ * uniform ring and bound at a dynamic offset per draw, or read from a
+ * storage buffer by instance index with nothing per draw. one frame is in
+ * flight, so a frame's time holds the writes, recording and GPU */
+static void bench_draw_data(const struct BenchContext* bench)
+{
+    const struct Options* options  = bench->options;
+    VkDevice              device   = bench->device;
+    struct Bindless*      bindless = bench->bindless;
+
+    uint32_t            count          = BENCH_DRAW_DATA_DRAWS;
+    struct DrawPayload* payloads       = malloc(count * sizeof(payloads[0]));
+    uint32_t*           uniformOffsets = malloc(count * sizeof(uniformOffsets[0]));
+    float*              transforms     = malloc(count * sizeof(payloads[0].transform));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        /* a scale of its own, so no two payloads are the same */
+        float scale = 0.5f + 0.5f * (float) (i % 64) / 64.0f;
+        payloads[i] = (struct DrawPayload){};
+        for (uint32_t j = 0; j < 3; ++j)
+            payloads[i].transform[j * 5] = scale;
+        payloads[i].transform[15] = 1.0f;
+        memcpy(&transforms[i * 16], payloads[i].transform, sizeof(payloads[i].transform));
+    }
+
+    struct Buffer benchBuffer;
+    struct Draw*  draws = bench_draws_create(bench, count, &benchBuffer);
+
+    struct Buffer       transformBuffer;
+    VkDeviceSize        transformsSize  = count * sizeof(payloads[0].transform);
+    struct BufferUpload transformUpload = {
+        &transformBuffer, transforms, transformsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+    buffer_upload(bench->allocator, bench->commandPool, bench->graphicsQueue, &transformUpload, 1);
+    free(transforms);
+    uint32_t transformsIndex =
+        bindless_buffer_add(bindless, transformBuffer.buffer, 0, transformsSize);
+
+    /* every draw's offset is aligned, 256 bytes at most */
+    struct UniformRing drawRing;
+    uniform_ring_init(&drawRing, bench->allocator, &bench->properties->limits, count * 256);
+
+    /* the storage variant of the pipeline */
+    uint32_t storageSpecializationData[] = {bindless->features.buffersCount,
+                                            RECORDER_TRANSFORM_STORAGE};
+    VkPipelineShaderStageCreateInfo storageStages[] = {bench->pipelineInfo->pStages[0],
+                                                       bench->pipelineInfo->pStages[1]};
+
+    VkSpecializationInfo storageSpecialization = *storageStages[0].pSpecializationInfo;
+    storageSpecialization.pData                = storageSpecializationData;
+    storageStages[0].pSpecializationInfo       = &storageSpecialization;
+
+    VkGraphicsPipelineCreateInfo storageInfo = *bench->pipelineInfo;
+    storageInfo.pStages                      = storageStages;
+
+    VkPipeline storagePipeline;
+    if (vkCreateGraphicsPipelines(
+            device, bench->pipelineCache, 1, &storageInfo, NULL, &storagePipeline) != VK_SUCCESS)
+    {
+        fprintf(stderr, "pipeline create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("draw data %s, %d draws of a %d byte transform, %d frame(s)\n",
+           bench->properties->deviceName,
+           count,
+           (int) sizeof(payloads[0].transform),
+           options->frames);
+    printf("%-8s %10s %10s %10s %10s %12s\n",
+           "source",
+           "write ms",
+           "record ms",
+           "frame ms",
+           "ns/draw",
+           "bytes/frame");
+
+    const char* sources[]  = {"push", "uniform", "storage"};
+    double*     writeTimes = malloc(options->frames * sizeof(writeTimes[0]));
+    for (uint32_t source = 0; source < 3; ++source)
+    {
+        struct FrameRecord benchRecord  = bench_record(bench);
+        benchRecord.pass.instanceBuffer = benchBuffer.buffer;
+        benchRecord.pass.draws          = draws;
+        benchRecord.pass.drawsCount     = count;
+        benchRecord.gpuTimer            = NULL;
+
+        struct BenchDrawData drawData = {};
+        drawData.payloads             = payloads;
+        drawData.uniformOffsets       = uniformOffsets;
+        drawData.count                = count;
+        drawData.writeTimes           = writeTimes;
+
+        VkDeviceSize bytes = 0;
+        if (source == 0)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                draws[i].payload = &payloads[i];
+            bytes = count * sizeof(payloads[0]);
+        }
+        else if (source == 1)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                draws[i].payload = NULL;
+            /* set 1 holds the draw's transform instead of the camera */
+            benchRecord.uniforms            = NULL;
+            benchRecord.pass.uniformSet     = drawRing.set;
+            benchRecord.pass.uniformOffsets = uniformOffsets;
+            drawData.ring                   = &drawRing;
+        }
+        else
+        {
+            if (transformsIndex == BINDLESS_DEFAULT)
+            {
+                printf("%-8s no room in the bindless buffer array\n", sources[source]);
+                continue;
+            }
+            benchRecord.pass.pipeline           = storagePipeline;
+            benchRecord.pass.payload.object     = 0;
+            benchRecord.pass.payload.transforms = transformsIndex;
+        }
+
+        struct FrameStats stats;
+        bench_frames(bench, &benchRecord, 1, bench_draw_data_frame, &drawData, &stats);
+        if (source == 1)
+            bytes = drawRing.frameBytes;
+
+        printf("%-8s %10.3f %10.3f %10.3f %10.1f %12llu\n",
+               sources[source],
+               util_percentile(writeTimes, options->frames, 0.50),
+               stats.recordTimeP50,
+               stats.frameTimeP50,
+               stats.frameTimeP50 * 1e6 / count,
+               (unsigned long long) bytes);
+    }
+    free(writeTimes);
+
+    vkDestroyPipeline(device, storagePipeline, NULL);
+    uniform_ring_destroy(&drawRing, bench->allocator);
+    bindless_buffer_remove(bindless, transformsIndex);
+    buffer_destroy(bench->allocator, &transformBuffer);
+    buffer_destroy(bench->allocator, &benchBuffer);
+    free(uniformOffsets);
+    free(payloads);
+    free(draws);
+}
+
+/* one heap object per entity, reached through a pointer each, as the
+ * baseline of bench_scene */
+struct BenchObject
+{
+    struct Vec3 position;
+    struct Quat rotation;
+    struct Vec3 scale;
+    struct Vec3 velocity;
+    struct Vec3 spin;
+    uint32_t    mesh;
+    float       color[4];
+};
+
+struct BenchScene
+{
+    struct Scene*        scene;
+    struct BenchObject** objects; /* NULL: the scene systems */
+    uint32_t             count;
+    struct SceneFrames*  frames;
+    struct FrameRecord*  record;
+    float                seconds;
+    double               times[3]; /* motion, write and draws, ms summed over the frames */
+};
+
+/* one frame of motion, instances and draws. the instances go straight
+ * into the mapped buffer of slot, which the frame then draws from */
+static void bench_scene_frame(void* context, uint32_t frame, uint32_t slot)
+{
+    struct BenchScene*  sceneBench = context;
+    struct SceneFrames* frames     = sceneBench->frames;
+    struct Instance*    instances  = frames->buffers[slot].allocation.mapped;
+    float               seconds    = sceneBench->seconds;
+    (void) frame;
+
+    uint64_t start   = util_time_ns();
+    uint64_t moved   = start;
+    uint64_t written = start;
+    if (sceneBench->objects == NULL)
+    {
+        scene_motion_update(sceneBench->scene, seconds);
+        moved = util_time_ns();
+        scene_instances_write(sceneBench->scene, instances);
+        written            = util_time_ns();
+        frames->drawsCount = scene_draws_build(sceneBench->scene, frames->draws);
+    }
+    else
+    {
+        struct BenchObject** objects = sceneBench->objects;
+        for (uint32_t i = 0; i < sceneBench->count; ++i)
+        {
+            struct BenchObject* object = objects[i];
+
+            object->position = vec3_add(object->position, vec3_scale(object->velocity, seconds));
+            struct Vec3 w    = vec3_scale(object->spin, 0.5f * seconds);
+            struct Quat q    = object->rotation;
+            struct Quat d    = quat_mul((struct Quat){w.x, w.y, w.z, 0.0f}, q);
+            object->rotation =
+                quat_normalize((struct Quat){q.x + d.x, q.y + d.y, q.z + d.z, q.w + d.w});
+        }
+        moved = util_time_ns();
+        for (uint32_t i = 0; i < sceneBench->count; ++i)
+        {
+            const struct BenchObject* object = objects[i];
+
+            struct Mat4 model = mat4_trs(object->position, object->rotation, object->scale);
+            memcpy(instances[i].model, model.m, sizeof(model.m));
+            memcpy(instances[i].color, object->color, sizeof(object->color));
+        }
+        written            = util_time_ns();
+        frames->drawsCount = 0;
+        for (uint32_t i = 0; i < sceneBench->count; ++i)
+        {
+            struct Draw* last = frames->drawsCount > 0 ? &frames->draws[frames->drawsCount - 1]
+                                                       : NULL;
+            if (last != NULL && last->mesh == objects[i]->mesh)
+            {
+                ++last->instancesCount;
+                continue;
+            }
+            draw_init(&frames->draws[frames->drawsCount++], objects[i]->mesh, i, 1);
+        }
+    }
+    uint64_t built = util_time_ns();
+
+    sceneBench->times[0] += (double) (moved - start) / 1e6;
+    sceneBench->times[1] += (double) (written - moved) / 1e6;
+    sceneBench->times[2] += (double) (built - written) / 1e6;
+
+    sceneBench->record->pass.instanceBuffer = frames->buffers[slot].buffer;
+    sceneBench->record->pass.draws          = frames->draws;
+    sceneBench->record->pass.drawsCount     = frames->drawsCount;
+}
+
+/* BENCH_SCENE_ENTITIES entities with a transform and a render component,
+ * every other one moving, drawn every frame: the motion system, the
+ * instances written into the mapped instance buffer of the frame slot
+ * and the draw list. a tenth of them is destroyed and created again
+ * first, so the pools are out of order until scene_order. the same work
+ * on objects allocated one by one and visited through shuffled pointers
+ * is the baseline */
+static void bench_scene(const struct BenchContext* bench)
+{
+    const struct Options* options = bench->options;
+    uint32_t              count   = BENCH_SCENE_ENTITIES;
+
+    struct Scene scene;
+    scene_init(&scene, count);
+    uint32_t* entities = malloc(count * sizeof(entities[0]));
+
+    uint32_t seed     = 1;
+    float    color[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        seed              = seed * 1664525u + 1013904223u;
+        float       angle = (float) (seed >> 8) / (float) (1u << 24) * 6.2831853f;
+        struct Vec3 axis  = {0.0f, 1.0f, 0.0f};
+        struct Vec3 cell  = {(float) (i % 1024) / 512.0f - 1.0f,
+                            (float) (i / 1024 % 1024) / 512.0f - 1.0f,
+                            0.5f};
+
+        entities[i] = scene_entity_create(&scene);
+        scene_transform_add(&scene,
+                            entities[i],
+                            cell,
+                            quat_axis_angle(axis, angle),
+                            (struct Vec3){0.001f, 0.001f, 0.001f});
+        scene_render_add(&scene, entities[i], i / 256 % bench->meshesCount, color, 0.001f);
+        if (i % 2 == 0)
+            scene_motion_add(&scene, entities[i], (struct Vec3){0.01f, 0.0f, 0.0f}, axis);
+    }
+
+    /* churn: removals move the last slots into the holes */
+    uint32_t churned = 0;
+    for (uint32_t i = 0; i < count; i += 10)
+    {
+        uint32_t stale = entities[i];
+        scene_entity_destroy(&scene, stale);
+        entities[i] = scene_entity_create(&scene);
+        if (scene_entity_alive(&scene, stale))
+        {
+            fprintf(stderr, "stale entity still alive\n");
+            exit(EXIT_FAILURE);
+        }
+        float       churnColor[4] = {1.0f, 0.5f, 0.5f, 1.0f};
+        struct Vec3 spin          = {0.0f, 0.0f, 1.0f};
+        scene_transform_add(&scene,
+                            entities[i],
+                            (struct Vec3){0.0f, 0.0f, 0.5f},
+                            quat_identity(),
+                            (struct Vec3){0.001f, 0.001f, 0.001f});
+        scene_render_add(&scene, entities[i], 0, churnColor, 0.001f);
+        scene_motion_add(&scene, entities[i], (struct Vec3){0.0f, 0.01f, 0.0f}, spin);
+        ++churned;
+    }
+
+    struct SceneFrames frames;
+    scene_frames_init(&frames, bench->allocator, count, options->framesInFlight);
+
+    struct FrameRecord benchRecord = bench_record(bench);
+    benchRecord.gpuTimer           = NULL;
+
+    struct BenchScene sceneBench = {};
+    sceneBench.scene             = &scene;
+    sceneBench.count             = count;
+    sceneBench.frames            = &frames;
+    sceneBench.record            = &benchRecord;
+    sceneBench.seconds           = 1.0f / 60.0f;
+
+    printf("scene %s, %d entities, %d churned, %d moving, %d frame(s), math %s\n",
+           bench->properties->deviceName,
+           scene.aliveCount,
+           churned,
+           scene.pools[SCENE_MOTION].count,
+           options->frames,
+           vecmath_path_name(vecmath_path()));
+    printf("%-10s %10s %10s %10s %10s %10s %10s %8s\n",
+           "storage",
+           "order ms",
+           "motion ms",
+           "write ms",
+           "draws ms",
+           "cpu ms",
+           "frame ms",
+           "draws");
+
+    struct FrameStats stats;
+    for (uint32_t ordered = 0; ordered < 2; ++ordered)
+    {
+        double orderTime = 0.0;
+        if (ordered)
+        {
+            uint64_t start = util_time_ns();
+            scene_order(&scene);
+            orderTime = (double) (util_time_ns() - start) / 1e6;
+        }
+
+        memset(sceneBench.times, 0, sizeof(sceneBench.times));
+        bench_frames(
+            bench, &benchRecord, options->framesInFlight, bench_scene_frame, &sceneBench, &stats);
+
+        double* times = sceneBench.times;
+        printf("%-10s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %8d\n",
+               ordered ? "soa" : "soa churn",
+               orderTime,
+               times[0] / options->frames,
+               times[1] / options->frames,
+               times[2] / options->frames,
+               (times[0] + times[1] + times[2]) / options->frames,
+               stats.frameTimeP50,
+               frames.drawsCount);
+    }
+
+    /* the baseline, visited in a shuffled order */
+    struct BenchObject** objects    = malloc(count * sizeof(objects[0]));
+    struct Vec3Soa       positions  = scene.positions;
+    struct QuatSoa       rotations  = scene.rotations;
+    struct Vec3Soa       scales     = scene.scales;
+    struct Vec3Soa       velocities = scene.velocities;
+    struct Vec3Soa       spins      = scene.spins;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t            t      = scene_slot(&scene, SCENE_TRANSFORM, entities[i]);
+        uint32_t            r      = scene_slot(&scene, SCENE_RENDER, entities[i]);
+        uint32_t            m      = scene_slot(&scene, SCENE_MOTION, entities[i]);
+        struct BenchObject* object = calloc(1, sizeof(*object));
+
+        object->position = (struct Vec3){positions.x[t], positions.y[t], positions.z[t]};
+        object->rotation =
+            (struct Quat){rotations.x[t], rotations.y[t], rotations.z[t], rotations.w[t]};
+        object->scale    = (struct Vec3){scales.x[t], scales.y[t], scales.z[t]};
+        object->mesh     = scene.meshes[r];
+        for (uint32_t c = 0; c < 4; ++c)
+            object->color[c] = scene.colors[c][r];
+        if (m != SCENE_NONE)
+        {
+            object->velocity = (struct Vec3){velocities.x[m], velocities.y[m], velocities.z[m]};
+            object->spin     = (struct Vec3){spins.x[m], spins.y[m], spins.z[m]};
+        }
+        objects[i] = object;
+    }
+    for (uint32_t i = count - 1; i > 0; --i)
+    {
+        seed                       = seed * 1664525u + 1013904223u;
+        uint32_t            j      = (seed >> 8) % (i + 1);
+        struct BenchObject* object = objects[i];
+        objects[i]                 = objects[j];
+        objects[j]                 = object;
+    }
+
+    sceneBench.objects = objects;
+    memset(sceneBench.times, 0, sizeof(sceneBench.times));
+    bench_frames(
+        bench, &benchRecord, options->framesInFlight, bench_scene_frame, &sceneBench, &stats);
+
+    double* times = sceneBench.times;
+    printf("%-10s %10s %10.3f %10.3f %10.3f %10.3f %10.3f %8d\n",
+           "pointers",
+           "-",
+           times[0] / options->frames,
+           times[1] / options->frames,
+           times[2] / options->frames,
+           (times[0] + times[1] + times[2]) / options->frames,
+           stats.frameTimeP50,
+           frames.drawsCount);
+
+    for (uint32_t i = 0; i < count; ++i)
+        free(objects[i]);
+    free(objects);
+    scene_frames_destroy(&frames, bench->allocator);
+    free(entities);
+    scene_destroy(&scene);
+}
+
+void bench_run(const struct BenchContext* bench)
+{
+    const struct Options* options = bench->options;
+    if (options->benchInstancing)
+        bench_instancing(bench);
+    if (options->benchRecording)
+        bench_recording(bench);
+    if (options->benchPipelines)
+        bench_pipelines(bench);
+    if (options->benchUpload)
+        bench_upload(bench);
+    if (options->benchCulling)
+        bench_culling(bench);
+    if (options->benchTextures)
+        bench_textures(bench);
+    if (options->benchDrawData)
+        bench_draw_data(bench);
+    if (options->benchScene)
+        bench_scene(bench);
+}
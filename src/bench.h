@@ -0,0 +1,83 @@
+#pragma once
+
+#include "allocator.h"
+#include "bindless.h"
+#include "cull.h"
+#include "frame.h"
+#include "jobs.h"
+#include "main.h"
+#include "mesh.h"
+#include "recorder.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+struct FrameStats
+{
+    double seconds;
+    double framesPerSecond;
+    double frameTimeP50;  /* ms */
+    double frameTimeP99;  /* ms */
+    double frameTimeMax;  /* ms */
+    double recordTimeP50; /* ms, CPU time in frame_record */
+    double latencyP50;    /* ms, CPU submit until the frame's fence is seen signaled */
+    double latencyP99;    /* ms */
+};
+
+/* runs before headless_render records frame number frame in frame slot
+ * slot, once the slot is free: what a benchmark changes per frame */
+typedef void (*FramePrepare)(void* context, uint32_t frame, uint32_t slot);
+
+/* main's device and scene, which the headless benchmarks render with. a
+ * benchmark copies record and changes what it measures, record->scene is
+ * drawn unless the copy drops it */
+struct BenchContext
+{
+    const struct Options*               options;
+    VkDevice                            device;
+    const VkPhysicalDeviceProperties*   properties;
+    VkQueue                             graphicsQueue;
+    uint32_t                            graphicsFamily;
+    VkQueue                             transferQueue;
+    uint32_t                            transferFamily;
+    struct Allocator*                   allocator;
+    VkCommandPool                       commandPool;
+    VkPipelineCache                     pipelineCache;
+    const VkGraphicsPipelineCreateInfo* pipelineInfo; /* of record's pipeline */
+    struct Frame*                       frames;       /* options->framesInFlight are used */
+    uint32_t                            imagesCount;
+    const struct FrameRecord*           record;
+    struct Bindless*                    bindless;
+    struct Recorder*                    recorder; /* threadsCount 0: none */
+    struct Jobs*                        jobs;
+    struct Cull*                        cull;     /* NULL: no cull pass on this device */
+    uint32_t                            triangle; /* mesh of the benchmark draws */
+    const float*                        meshRadii;
+    uint32_t                            meshesCount;
+};
+
+/* count instances on a square grid covering the viewport, scaled to fit a cell */
+void instances_grid(struct Instance* instances, uint32_t count);
+
+/* records and submits count frames without acquire/present, the offscreen
+ * images are used round robin. once the pipeline is full this is paced by
+ * the GPU. prepare may be NULL */
+void headless_render(VkDevice            device,
+                     VkQueue             queue,
+                     struct Frame*       frames,
+                     uint32_t            framesInFlight,
+                     uint32_t            imagesCount,
+                     struct FrameRecord* record,
+                     uint32_t            count,
+                     FramePrepare        prepare,
+                     void*               context,
+                     struct FrameStats*  stats);
+
+/* times the vecmath batch kernels on count elements, iterations times, on
+ * every path the CPU supports. CPU only */
+void bench_math(uint32_t count, uint32_t iterations);
+
+/* runs the headless benchmarks bench->options asks for, one after the
+ * other. the device is idle before and after each */
+void bench_run(const struct BenchContext* bench);
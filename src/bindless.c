@@ -0,0 +1,509 @@
+#include "bindless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* bindless_alloc(size_t size)
+{
+    void* memory = calloc(1, size > 0 ? size : 1);
+    if (memory == NULL)
+    {
+        fprintf(stderr, "bindless out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static uint32_t bindless_clamp(uint32_t count, uint32_t max)
+{
+    if (count < 1)
+        return 1;
+    return count < max ? count : max;
+}
+
+static uint32_t bindless_min(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+void bindless_features(struct BindlessFeatures*        features,
+                       bool                            indexing,
+                       const VkPhysicalDeviceFeatures* enabled,
+                       const VkPhysicalDeviceLimits*   limits)
+{
+    *features               = (struct BindlessFeatures){};
+    features->indexing      = indexing;
+    features->texturesCount = 1;
+    features->buffersCount  = 1;
+    if (enabled->shaderSampledImageArrayDynamicIndexing)
+        features->texturesCount =
+            bindless_min(bindless_min(limits->maxPerStageDescriptorSamplers,
+                                      limits->maxPerStageDescriptorSampledImages),
+                         bindless_min(limits->maxDescriptorSetSamplers,
+                                      limits->maxDescriptorSetSampledImages));
+    if (enabled->shaderStorageBufferArrayDynamicIndexing)
+        features->buffersCount = bindless_min(limits->maxPerStageDescriptorStorageBuffers,
+                                              limits->maxDescriptorSetStorageBuffers);
+}
+
+void bindless_init(struct Bindless*               bindless,
+                   VkDevice                       device,
+                   const struct BindlessFeatures* features,
+                   uint32_t                       framesInFlight)
+{
+    if (framesInFlight < 1 || framesInFlight > BINDLESS_SLOTS_MAX)
+    {
+        fprintf(stderr, "bindless frames in flight must be 1 to %d\n", BINDLESS_SLOTS_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    *bindless                        = (struct Bindless){};
+    bindless->device                 = device;
+    bindless->features               = *features;
+    bindless->features.texturesCount = bindless_clamp(features->texturesCount,
+                                                      BINDLESS_TEXTURES_MAX);
+    bindless->features.buffersCount = bindless_clamp(features->buffersCount, BINDLESS_BUFFERS_MAX);
+    bindless->framesInFlight        = framesInFlight;
+    bindless->setsCount             = features->indexing ? 1 : framesInFlight;
+
+    uint32_t texturesCount = bindless->features.texturesCount;
+    uint32_t buffersCount  = bindless->features.buffersCount;
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    bindings[0].binding                      = BINDLESS_BINDING_TEXTURES;
+    bindings[0].descriptorType               = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount              = texturesCount;
+    bindings[0].stageFlags                   = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[1].binding                      = BINDLESS_BINDING_BUFFERS;
+    bindings[1].descriptorType               = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount              = buffersCount;
+    bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    /* free entries are never read, entries are written while frames that
+     * do not read them are pending */
+    VkDescriptorBindingFlagsEXT bindingFlags[2] = {};
+    for (uint32_t i = 0; i < 2; ++i)
+        bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+    bindingFlagsInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount  = 2;
+    bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 2;
+    setLayoutInfo.pBindings    = bindings;
+    if (features->indexing)
+    {
+        setLayoutInfo.pNext = &bindingFlagsInfo;
+        setLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    }
+
+    if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, NULL, &bindless->setLayout) !=
+        VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless set layout create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkDescriptorPoolSize poolSizes[2] = {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, texturesCount * bindless->setsCount},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffersCount * bindless->setsCount},
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets                    = bindless->setsCount;
+    poolInfo.poolSizeCount              = 2;
+    poolInfo.pPoolSizes                 = poolSizes;
+    if (features->indexing)
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+
+    VkDescriptorSetLayout layouts[BINDLESS_SLOTS_MAX];
+    for (uint32_t i = 0; i < bindless->setsCount; ++i)
+        layouts[i] = bindless->setLayout;
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorSetCount          = bindless->setsCount;
+    setInfo.pSetLayouts                 = layouts;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, NULL, &bindless->descriptorPool) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless descriptor pool create error\n");
+        exit(EXIT_FAILURE);
+    }
+    setInfo.descriptorPool = bindless->descriptorPool;
+    if (vkAllocateDescriptorSets(device, &setInfo, bindless->sets) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless descriptor set allocate error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* free lists hand out low indices first, the default is never free */
+    bindless->textures     = bindless_alloc(texturesCount * sizeof(bindless->textures[0]));
+    bindless->buffers      = bindless_alloc(buffersCount * sizeof(bindless->buffers[0]));
+    bindless->texturesFree = bindless_alloc(texturesCount * sizeof(bindless->texturesFree[0]));
+    bindless->buffersFree  = bindless_alloc(buffersCount * sizeof(bindless->buffersFree[0]));
+    for (uint32_t i = texturesCount - 1; i > BINDLESS_DEFAULT; --i)
+        bindless->texturesFree[bindless->texturesFreeCount++] = i;
+    for (uint32_t i = buffersCount - 1; i > BINDLESS_DEFAULT; --i)
+        bindless->buffersFree[bindless->buffersFreeCount++] = i;
+    bindless->retired =
+        bindless_alloc((texturesCount + buffersCount) * sizeof(bindless->retired[0]));
+    bindless->writes =
+        bindless_alloc((texturesCount + buffersCount) * sizeof(bindless->writes[0]));
+
+    bindless->specializationEntries[0] = (VkSpecializationMapEntry){0, 0, sizeof(uint32_t)};
+    bindless->specializationEntries[1] =
+        (VkSpecializationMapEntry){1, sizeof(uint32_t), sizeof(uint32_t)};
+    bindless->specializationData[0]         = texturesCount;
+    bindless->specializationData[1]         = buffersCount;
+    bindless->specialization.mapEntryCount  = 2;
+    bindless->specialization.pMapEntries    = bindless->specializationEntries;
+    bindless->specialization.dataSize       = sizeof(bindless->specializationData);
+    bindless->specialization.pData          = bindless->specializationData;
+}
+
+/* writes index of binding into every set now with indexing, into each
+ * fallback set when bindless_set brings it up to date */
+static void bindless_write(struct Bindless* bindless, struct BindlessEntry* entry, bool texture)
+{
+    entry->version = ++bindless->version;
+    if (!bindless->features.indexing)
+        return;
+
+    VkWriteDescriptorSet write = {};
+    write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet               = bindless->sets[0];
+    write.descriptorCount      = 1;
+    if (texture)
+    {
+        write.dstBinding      = BINDLESS_BINDING_TEXTURES;
+        write.dstArrayElement = (uint32_t) (entry - bindless->textures);
+        write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo      = &entry->image;
+    }
+    else
+    {
+        write.dstBinding      = BINDLESS_BINDING_BUFFERS;
+        write.dstArrayElement = (uint32_t) (entry - bindless->buffers);
+        write.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo     = &entry->buffer;
+    }
+    vkUpdateDescriptorSets(bindless->device, 1, &write, 0, NULL);
+}
+
+void bindless_defaults(struct Bindless*  bindless,
+                       struct Allocator* allocator,
+                       VkCommandPool     commandPool,
+                       VkQueue           queue)
+{
+    VkDevice device = bindless->device;
+
+    const float   ones[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    struct BufferUpload upload  = {
+        &bindless->buffer, ones, sizeof(ones), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+    buffer_upload(allocator, commandPool, queue, &upload, 1);
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter           = VK_FILTER_LINEAR;
+    samplerInfo.minFilter           = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.maxLod              = VK_LOD_CLAMP_NONE;
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent            = (VkExtent3D){1, 1, 1};
+    imageInfo.mipLevels         = 1;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateSampler(device, &samplerInfo, NULL, &bindless->sampler) != VK_SUCCESS ||
+        vkCreateImage(device, &imageInfo, NULL, &bindless->image) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless default texture create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(device, bindless->image, &memoryRequirements);
+    if (!allocator_alloc(allocator,
+                         &memoryRequirements,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         ALLOCATOR_KIND_OPTIMAL,
+                         &bindless->imageAllocation) ||
+        vkBindImageMemory(device,
+                          bindless->image,
+                          bindless->imageAllocation.memory,
+                          bindless->imageAllocation.offset) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless default texture memory error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkImageViewCreateInfo viewInfo       = {};
+    viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                       = bindless->image;
+    viewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                      = imageInfo.format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device, &viewInfo, NULL, &bindless->view) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless default texture view create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* cleared to white, no staging needed */
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool                 = commandPool;
+    allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount          = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless commandBuffer allocate error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask        = 0;
+    barrier.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                = bindless->image;
+    barrier.subresourceRange     = viewInfo.subresourceRange;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         1,
+                         &barrier);
+
+    VkClearColorValue white = {{1.0f, 1.0f, 1.0f, 1.0f}};
+    vkCmdClearColorImage(commandBuffer,
+                         bindless->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         &white,
+                         1,
+                         &viewInfo.subresourceRange);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         1,
+                         &barrier);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless commandBuffer record error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkSubmitInfo submitInfo       = {};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &commandBuffer;
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        fprintf(stderr, "bindless submit error\n");
+        exit(EXIT_FAILURE);
+    }
+    vkQueueWaitIdle(queue);
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+
+    /* every entry starts as the default, the fallback sets need them valid */
+    VkDescriptorImageInfo  image  = {bindless->sampler,
+                                     bindless->view,
+                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkDescriptorBufferInfo buffer = {bindless->buffer.buffer, 0, VK_WHOLE_SIZE};
+    for (uint32_t i = 0; i < bindless->features.texturesCount; ++i)
+        bindless->textures[i].image = image;
+    for (uint32_t i = 0; i < bindless->features.buffersCount; ++i)
+        bindless->buffers[i].buffer = buffer;
+    for (uint32_t i = 0; i < bindless->features.texturesCount; ++i)
+        if (i == BINDLESS_DEFAULT || !bindless->features.indexing)
+            bindless_write(bindless, &bindless->textures[i], true);
+    for (uint32_t i = 0; i < bindless->features.buffersCount; ++i)
+        if (i == BINDLESS_DEFAULT || !bindless->features.indexing)
+            bindless_write(bindless, &bindless->buffers[i], false);
+}
+
+void bindless_destroy(struct Bindless* bindless, struct Allocator* allocator)
+{
+    if (bindless->image != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(bindless->device, bindless->view, NULL);
+        vkDestroyImage(bindless->device, bindless->image, NULL);
+        allocator_free(allocator, &bindless->imageAllocation);
+        vkDestroySampler(bindless->device, bindless->sampler, NULL);
+        buffer_destroy(allocator, &bindless->buffer);
+    }
+    vkDestroyDescriptorPool(bindless->device, bindless->descriptorPool, NULL);
+    vkDestroyDescriptorSetLayout(bindless->device, bindless->setLayout, NULL);
+
+    free(bindless->writes);
+    free(bindless->retired);
+    free(bindless->buffersFree);
+    free(bindless->texturesFree);
+    free(bindless->buffers);
+    free(bindless->textures);
+    *bindless = (struct Bindless){};
+}
+
+uint32_t bindless_texture_add(struct Bindless* bindless, VkImageView view, VkSampler sampler)
+{
+    if (bindless->texturesFreeCount == 0)
+        return BINDLESS_DEFAULT;
+
+    uint32_t              index = bindless->texturesFree[--bindless->texturesFreeCount];
+    struct BindlessEntry* entry = &bindless->textures[index];
+    entry->image = (VkDescriptorImageInfo){sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    bindless_write(bindless, entry, true);
+    return index;
+}
+
+uint32_t bindless_buffer_add(struct Bindless* bindless,
+                             VkBuffer         buffer,
+                             VkDeviceSize     offset,
+                             VkDeviceSize     range)
+{
+    if (bindless->buffersFreeCount == 0)
+        return BINDLESS_DEFAULT;
+
+    uint32_t              index = bindless->buffersFree[--bindless->buffersFreeCount];
+    struct BindlessEntry* entry = &bindless->buffers[index];
+    entry->buffer               = (VkDescriptorBufferInfo){buffer, offset, range};
+    bindless_write(bindless, entry, false);
+    return index;
+}
+
+static void bindless_remove(struct Bindless* bindless, uint32_t index, bool texture)
+{
+    if (index == BINDLESS_DEFAULT)
+        return;
+
+    /* the fallback sets go back to the default before the view or buffer
+     * can be destroyed, with indexing the entry is simply never read */
+    struct BindlessEntry* entries = texture ? bindless->textures : bindless->buffers;
+    if (!bindless->features.indexing)
+    {
+        entries[index].image  = entries[BINDLESS_DEFAULT].image;
+        entries[index].buffer = entries[BINDLESS_DEFAULT].buffer;
+        bindless_write(bindless, &entries[index], texture);
+    }
+
+    struct BindlessRetired* retired = &bindless->retired[bindless->retiredCount++];
+    retired->index                  = index;
+    retired->texture                = texture;
+    retired->frame                  = bindless->frame;
+}
+
+void bindless_texture_remove(struct Bindless* bindless, uint32_t index)
+{
+    bindless_remove(bindless, index, true);
+}
+
+void bindless_buffer_remove(struct Bindless* bindless, uint32_t index)
+{
+    bindless_remove(bindless, index, false);
+}
+
+VkDescriptorSet bindless_set(struct Bindless* bindless, uint32_t slot)
+{
+    bindless->frame++;
+
+    /* the caller waited for the frame framesInFlight ago, the last one
+     * that could read indices removed before it was recorded */
+    for (uint32_t i = 0; i < bindless->retiredCount;)
+    {
+        struct BindlessRetired* retired = &bindless->retired[i];
+        if (retired->frame + bindless->framesInFlight > bindless->frame)
+        {
+            ++i;
+            continue;
+        }
+        if (retired->texture)
+            bindless->texturesFree[bindless->texturesFreeCount++] = retired->index;
+        else
+            bindless->buffersFree[bindless->buffersFreeCount++] = retired->index;
+        *retired = bindless->retired[--bindless->retiredCount];
+    }
+
+    if (bindless->features.indexing)
+        return bindless->sets[0];
+
+    /* the slot's set is not in use, everything changed since it was last
+     * recorded goes in */
+    VkDescriptorSet set          = bindless->sets[slot];
+    uint64_t        written      = bindless->setVersions[slot];
+    uint32_t        writesCount  = 0;
+    for (uint32_t binding = 0; binding < 2; ++binding)
+    {
+        bool                  texture = binding == BINDLESS_BINDING_TEXTURES;
+        struct BindlessEntry* entries = texture ? bindless->textures : bindless->buffers;
+        uint32_t              count   = texture ? bindless->features.texturesCount
+                                                : bindless->features.buffersCount;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (entries[i].version <= written)
+                continue;
+
+            VkWriteDescriptorSet* write = &bindless->writes[writesCount++];
+            *write                      = (VkWriteDescriptorSet){};
+            write->sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write->dstSet               = set;
+            write->dstBinding           = binding;
+            write->dstArrayElement      = i;
+            write->descriptorCount      = 1;
+            write->descriptorType       = texture ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+                                                  : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write->pImageInfo           = texture ? &entries[i].image : NULL;
+            write->pBufferInfo          = texture ? NULL : &entries[i].buffer;
+        }
+    }
+    if (writesCount > 0)
+        vkUpdateDescriptorSets(bindless->device, writesCount, bindless->writes, 0, NULL);
+    bindless->setVersions[slot] = bindless->version;
+    return set;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "allocator.h"
+#include "buffer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define BINDLESS_TEXTURES_MAX     4096 /* entries of the texture array, at most */
+#define BINDLESS_BUFFERS_MAX      1024 /* entries of the storage buffer array, at most */
+#define BINDLESS_SLOTS_MAX        4    /* frames in flight, sets of the fallback */
+#define BINDLESS_BINDING_TEXTURES 0
+#define BINDLESS_BINDING_BUFFERS  1
+#define BINDLESS_DEFAULT          0    /* white texture, buffer of vec4(1) */
+/* clang-format on */
+
+/* what the device offers, filled in at device creation */
+struct BindlessFeatures
+{
+    bool     indexing; /* VK_EXT_descriptor_indexing: update after bind, partially bound */
+    uint32_t texturesCount; /* array sizes, within device limits, 1 without dynamic indexing */
+    uint32_t buffersCount;
+};
+
+/* per draw, the only thing a draw sets: indices into the arrays */
+struct BindlessConstants
+{
+    uint32_t texture;
+    uint32_t buffer;
+};
+
+/* a table entry, version is bumped on every change */
+struct BindlessEntry
+{
+    VkDescriptorImageInfo  image;
+    VkDescriptorBufferInfo buffer;
+    uint64_t               version;
+};
+
+/* an index removed in frame, free again once no frame in flight can use it */
+struct BindlessRetired
+{
+    uint32_t index;
+    bool     texture;
+    uint64_t frame;
+};
+
+/* one global set holding arrays of every texture (binding 0, combined
+ * image samplers) and storage buffer (binding 1), bound once per command
+ * buffer. draws select entries with BindlessConstants push constants, so
+ * nothing is bound or written per draw. with descriptor indexing it is a
+ * single UPDATE_AFTER_BIND set written as entries are added: free entries
+ * are partially bound, and an index is reused only when no frame in
+ * flight can still read it. without it every frame slot has its own set
+ * in which every entry is valid (free ones hold the defaults), brought up
+ * to date by bindless_set right before the slot is recorded. the shader
+ * array sizes are the specialization constants 0 (textures) and 1
+ * (buffers). not thread safe */
+struct Bindless
+{
+    VkDevice                device;
+    struct BindlessFeatures features;
+    uint32_t                framesInFlight;
+    uint32_t                setsCount; /* 1 with indexing, else one per frame slot */
+    VkDescriptorSetLayout   setLayout;
+    VkDescriptorPool        descriptorPool;
+    VkDescriptorSet         sets[BINDLESS_SLOTS_MAX];
+    uint64_t                setVersions[BINDLESS_SLOTS_MAX]; /* entries written up to */
+    uint64_t                version;
+
+    struct BindlessEntry* textures;
+    struct BindlessEntry* buffers;
+    uint32_t*             texturesFree;
+    uint32_t              texturesFreeCount;
+    uint32_t*             buffersFree;
+    uint32_t              buffersFreeCount;
+
+    struct BindlessRetired* retired;
+    uint32_t                retiredCount;
+    uint64_t                frame;
+
+    VkWriteDescriptorSet* writes; /* bindless_set scratch */
+
+    /* BINDLESS_DEFAULT */
+    VkSampler         sampler;
+    VkImage           image;
+    VkImageView       view;
+    struct Allocation imageAllocation;
+    struct Buffer     buffer;
+
+    VkSpecializationMapEntry specializationEntries[2];
+    uint32_t                 specializationData[2];
+    VkSpecializationInfo     specialization; /* of stages using the arrays */
+};
+
+/* fills features from what the device was created with: enabled features
+ * and the core limits, which the update after bind ones are at least */
+void bindless_features(struct BindlessFeatures*        features,
+                       bool                            indexing,
+                       const VkPhysicalDeviceFeatures* enabled,
+                       const VkPhysicalDeviceLimits*   limits);
+
+/* the set layout and sets, so pipelines can be created, for up to
+ * framesInFlight frames in flight. every entry reads as the default once
+ * bindless_defaults ran */
+void bindless_init(struct Bindless*               bindless,
+                   VkDevice                       device,
+                   const struct BindlessFeatures* features,
+                   uint32_t                       framesInFlight);
+
+/* creates the default texture and buffer on queue and waits for them */
+void bindless_defaults(struct Bindless*  bindless,
+                       struct Allocator* allocator,
+                       VkCommandPool     commandPool,
+                       VkQueue           queue);
+
+/* the device must be idle */
+void bindless_destroy(struct Bindless* bindless, struct Allocator* allocator);
+
+/* index of a new texture entry, BINDLESS_DEFAULT if the array is full.
+ * view must be in SHADER_READ_ONLY_OPTIMAL when frames use it */
+uint32_t bindless_texture_add(struct Bindless* bindless, VkImageView view, VkSampler sampler);
+
+/* index of a new storage buffer entry, BINDLESS_DEFAULT if the array is full */
+uint32_t bindless_buffer_add(struct Bindless* bindless,
+                             VkBuffer         buffer,
+                             VkDeviceSize     offset,
+                             VkDeviceSize     range);
+
+/* frames recorded from now on must not use index. it may still be read
+ * by frames in flight, so the view or buffer behind it has to live as
+ * long as they do */
+void bindless_texture_remove(struct Bindless* bindless, uint32_t index);
+
+void bindless_buffer_remove(struct Bindless* bindless, uint32_t index);
+
+/* the set to bind in the frame recorded into slot, once the slot's last
+ * frame finished. call once per frame, after the last add or remove for
+ * it: the fallback writes the entries that changed here */
+VkDescriptorSet bindless_set(struct Bindless* bindless, uint32_t slot);
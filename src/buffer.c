@@ -0,0 +1,197 @@
+#include "buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void buffer_create(struct Allocator*     allocator,
+                   VkDeviceSize          size,
+                   VkBufferUsageFlags    usage,
+                   VkMemoryPropertyFlags memoryFlags,
+                   struct Buffer*        buffer)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size               = size;
+    bufferInfo.usage              = usage;
+    bufferInfo.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(allocator->device, &bufferInfo, NULL, &buffer->buffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "buffer create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(allocator->device, buffer->buffer, &memoryRequirements);
+
+    if (!allocator_alloc(allocator,
+                         &memoryRequirements,
+                         memoryFlags,
+                         ALLOCATOR_KIND_LINEAR,
+                         &buffer->allocation) ||
+        vkBindBufferMemory(allocator->device,
+                           buffer->buffer,
+                           buffer->allocation.memory,
+                           buffer->allocation.offset) != VK_SUCCESS)
+    {
+        fprintf(stderr, "buffer memory error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    buffer->size = size;
+}
+
+void buffer_destroy(struct Allocator* allocator, struct Buffer* buffer)
+{
+    vkDestroyBuffer(allocator->device, buffer->buffer, NULL);
+    allocator_free(allocator, &buffer->allocation);
+    buffer->buffer = VK_NULL_HANDLE;
+    buffer->size   = 0;
+}
+
+void buffer_ring_create(struct Allocator*     allocator,
+                        VkDeviceSize          size,
+                        VkBufferUsageFlags    usage,
+                        VkMemoryPropertyFlags memoryFlags,
+                        struct AllocatorRing* ring,
+                        VkBuffer*             buffer)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size               = size;
+    bufferInfo.usage              = usage;
+    bufferInfo.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(allocator->device, &bufferInfo, NULL, buffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "ring buffer create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(allocator->device, *buffer, &memoryRequirements);
+
+    if (!allocator_ring_init(allocator, ring, &memoryRequirements, memoryFlags) ||
+        vkBindBufferMemory(
+            allocator->device, *buffer, ring->allocation.memory, ring->allocation.offset) !=
+            VK_SUCCESS)
+    {
+        fprintf(stderr, "ring buffer memory error\n");
+        exit(EXIT_FAILURE);
+    }
+    /* the memory may be padded past the end of the buffer */
+    ring->size = size;
+}
+
+void buffer_ring_destroy(struct Allocator* allocator, struct AllocatorRing* ring, VkBuffer buffer)
+{
+    vkDestroyBuffer(allocator->device, buffer, NULL);
+    allocator_ring_destroy(allocator, ring);
+}
+
+void buffer_upload(struct Allocator*    allocator,
+                   VkCommandPool        commandPool,
+                   VkQueue              queue,
+                   struct BufferUpload* uploads,
+                   uint32_t             uploadsCount)
+{
+    VkDevice device = allocator->device;
+
+    /* staging: all uploads back to back, 16 byte aligned */
+    VkDeviceSize stagingSize = 0;
+    for (uint32_t i = 0; i < uploadsCount; ++i)
+    {
+        stagingSize += (uploads[i].size + 15) & ~(VkDeviceSize) 15;
+    }
+
+    struct Buffer staging;
+    buffer_create(allocator,
+                  stagingSize,
+                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  &staging);
+
+    /* record */
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool                 = commandPool;
+    allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount          = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "upload commandBuffer allocate error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkDeviceSize stagingOffset = 0;
+    for (uint32_t i = 0; i < uploadsCount; ++i)
+    {
+        struct BufferUpload* upload = &uploads[i];
+
+        buffer_create(allocator,
+                      upload->size,
+                      upload->usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                      upload->buffer);
+
+        memcpy((char*) staging.allocation.mapped + stagingOffset, upload->data, upload->size);
+
+        VkBufferCopy copy = {stagingOffset, 0, upload->size};
+        vkCmdCopyBuffer(commandBuffer, staging.buffer, upload->buffer->buffer, 1, &copy);
+
+        stagingOffset += (upload->size + 15) & ~(VkDeviceSize) 15;
+    }
+
+    /* make the copies visible to whatever reads the buffers next */
+    VkMemoryBarrier barrier = {};
+    barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "upload commandBuffer record error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* submit */
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence;
+    vkCreateFence(device, &fenceInfo, NULL, &fence);
+
+    VkSubmitInfo submitInfo       = {};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &commandBuffer;
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        fprintf(stderr, "upload submit error\n");
+        exit(EXIT_FAILURE);
+    }
+    vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+
+    vkDestroyFence(device, fence, NULL);
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    buffer_destroy(allocator, &staging);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "allocator.h"
+
+#include <vulkan/vulkan.h>
+
+struct Buffer
+{
+    VkBuffer          buffer;
+    struct Allocation allocation;
+    VkDeviceSize      size;
+};
+
+/* creates a buffer suballocated from allocator, exits on failure.
+ * HOST_VISIBLE buffers are persistently mapped at allocation.mapped */
+void buffer_create(struct Allocator*     allocator,
+                   VkDeviceSize          size,
+                   VkBufferUsageFlags    usage,
+                   VkMemoryPropertyFlags memoryFlags,
+                   struct Buffer*        buffer);
+
+void buffer_destroy(struct Allocator* allocator, struct Buffer* buffer);
+
+/* a buffer spanning the memory of ring, allocations of the ring are
+ * offsets into it. exits on failure */
+void buffer_ring_create(struct Allocator*     allocator,
+                        VkDeviceSize          size,
+                        VkBufferUsageFlags    usage,
+                        VkMemoryPropertyFlags memoryFlags,
+                        struct AllocatorRing* ring,
+                        VkBuffer*             buffer);
+
+void buffer_ring_destroy(struct Allocator* allocator, struct AllocatorRing* ring, VkBuffer buffer);
+
+/* one device-local buffer to be created and filled by buffer_upload */
+struct BufferUpload
+{
+    struct Buffer*     buffer;
+    const void*        data;
+    VkDeviceSize       size;
+    VkBufferUsageFlags usage;
+};
+
+/* creates DEVICE_LOCAL buffers and fills all of them through one
+ * host-visible staging buffer in a single submission, then waits for it */
+void buffer_upload(struct Allocator*    allocator,
+                   VkCommandPool        commandPool,
+                   VkQueue              queue,
+                   struct BufferUpload* uploads,
+                   uint32_t             uploadsCount);
@@ -0,0 +1,363 @@
+#include "cull.h"
+
+#include "recorder.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* clang-format off */
+#define CULL_BINDINGS    5
+#define CULL_DRAW_STRIDE sizeof(VkDrawIndexedIndirectCommand)
+/* clang-format on */
+
+void cull_planes_clip(float planes[CULL_PLANES][4])
+{
+    /* -w <= x, y <= w and 0 <= z <= w, with w = 1 */
+    static const float clip[CULL_PLANES][4] = {
+        {1.0f, 0.0f, 0.0f, 1.0f},
+        {-1.0f, 0.0f, 0.0f, 1.0f},
+        {0.0f, 1.0f, 0.0f, 1.0f},
+        {0.0f, -1.0f, 0.0f, 1.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+        {0.0f, 0.0f, -1.0f, 1.0f},
+    };
+    memcpy(planes, clip, sizeof(clip));
+}
+
+void cull_init(struct Cull*        cull,
+               struct Allocator*   allocator,
+               VkShaderModule      shaderModule,
+               VkPipelineCache     pipelineCache,
+               struct CullFeatures features)
+{
+    *cull           = (struct Cull){};
+    cull->device    = allocator->device;
+    cull->allocator = allocator;
+    cull->features  = features;
+    cull_planes_clip(cull->constants.planes);
+
+    /* instances, objectMeshes, meshes, draws, count */
+    VkDescriptorSetLayoutBinding bindings[CULL_BINDINGS] = {};
+    for (uint32_t i = 0; i < CULL_BINDINGS; ++i)
+    {
+        bindings[i].binding         = i;
+        bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = CULL_BINDINGS;
+    setLayoutInfo.pBindings    = bindings;
+
+    VkPushConstantRange pushRange = {};
+    pushRange.stageFlags          = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset              = 0;
+    pushRange.size                = sizeof(struct CullConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount             = 1;
+    layoutInfo.pSetLayouts                = &cull->setLayout;
+    layoutInfo.pushConstantRangeCount     = 1;
+    layoutInfo.pPushConstantRanges        = &pushRange;
+
+    if (vkCreateDescriptorSetLayout(cull->device, &setLayoutInfo, NULL, &cull->setLayout) !=
+            VK_SUCCESS ||
+        vkCreatePipelineLayout(cull->device, &layoutInfo, NULL, &cull->layout) != VK_SUCCESS)
+    {
+        fprintf(stderr, "cull layout create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName  = "main";
+    pipelineInfo.layout       = cull->layout;
+
+    if (vkCreateComputePipelines(
+            cull->device, pipelineCache, 1, &pipelineInfo, NULL, &cull->pipeline) != VK_SUCCESS)
+    {
+        fprintf(stderr, "cull pipeline create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* one set, rewritten by cull_scene */
+    VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, CULL_BINDINGS};
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets                    = 1;
+    poolInfo.poolSizeCount              = 1;
+    poolInfo.pPoolSizes                 = &poolSize;
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorSetCount          = 1;
+    setInfo.pSetLayouts                 = &cull->setLayout;
+
+    if (vkCreateDescriptorPool(cull->device, &poolInfo, NULL, &cull->descriptorPool) !=
+        VK_SUCCESS)
+    {
+        fprintf(stderr, "cull descriptor pool create error\n");
+        exit(EXIT_FAILURE);
+    }
+    setInfo.descriptorPool = cull->descriptorPool;
+    if (vkAllocateDescriptorSets(cull->device, &setInfo, &cull->descriptorSet) != VK_SUCCESS)
+    {
+        fprintf(stderr, "cull descriptor set allocate error\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void cull_scene_destroy(struct Cull* cull)
+{
+    if (cull->draws.buffer == VK_NULL_HANDLE)
+        return;
+
+    buffer_destroy(cull->allocator, &cull->meshes);
+    buffer_destroy(cull->allocator, &cull->objectMeshes);
+    buffer_destroy(cull->allocator, &cull->draws);
+    buffer_destroy(cull->allocator, &cull->count);
+    cull->constants.objectsCount = 0;
+}
+
+void cull_destroy(struct Cull* cull)
+{
+    cull_scene_destroy(cull);
+    vkDestroyDescriptorPool(cull->device, cull->descriptorPool, NULL);
+    vkDestroyPipeline(cull->device, cull->pipeline, NULL);
+    vkDestroyPipelineLayout(cull->device, cull->layout, NULL);
+    vkDestroyDescriptorSetLayout(cull->device, cull->setLayout, NULL);
+    *cull = (struct Cull){};
+}
+
+void cull_scene(struct Cull*       cull,
+                VkCommandPool      commandPool,
+                VkQueue            queue,
+                const struct Mesh* meshes,
+                const float*       radii,
+                uint32_t           meshesCount,
+                const uint32_t*    objectMeshes,
+                VkBuffer           instanceBuffer,
+                uint32_t           objectsCount)
+{
+    cull_scene_destroy(cull);
+
+    struct CullMesh* cullMeshes = malloc(meshesCount * sizeof(cullMeshes[0]));
+    for (uint32_t i = 0; i < meshesCount; ++i)
+    {
+        cullMeshes[i].indexCount   = meshes[i].indexCount;
+        cullMeshes[i].firstIndex   = meshes[i].firstIndex;
+        cullMeshes[i].vertexOffset = meshes[i].vertexOffset;
+        cullMeshes[i].radius       = radii[i];
+    }
+
+    struct BufferUpload uploads[2] = {};
+    uploads[0].buffer              = &cull->meshes;
+    uploads[0].data                = cullMeshes;
+    uploads[0].size                = meshesCount * sizeof(cullMeshes[0]);
+    uploads[0].usage               = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    uploads[1].buffer              = &cull->objectMeshes;
+    uploads[1].data                = objectMeshes;
+    uploads[1].size                = objectsCount * sizeof(objectMeshes[0]);
+    uploads[1].usage               = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buffer_upload(cull->allocator, commandPool, queue, uploads, 2);
+    free(cullMeshes);
+
+    buffer_create(cull->allocator,
+                  objectsCount * CULL_DRAW_STRIDE,
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  &cull->draws);
+    /* read back by cull_visible */
+    buffer_create(cull->allocator,
+                  CULL_SLOTS_MAX * sizeof(uint32_t),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  &cull->count);
+    memset(cull->count.allocation.mapped, 0, CULL_SLOTS_MAX * sizeof(uint32_t));
+
+    VkDescriptorBufferInfo buffers[CULL_BINDINGS] = {
+        {instanceBuffer, 0, VK_WHOLE_SIZE},
+        {cull->objectMeshes.buffer, 0, VK_WHOLE_SIZE},
+        {cull->meshes.buffer, 0, VK_WHOLE_SIZE},
+        {cull->draws.buffer, 0, VK_WHOLE_SIZE},
+        {cull->count.buffer, 0, VK_WHOLE_SIZE},
+    };
+    VkWriteDescriptorSet writes[CULL_BINDINGS] = {};
+    for (uint32_t i = 0; i < CULL_BINDINGS; ++i)
+    {
+        writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet          = cull->descriptorSet;
+        writes[i].dstBinding      = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo     = &buffers[i];
+    }
+    vkUpdateDescriptorSets(cull->device, CULL_BINDINGS, writes, 0, NULL);
+
+    /* one count covers every draw only up to the device limit */
+    cull->constants.objectsCount = objectsCount;
+    cull->constants.compact      = cull->features.drawIndirectCount != NULL &&
+                              objectsCount <= cull->features.maxDrawIndirectCount;
+}
+
+void cull_record(const struct Cull* cull, VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if (cull == NULL || cull->constants.objectsCount == 0)
+        return;
+    if (slot >= CULL_SLOTS_MAX)
+    {
+        fprintf(stderr, "cull record error: slot %u of %u\n", slot, CULL_SLOTS_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    /* the previous frame may still draw from the buffers being rewritten */
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+    vkCmdFillBuffer(
+        commandBuffer, cull->count.buffer, slot * sizeof(uint32_t), sizeof(uint32_t), 0);
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull->pipeline);
+    vkCmdBindDescriptorSets(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            cull->layout,
+                            0,
+                            1,
+                            &cull->descriptorSet,
+                            0,
+                            NULL);
+    struct CullConstants constants = cull->constants;
+    constants.countSlot            = slot;
+    vkCmdPushConstants(commandBuffer,
+                       cull->layout,
+                       VK_SHADER_STAGE_COMPUTE_BIT,
+                       0,
+                       sizeof(constants),
+                       &constants);
+    uint32_t groups = (cull->constants.objectsCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+    vkCmdDispatch(commandBuffer, groups, 1, 1);
+
+    /* draws and count become indirect arguments, the count is also read
+     * back by the host once the frame finished */
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+}
+
+void cull_draw(const struct Cull* cull, VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    uint32_t count = cull->constants.objectsCount;
+    if (count == 0)
+        return;
+
+    if (cull->constants.compact)
+    {
+        cull->features.drawIndirectCount(commandBuffer,
+                                         cull->draws.buffer,
+                                         0,
+                                         cull->count.buffer,
+                                         slot * sizeof(uint32_t),
+                                         count,
+                                         CULL_DRAW_STRIDE);
+        return;
+    }
+
+    /* culled objects cost a draw with instanceCount 0. without
+     * multiDrawIndirect every one is its own call */
+    uint32_t perCall = 1;
+    if (cull->features.multiDrawIndirect)
+        perCall = cull->features.maxDrawIndirectCount;
+    for (uint32_t first = 0; first < count; first += perCall)
+    {
+        uint32_t drawCount = count - first < perCall ? count - first : perCall;
+        vkCmdDrawIndexedIndirect(commandBuffer,
+                                 cull->draws.buffer,
+                                 first * CULL_DRAW_STRIDE,
+                                 drawCount,
+                                 CULL_DRAW_STRIDE);
+    }
+}
+
+uint32_t cull_visible(const struct Cull* cull, uint32_t slot)
+{
+    if (cull->count.buffer == VK_NULL_HANDLE || slot >= CULL_SLOTS_MAX)
+        return 0;
+    return ((const volatile uint32_t*) cull->count.allocation.mapped)[slot];
+}
+
+uint32_t cull_cpu(const float            planes[CULL_PLANES][4],
+                  const struct Instance* instances,
+                  const uint32_t*        objectMeshes,
+                  const float*           radii,
+                  uint32_t               objectsCount,
+                  struct Draw*           draws)
+{
+    uint32_t drawsCount = 0;
+    for (uint32_t i = 0; i < objectsCount; ++i)
+    {
+        const float* model = instances[i].model;
+        float        scale = 0.0f;
+        for (uint32_t column = 0; column < 3; ++column)
+        {
+            const float* axis = &model[column * 4];
+            float length      = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            scale             = length > scale ? length : scale;
+        }
+        float radius = radii[objectMeshes[i]] * scale;
+
+        bool visible = true;
+        for (uint32_t p = 0; p < CULL_PLANES && visible; ++p)
+        {
+            const float* plane = planes[p];
+            visible =
+                plane[0] * model[12] + plane[1] * model[13] + plane[2] * model[14] + plane[3] >=
+                -radius;
+        }
+        if (!visible)
+            continue;
+
+        draw_init(&draws[drawsCount++], objectMeshes[i], i, 1);
+    }
+    return drawsCount;
+}
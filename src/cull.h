@@ -0,0 +1,121 @@
+#pragma once
+
+#include "buffer.h"
+#include "mesh.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define CULL_GROUP_SIZE 64 /* local_size_x of cull.comp */
+#define CULL_PLANES     6
+#define CULL_SLOTS_MAX  4  /* frame slots with their own visible count */
+/* clang-format on */
+
+struct Draw;
+
+/* a mesh as cull.comp reads it, std430 */
+struct CullMesh
+{
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t  vertexOffset;
+    float    radius; /* bounding sphere around the mesh origin */
+};
+
+/* push constants of cull.comp */
+struct CullConstants
+{
+    float    planes[CULL_PLANES][4]; /* xyz . p + w >= 0 inside */
+    uint32_t objectsCount;
+    uint32_t compact;
+    uint32_t countSlot; /* set by cull_record */
+};
+
+/* what the device offers for the indirect draws */
+struct CullFeatures
+{
+    bool                                 multiDrawIndirect; /* many draws per call */
+    uint32_t                             maxDrawIndirectCount;
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndirectCount; /* NULL: unsupported */
+};
+
+/* frustum culling on the GPU. a compute pass tests the bounding sphere of
+ * every object (instance i of the instance buffer, drawing mesh
+ * objectMeshes[i]) against the planes and writes one
+ * VkDrawIndexedIndirectCommand per visible object, which the render pass
+ * then draws without the CPU touching the object list. with a draw count
+ * the visible draws are compacted and drawn in one call, else every object
+ * keeps its slot with instanceCount 0 when culled. the draw buffers are
+ * shared by all frames in flight, cull_record orders them. the visible
+ * count has one entry per frame slot, so the host reads a finished frame's
+ * count while the next frame clears its own. */
+struct Cull
+{
+    VkDevice              device;
+    struct Allocator*     allocator;
+    struct CullFeatures   features;
+    VkDescriptorSetLayout setLayout;
+    VkPipelineLayout      layout;
+    VkPipeline            pipeline;
+    VkDescriptorPool      descriptorPool;
+    VkDescriptorSet       descriptorSet;
+
+    /* scene, see cull_scene */
+    struct Buffer        meshes;       /* CullMesh per mesh */
+    struct Buffer        objectMeshes; /* uint32_t per object */
+    struct Buffer        draws;        /* VkDrawIndexedIndirectCommand per object */
+    struct Buffer        count;        /* visible objects per frame slot, HOST_VISIBLE */
+    struct CullConstants constants;
+};
+
+/* the clip space box, for models that place objects in clip space */
+void cull_planes_clip(float planes[CULL_PLANES][4]);
+
+/* creates the compute pipeline from shaderModule (cull.comp). the scene is
+ * empty and the planes are the clip space box */
+void cull_init(struct Cull*        cull,
+               struct Allocator*   allocator,
+               VkShaderModule      shaderModule,
+               VkPipelineCache     pipelineCache,
+               struct CullFeatures features);
+
+/* the device must be idle */
+void cull_destroy(struct Cull* cull);
+
+/* replaces the objects to cull. instanceBuffer holds objectsCount
+ * instances and needs STORAGE_BUFFER usage, radii holds one radius per
+ * mesh. the buffers are filled through buffer_upload on queue, the device
+ * must be idle */
+void cull_scene(struct Cull*       cull,
+                VkCommandPool      commandPool,
+                VkQueue            queue,
+                const struct Mesh* meshes,
+                const float*       radii,
+                uint32_t           meshesCount,
+                const uint32_t*    objectMeshes,
+                VkBuffer           instanceBuffer,
+                uint32_t           objectsCount);
+
+/* records the culling dispatch of frame slot, below CULL_SLOTS_MAX,
+ * outside a render pass and before the pass that calls cull_draw. NULL
+ * cull is a no-op */
+void cull_record(const struct Cull* cull, VkCommandBuffer commandBuffer, uint32_t slot);
+
+/* draws what the last cull_record of slot left visible, inside the render
+ * pass with the pipeline and buffers of mesh_bind bound */
+void cull_draw(const struct Cull* cull, VkCommandBuffer commandBuffer, uint32_t slot);
+
+/* visible objects of the frame last recorded in slot. read it once the
+ * fence of that frame signalled, not while it may still run */
+uint32_t cull_visible(const struct Cull* cull, uint32_t slot);
+
+/* the same test on the CPU: appends one single instance draw per visible
+ * object to draws, which has room for objectsCount. returns their count */
+uint32_t cull_cpu(const float            planes[CULL_PLANES][4],
+                  const struct Instance* instances,
+                  const uint32_t*        objectMeshes,
+                  const float*           radii,
+                  uint32_t               objectsCount,
+                  struct Draw*           draws);
@@ -0,0 +1,123 @@
+#include "device.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool instance_extension_supported(const char* name)
+{
+    uint32_t count = 0;
+    vkEnumerateInstanceExtensionProperties(NULL, &count, NULL);
+    VkExtensionProperties* extensions = malloc((count + 1) * sizeof(extensions[0]));
+    vkEnumerateInstanceExtensionProperties(NULL, &count, extensions);
+
+    bool found = false;
+    for (uint32_t i = 0; i < count && !found; ++i)
+        found = strcmp(extensions[i].extensionName, name) == 0;
+    free(extensions);
+    return found;
+}
+
+bool device_extension_supported(VkPhysicalDevice device, const char* name)
+{
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(device, NULL, &count, NULL);
+    VkExtensionProperties* extensions = malloc((count + 1) * sizeof(extensions[0]));
+    vkEnumerateDeviceExtensionProperties(device, NULL, &count, extensions);
+
+    bool found = false;
+    for (uint32_t i = 0; i < count && !found; ++i)
+        found = strcmp(extensions[i].extensionName, name) == 0;
+    free(extensions);
+    return found;
+}
+
+uint64_t device_score(VkPhysicalDevice device)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    VkPhysicalDeviceMemoryProperties memory;
+    vkGetPhysicalDeviceMemoryProperties(device, &memory);
+
+    /* by VkPhysicalDeviceType: other, integrated, discrete, virtual, cpu */
+    static const uint64_t typeScores[] = {0, 3, 4, 2, 1};
+    uint64_t              type         = 0;
+    if ((uint32_t) properties.deviceType < sizeof(typeScores) / sizeof(typeScores[0]))
+        type = typeScores[properties.deviceType];
+
+    VkDeviceSize local = 0;
+    for (uint32_t i = 0; i < memory.memoryHeapCount; ++i)
+        if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            local += memory.memoryHeaps[i].size;
+    uint64_t localMiB = local >> 20;
+    if (localMiB > 0xffffffu)
+        localMiB = 0xffffffu;
+
+    uint64_t dimension = properties.limits.maxImageDimension2D;
+    if (dimension > 0xffffu)
+        dimension = 0xffffu;
+
+    /* type | 24 bits of MiB (16 TiB) | 16 bits of limit */
+    return type << 40 | localMiB << 16 | dimension;
+}
+
+/* first family with all of include and none of exclude, -1 if none */
+static int32_t device_queue_family(const VkQueueFamilyProperties* families,
+                                   uint32_t                       count,
+                                   VkQueueFlags                   include,
+                                   VkQueueFlags                   exclude)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        VkQueueFlags flags = families[i].queueFlags;
+        if (families[i].queueCount > 0 && (flags & include) == include && !(flags & exclude))
+            return (int32_t) i;
+    }
+    return -1;
+}
+
+bool device_queues_select(VkPhysicalDevice     device,
+                          VkSurfaceKHR         surface,
+                          struct DeviceQueues* queues)
+{
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, NULL);
+    VkQueueFamilyProperties families[count + 1];
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, families);
+
+    *queues          = (struct DeviceQueues){-1, -1, -1, -1, false, false};
+    queues->graphics = device_queue_family(families, count, VK_QUEUE_GRAPHICS_BIT, 0);
+    if (queues->graphics < 0)
+        return false;
+
+    /* one family for both saves the ownership transfer of every image */
+    queues->present = surface == VK_NULL_HANDLE ? queues->graphics : -1;
+    for (uint32_t n = 0; surface != VK_NULL_HANDLE && n < count; ++n)
+    {
+        uint32_t i              = (n + (uint32_t) queues->graphics) % count;
+        VkBool32 presentSupport = VK_FALSE;
+        if (vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport) ==
+                VK_SUCCESS &&
+            presentSupport)
+        {
+            queues->present = (int32_t) i;
+            break;
+        }
+    }
+    if (queues->present < 0)
+        return false;
+
+    queues->compute =
+        device_queue_family(families, count, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+    queues->computeDedicated = queues->compute >= 0;
+    if (queues->compute < 0)
+        queues->compute = queues->graphics;
+
+    /* a transfer only family is a DMA engine. compute families copy too, so
+     * without one transfers share the async compute family */
+    queues->transfer = device_queue_family(
+        families, count, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (queues->transfer < 0)
+        queues->transfer = queues->compute;
+    queues->transferDedicated = queues->transfer != queues->graphics;
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* queue families picked for a physical device. transfer and compute fall
+ * back to the graphics family when the device has no other, and may share
+ * one family */
+struct DeviceQueues
+{
+    int32_t graphics;
+    int32_t present; /* the graphics family when it can present */
+    int32_t transfer;
+    int32_t compute;
+    bool    transferDedicated; /* not the graphics family, copies overlap rendering */
+    bool    computeDedicated;  /* no graphics, nothing is submitted to it yet */
+};
+
+/* true if the loader offers the instance extension name */
+bool instance_extension_supported(const char* name);
+
+/* true if device offers the extension name */
+bool device_extension_supported(VkPhysicalDevice device, const char* name);
+
+/* orders suitable devices, higher is better: discrete > integrated >
+ * virtual > CPU first, then device local memory, then image limits */
+uint64_t device_score(VkPhysicalDevice device);
+
+/* picks the queue families of device. surface VK_NULL_HANDLE (headless)
+ * leaves present at the graphics family. false without a graphics family
+ * or, with a surface, without one that can present */
+bool device_queues_select(VkPhysicalDevice     device,
+                          VkSurfaceKHR         surface,
+                          struct DeviceQueues* queues);
@@ -0,0 +1,191 @@
+#include "frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void frames_create(VkDevice      device,
+                   uint32_t      queueFamilyIndex,
+                   struct Frame* frames,
+                   uint32_t      count)
+{
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex        = queueFamilyIndex;
+    poolInfo.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        struct Frame* frame = &frames[i];
+        *frame              = (struct Frame){};
+        if (vkCreateCommandPool(device, &poolInfo, NULL, &frame->commandPool) != VK_SUCCESS)
+        {
+            fprintf(stderr, "frame commandPool create error\n");
+            exit(EXIT_FAILURE);
+        }
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool                 = frame->commandPool;
+        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount          = 1;
+
+        if (vkAllocateCommandBuffers(device, &allocInfo, &frame->commandBuffer) != VK_SUCCESS)
+        {
+            fprintf(stderr, "commandBuffer allocate error\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (vkCreateSemaphore(device, &semaphoreInfo, NULL, &frame->imageAvailable) != VK_SUCCESS ||
+            vkCreateSemaphore(device, &semaphoreInfo, NULL, &frame->renderFinished) != VK_SUCCESS ||
+            vkCreateFence(device, &fenceInfo, NULL, &frame->inFlight) != VK_SUCCESS)
+        {
+            fprintf(stderr, "sync create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void frames_destroy(VkDevice device, struct Frame* frames, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        vkDestroySemaphore(device, frames[i].renderFinished, NULL);
+        vkDestroySemaphore(device, frames[i].imageAvailable, NULL);
+        vkDestroyFence(device, frames[i].inFlight, NULL);
+        vkDestroyCommandPool(device, frames[i].commandPool, NULL);
+    }
+}
+
+static void frame_retire(struct Frame* frame, struct Samples* latencies)
+{
+    if (!frame->pending)
+        return;
+
+    frame->pending = false;
+    if (latencies != NULL)
+        samples_push(latencies, (double) (util_time_ns() - frame->submitTime) / 1e6);
+}
+
+void frame_wait(VkDevice device, struct Frame* frame, struct Samples* latencies)
+{
+    vkWaitForFences(device, 1, &frame->inFlight, VK_TRUE, UINT64_MAX);
+    frame_retire(frame, latencies);
+}
+
+void frames_poll(VkDevice device, struct Frame* frames, uint32_t count, struct Samples* latencies)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (frames[i].pending && vkGetFenceStatus(device, frames[i].inFlight) == VK_SUCCESS)
+            frame_retire(&frames[i], latencies);
+    }
+}
+
+void frame_claim_image(VkDevice      device,
+                       VkFence*      imagesInFlight,
+                       uint32_t      imageIndex,
+                       struct Frame* frame)
+{
+    /* the frame's own fence was waited on before, and is about to be reset */
+    VkFence previous = imagesInFlight[imageIndex];
+    if (previous != VK_NULL_HANDLE && previous != frame->inFlight)
+        vkWaitForFences(device, 1, &previous, VK_TRUE, UINT64_MAX);
+
+    imagesInFlight[imageIndex] = frame->inFlight;
+}
+
+void frame_record(VkDevice            device,
+                  struct Frame*       frame,
+                  uint32_t            frameIndex,
+                  uint32_t            imageIndex,
+                  struct FrameRecord* record)
+{
+    vkResetCommandPool(device, frame->commandPool, 0);
+
+    VkCommandBuffer commandBuffer = frame->commandBuffer;
+    recorder_begin(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, NULL);
+    upload_frame(record->uploader, commandBuffer);
+    gpu_timer_frame_begin(record->gpuTimer, commandBuffer, frameIndex);
+    uint32_t frameRegion = gpu_timer_begin(record->gpuTimer, commandBuffer, "frame");
+    if (record->pass.cull != NULL)
+    {
+        uint32_t cullRegion   = gpu_timer_begin(record->gpuTimer, commandBuffer, "cull");
+        record->pass.cullSlot = frameIndex;
+        cull_record(record->pass.cull, commandBuffer, frameIndex);
+        gpu_timer_end(record->gpuTimer, commandBuffer, cullRegion);
+    }
+    uint32_t passRegion = gpu_timer_begin(record->gpuTimer, commandBuffer, "main pass");
+
+    record->pass.framebuffer = record->framebuffers[imageIndex];
+    if (record->bindless != NULL)
+        record->pass.bindlessSet = bindless_set(record->bindless, frameIndex);
+    if (record->uniforms != NULL)
+    {
+        uniform_ring_frame_begin(record->uniforms, frameIndex);
+        if (!uniform_ring_write(record->uniforms,
+                                &record->frameUniforms,
+                                sizeof(record->frameUniforms),
+                                &record->pass.uniformOffset))
+        {
+            fprintf(stderr, "uniform ring full\n");
+            exit(EXIT_FAILURE);
+        }
+        record->pass.uniformSet = record->uniforms->set;
+    }
+    if (record->scene != NULL)
+    {
+        scene_frame_write(record->sceneFrames, record->scene, frameIndex);
+        record->pass.instanceBuffer = record->sceneFrames->buffers[frameIndex].buffer;
+        record->pass.draws          = record->sceneFrames->draws;
+        record->pass.drawsCount     = record->sceneFrames->drawsCount;
+    }
+    if (record->recorder != NULL)
+        recorder_record(record->recorder,
+                        record->jobs,
+                        frameIndex,
+                        record->threads,
+                        commandBuffer,
+                        &record->pass);
+    else
+        recorder_record_inline(commandBuffer, &record->pass);
+
+    gpu_timer_end(record->gpuTimer, commandBuffer, passRegion);
+    gpu_timer_end(record->gpuTimer, commandBuffer, frameRegion);
+    recorder_end(commandBuffer);
+    if (record->uniforms != NULL)
+        uniform_ring_frame_end(record->uniforms);
+}
+
+void frame_submit(VkQueue queue, struct Frame* frame, bool present)
+{
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType        = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    if (present)
+    {
+        submitInfo.waitSemaphoreCount   = 1;
+        submitInfo.pWaitSemaphores      = &frame->imageAvailable;
+        submitInfo.pWaitDstStageMask    = &waitStage;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores    = &frame->renderFinished;
+    }
+
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &frame->commandBuffer;
+
+    frame->submitTime = util_time_ns();
+    if (vkQueueSubmit(queue, 1, &submitInfo, frame->inFlight) != VK_SUCCESS)
+    {
+        fprintf(stderr, "queue submit error\n");
+        exit(EXIT_FAILURE);
+    }
+    frame->pending = true;
+}
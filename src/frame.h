@@ -0,0 +1,91 @@
+#pragma once
+
+#include "bindless.h"
+#include "gpu_timer.h"
+#include "recorder.h"
+#include "scene.h"
+#include "swapchain.h"
+#include "uniform.h"
+#include "upload.h"
+#include "util.h"
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+/* one frame in flight. everything in it is reused once inFlight signaled */
+struct Frame
+{
+    VkCommandPool   commandPool; /* TRANSIENT, reset as a whole every frame */
+    VkCommandBuffer commandBuffer;
+    VkSemaphore     imageAvailable;
+    VkSemaphore     renderFinished;
+    VkFence         inFlight;
+
+    /* latency: CPU time of the last submit, pending until inFlight is seen signaled */
+    uint64_t submitTime;
+    bool     pending;
+};
+
+/* set 1 binding 0 of the graphics pipelines, written once per frame */
+struct FrameUniforms
+{
+    float viewProjection[16]; /* column major */
+};
+
+/* what every frame records, the framebuffer is picked per swapchain image */
+struct FrameRecord
+{
+    struct RecordPass    pass;
+    const VkFramebuffer* framebuffers;
+    struct Recorder*     recorder; /* NULL: record inline on the calling thread */
+    struct Jobs*         jobs;
+    uint32_t             threads;
+    struct GpuTimer*     gpuTimer; /* NULL: no timestamps */
+    struct Uploader*     uploader; /* NULL: nothing streamed in */
+    struct Bindless*     bindless; /* NULL: no descriptors, pass.bindlessSet stays unset */
+    struct UniformRing*  uniforms; /* NULL: no set 1, frameUniforms are ignored */
+    struct FrameUniforms frameUniforms;
+    const struct Scene*  scene;       /* NULL: pass.draws and pass.instanceBuffer as set */
+    struct SceneFrames*  sceneFrames; /* written with scene every frame, set with it */
+};
+
+void frames_create(VkDevice      device,
+                   uint32_t      queueFamilyIndex,
+                   struct Frame* frames,
+                   uint32_t      count);
+
+void frames_destroy(VkDevice device, struct Frame* frames, uint32_t count);
+
+/* blocks until frame may be reused, latencies (may be NULL) gets its
+ * submit-to-signal time in ms if it was still pending */
+void frame_wait(VkDevice device, struct Frame* frame, struct Samples* latencies);
+
+/* non-blocking frame_wait for every pending frame, so latencies of frames
+ * that are not waited on yet are seen at most one loop iteration late */
+void frames_poll(VkDevice device, struct Frame* frames, uint32_t count, struct Samples* latencies);
+
+/* with more frames in flight than images, the frame that last rendered
+ * imageIndex may still run: waits for it, then hands the image to frame.
+ * imagesInFlight holds one fence (or VK_NULL_HANDLE) per swapchain image. */
+void frame_claim_image(VkDevice      device,
+                       VkFence*      imagesInFlight,
+                       uint32_t      imageIndex,
+                       struct Frame* frame);
+
+/* re-records frame for swapchain image imageIndex. the frame's fence must
+ * have signaled: its pool is reset in one call instead of per buffer, and
+ * the gpuTimer results of its previous recording are read back. finished
+ * uploads are acquired and the cull pass of the RecordPass is dispatched
+ * before the render pass. the bindless set of the slot is brought up to
+ * date, frameUniforms are copied into the uniform ring, and both are
+ * bound in every command buffer. a scene is written into the mapped
+ * instance buffer of the slot and drawn with the draws it builds */
+void frame_record(VkDevice            device,
+                  struct Frame*       frame,
+                  uint32_t            frameIndex,
+                  uint32_t            imageIndex,
+                  struct FrameRecord* record);
+
+/* submits the frame's command buffer signaling inFlight. with present set
+ * it waits for imageAvailable and signals renderFinished */
+void frame_submit(VkQueue queue, struct Frame* frame, bool present);
@@ -0,0 +1,292 @@
+#include "gpu_timer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void gpu_timer_init(struct GpuTimer* timer,
+                    VkPhysicalDevice devicePhysical,
+                    VkDevice         device,
+                    uint32_t         queueFamilyIndex,
+                    uint32_t         framesCount)
+{
+    *timer        = (struct GpuTimer){};
+    timer->device = device;
+
+    if (framesCount > GPU_TIMER_FRAMES_MAX)
+    {
+        fprintf(stderr, "gpuTimer supports at most %d frame(s)\n", GPU_TIMER_FRAMES_MAX);
+        exit(EXIT_FAILURE);
+    }
+    timer->framesCount = framesCount;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(devicePhysical, &properties);
+
+    uint32_t queueFamiliesCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(devicePhysical, &queueFamiliesCount, NULL);
+    VkQueueFamilyProperties queueFamilies[queueFamiliesCount];
+    vkGetPhysicalDeviceQueueFamilyProperties(devicePhysical, &queueFamiliesCount, queueFamilies);
+
+    uint32_t validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+    {
+        printf("gpuTimer: no timestamps on queue family %d\n", queueFamilyIndex);
+        return;
+    }
+    timer->validMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+    timer->periodNs  = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount            = 2 * GPU_TIMER_REGIONS_MAX;
+
+    for (uint32_t i = 0; i < framesCount; ++i)
+    {
+        if (vkCreateQueryPool(device, &poolInfo, NULL, &timer->frames[i].pool) != VK_SUCCESS)
+        {
+            fprintf(stderr, "gpuTimer queryPool create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    timer->supported = true;
+}
+
+static void gpu_timer_trace_close(struct GpuTimer* timer)
+{
+    if (timer->trace == NULL)
+        return;
+
+    if (timer->traceFormat == GPU_TIMER_TRACE_JSON)
+        fprintf(timer->trace, "\n]\n");
+    fclose(timer->trace);
+    timer->trace = NULL;
+}
+
+void gpu_timer_destroy(struct GpuTimer* timer)
+{
+    gpu_timer_trace_close(timer);
+    for (uint32_t i = 0; i < timer->framesCount; ++i)
+        if (timer->frames[i].pool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(timer->device, timer->frames[i].pool, NULL);
+    *timer = (struct GpuTimer){};
+}
+
+bool gpu_timer_trace_open(struct GpuTimer* timer, const char* path)
+{
+    gpu_timer_trace_close(timer);
+
+    timer->trace = fopen(path, "w");
+    if (timer->trace == NULL)
+        return false;
+
+    const char* extension = strrchr(path, '.');
+    timer->traceFormat    = extension != NULL && strcmp(extension, ".json") == 0
+                                ? GPU_TIMER_TRACE_JSON
+                                : GPU_TIMER_TRACE_CSV;
+    timer->traceFirst     = true;
+
+    if (timer->traceFormat == GPU_TIMER_TRACE_JSON)
+        fprintf(timer->trace, "[");
+    else
+        fprintf(timer->trace, "frame,region,depth,start_ms,ms\n");
+    return true;
+}
+
+/* ticks to ms, wrapping at timestampValidBits */
+static double gpu_timer_ms(const struct GpuTimer* timer, uint64_t from, uint64_t to)
+{
+    return (double) ((to - from) & timer->validMask) * timer->periodNs / 1e6;
+}
+
+static void gpu_timer_stat_add(struct GpuTimer* timer, const char* name, double ms)
+{
+    struct GpuTimerStat* stat = NULL;
+    for (uint32_t i = 0; i < timer->statsCount && stat == NULL; ++i)
+        if (strcmp(timer->stats[i].name, name) == 0)
+            stat = &timer->stats[i];
+
+    if (stat == NULL)
+    {
+        if (timer->statsCount == GPU_TIMER_STATS_MAX)
+            return;
+        stat        = &timer->stats[timer->statsCount++];
+        *stat       = (struct GpuTimerStat){};
+        stat->name  = name;
+        stat->minMs = ms;
+        stat->maxMs = ms;
+    }
+    stat->count += 1;
+    stat->totalMs += ms;
+    if (ms < stat->minMs)
+        stat->minMs = ms;
+    if (ms > stat->maxMs)
+        stat->maxMs = ms;
+}
+
+static void gpu_timer_trace_write(struct GpuTimer* timer, uint64_t frameStart)
+{
+    if (timer->trace == NULL)
+        return;
+
+    if (timer->traceFirst)
+    {
+        timer->traceOrigin = frameStart;
+        timer->traceFirst  = false;
+    }
+    else if (timer->traceFormat == GPU_TIMER_TRACE_JSON)
+        fprintf(timer->trace, ",");
+
+    double frameMs = gpu_timer_ms(timer, timer->traceOrigin, frameStart);
+    for (uint32_t i = 0; i < timer->resultsCount; ++i)
+    {
+        const struct GpuTimerRegion* region = &timer->results[i];
+        if (timer->traceFormat == GPU_TIMER_TRACE_JSON)
+            fprintf(timer->trace,
+                    "%s\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+                    i == 0 ? "" : ",",
+                    region->name,
+                    (frameMs + region->startMs) * 1e3,
+                    region->ms * 1e3,
+                    (unsigned long long) timer->resultsFrame);
+        else
+            fprintf(timer->trace,
+                    "%llu,%s,%u,%.6f,%.6f\n",
+                    (unsigned long long) timer->resultsFrame,
+                    region->name,
+                    region->depth,
+                    region->startMs,
+                    region->ms);
+    }
+}
+
+/* the slot's fence has signaled, so every written query is available and
+ * this does not wait. a region left open keeps its end query unavailable,
+ * the whole frame is dropped then */
+static void gpu_timer_read(struct GpuTimer* timer, struct GpuTimerFrame* frame)
+{
+    frame->pending = false;
+    if (frame->regionsCount == 0)
+        return;
+
+    uint64_t timestamps[2 * GPU_TIMER_REGIONS_MAX];
+    VkResult result = vkGetQueryPoolResults(timer->device,
+                                            frame->pool,
+                                            0,
+                                            2 * frame->regionsCount,
+                                            sizeof(timestamps),
+                                            timestamps,
+                                            sizeof(timestamps[0]),
+                                            VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+        return;
+
+    uint64_t frameStart = timestamps[0];
+    for (uint32_t i = 0; i < frame->regionsCount; ++i)
+    {
+        struct GpuTimerRegion* region = &timer->results[i];
+        region->name                  = frame->names[i];
+        region->depth                 = frame->depths[i];
+        region->startMs               = gpu_timer_ms(timer, frameStart, timestamps[2 * i]);
+        region->ms = gpu_timer_ms(timer, timestamps[2 * i], timestamps[2 * i + 1]);
+        gpu_timer_stat_add(timer, region->name, region->ms);
+    }
+    timer->resultsCount = frame->regionsCount;
+    timer->resultsFrame = frame->frameNumber;
+
+    gpu_timer_trace_write(timer, frameStart);
+}
+
+void gpu_timer_frame_begin(struct GpuTimer* timer, VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if (timer == NULL || !timer->supported)
+        return;
+
+    struct GpuTimerFrame* frame = &timer->frames[slot];
+    if (frame->pending)
+        gpu_timer_read(timer, frame);
+
+    vkCmdResetQueryPool(commandBuffer, frame->pool, 0, 2 * GPU_TIMER_REGIONS_MAX);
+    frame->regionsCount = 0;
+    frame->frameNumber  = ++timer->frameNumber;
+    frame->pending      = true;
+    timer->slot         = slot;
+    timer->depth        = 0;
+}
+
+void gpu_timer_flush(struct GpuTimer* timer)
+{
+    if (timer == NULL || !timer->supported)
+        return;
+
+    /* oldest frame first, so the trace stays in order */
+    for (;;)
+    {
+        struct GpuTimerFrame* oldest = NULL;
+        for (uint32_t i = 0; i < timer->framesCount; ++i)
+        {
+            struct GpuTimerFrame* frame = &timer->frames[i];
+            if (frame->pending && (oldest == NULL || frame->frameNumber < oldest->frameNumber))
+                oldest = frame;
+        }
+        if (oldest == NULL)
+            break;
+        gpu_timer_read(timer, oldest);
+    }
+}
+
+uint32_t gpu_timer_begin(struct GpuTimer* timer, VkCommandBuffer commandBuffer, const char* name)
+{
+    if (timer == NULL || !timer->supported)
+        return UINT32_MAX;
+
+    struct GpuTimerFrame* frame = &timer->frames[timer->slot];
+    if (frame->regionsCount == GPU_TIMER_REGIONS_MAX)
+        return UINT32_MAX;
+
+    uint32_t region       = frame->regionsCount++;
+    frame->names[region]  = name;
+    frame->depths[region] = timer->depth++;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->pool, 2 * region);
+    return region;
+}
+
+void gpu_timer_end(struct GpuTimer* timer, VkCommandBuffer commandBuffer, uint32_t region)
+{
+    if (timer == NULL || !timer->supported || region == UINT32_MAX)
+        return;
+
+    struct GpuTimerFrame* frame = &timer->frames[timer->slot];
+    vkCmdWriteTimestamp(
+        commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame->pool, 2 * region + 1);
+    timer->depth -= 1;
+}
+
+const struct GpuTimerRegion* gpu_timer_results(const struct GpuTimer* timer,
+                                               uint32_t*              count,
+                                               uint64_t*              frameNumber)
+{
+    *count = timer->resultsCount;
+    if (frameNumber != NULL)
+        *frameNumber = timer->resultsFrame;
+    return timer->results;
+}
+
+void gpu_timer_stats_print(const struct GpuTimer* timer)
+{
+    if (!timer->supported)
+        return;
+
+    printf("gpu %-20s %8s %10s %10s %10s\n", "region", "frames", "avg ms", "min ms", "max ms");
+    for (uint32_t i = 0; i < timer->statsCount; ++i)
+    {
+        const struct GpuTimerStat* stat = &timer->stats[i];
+        printf("    %-20s %8llu %10.3f %10.3f %10.3f\n",
+               stat->name,
+               (unsigned long long) stat->count,
+               stat->totalMs / (double) stat->count,
+               stat->minMs,
+               stat->maxMs);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define GPU_TIMER_FRAMES_MAX  4  /* frame slots a timer can track */
+#define GPU_TIMER_REGIONS_MAX 32 /* named regions per frame, two queries each */
+#define GPU_TIMER_STATS_MAX   64 /* distinct region names summarized */
+/* clang-format on */
+
+enum GpuTimerTraceFormat
+{
+    GPU_TIMER_TRACE_CSV  = 0,
+    GPU_TIMER_TRACE_JSON = 1, /* chrome://tracing, perfetto */
+};
+
+struct GpuTimerRegion
+{
+    const char* name; /* not copied, must outlive the timer */
+    uint32_t    depth;
+    double      startMs; /* from the first timestamp of its frame */
+    double      ms;
+};
+
+/* queries of one frame slot. written into the slot's command buffer and
+ * only read back after the slot's fence has signaled */
+struct GpuTimerFrame
+{
+    VkQueryPool pool;
+    uint32_t    regionsCount;
+    const char* names[GPU_TIMER_REGIONS_MAX];
+    uint32_t    depths[GPU_TIMER_REGIONS_MAX];
+    uint64_t    frameNumber;
+    bool        pending; /* recorded, results not read yet */
+};
+
+struct GpuTimerStat
+{
+    const char* name;
+    uint64_t    count;
+    double      totalMs;
+    double      minMs;
+    double      maxMs;
+};
+
+/* per frame slot timestamp queries around named regions of a frame. the
+ * results of a slot are read when it is recorded again, so they arrive
+ * one slot cycle late and the CPU never waits for them. not thread safe:
+ * regions are written into the frame's primary command buffer only. */
+struct GpuTimer
+{
+    VkDevice device;
+    bool     supported;
+    double   periodNs;  /* timestampPeriod */
+    uint64_t validMask; /* timestampValidBits of the queue family */
+
+    uint32_t             framesCount;
+    struct GpuTimerFrame frames[GPU_TIMER_FRAMES_MAX];
+    uint32_t             slot; /* slot being recorded */
+    uint32_t             depth;
+    uint64_t             frameNumber;
+
+    /* latest frame read back */
+    struct GpuTimerRegion results[GPU_TIMER_REGIONS_MAX];
+    uint32_t              resultsCount;
+    uint64_t              resultsFrame;
+
+    struct GpuTimerStat stats[GPU_TIMER_STATS_MAX];
+    uint32_t            statsCount;
+
+    FILE*                    trace;
+    enum GpuTimerTraceFormat traceFormat;
+    uint64_t                 traceOrigin; /* first timestamp written, ticks */
+    bool                     traceFirst;
+};
+
+/* timer->supported is false (and every other call a no-op) if the queue
+ * family of queueFamilyIndex cannot write timestamps */
+void gpu_timer_init(struct GpuTimer* timer,
+                    VkPhysicalDevice devicePhysical,
+                    VkDevice         device,
+                    uint32_t         queueFamilyIndex,
+                    uint32_t         framesCount);
+
+/* closes the trace file if any */
+void gpu_timer_destroy(struct GpuTimer* timer);
+
+/* writes every read back region to path, format picked by the extension:
+ * .json for a chrome trace, anything else for csv. false if path can not
+ * be opened */
+bool gpu_timer_trace_open(struct GpuTimer* timer, const char* path);
+
+/* call first in the command buffer of frame slot, outside of any render
+ * pass, once its fence has signaled: reads back the slot's previous
+ * results without waiting, then resets its queries */
+void gpu_timer_frame_begin(struct GpuTimer* timer, VkCommandBuffer commandBuffer, uint32_t slot);
+
+/* reads back every pending frame, once the device is idle or all frame
+ * fences have signaled */
+void gpu_timer_flush(struct GpuTimer* timer);
+
+/* opens region name, regions nest. returns the id for gpu_timer_end,
+ * UINT32_MAX if the frame is out of regions */
+uint32_t gpu_timer_begin(struct GpuTimer* timer, VkCommandBuffer commandBuffer, const char* name);
+
+void gpu_timer_end(struct GpuTimer* timer, VkCommandBuffer commandBuffer, uint32_t region);
+
+/* regions of the latest frame read back, frameNumber (may be NULL) gets
+ * the number of that frame, counted from 1 */
+const struct GpuTimerRegion* gpu_timer_results(const struct GpuTimer* timer,
+                                               uint32_t*              count,
+                                               uint64_t*              frameNumber);
+
+/* count, avg, min and max per region name over every frame read back */
+void gpu_timer_stats_print(const struct GpuTimer* timer);
@@ -0,0 +1,380 @@
+#include "hot_reload.h"
+
+#include "profiler.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define HOT_RELOAD_DEBOUNCE_MS 50 /* editors write a file in several steps */
+
+#ifdef __linux__
+
+/* runs the compiler on the GLSL of stage, writing SPIR-V to output. the
+ * arguments go to execvp as they are, no shell sees the paths. true if it
+ * succeeded, false with its output in log */
+static bool hot_reload_run(struct HotReload* reload,
+                           uint32_t          stage,
+                           const char*       output,
+                           char*             log,
+                           size_t            logSize)
+{
+    char source[2 * HOT_RELOAD_PATH_MAX];
+    snprintf(source, sizeof(source), "%s/%s", reload->dir, reload->sources[stage]);
+    char* const arguments[] = {
+        (char*) reload->compiler, "-V", "-o", (char*) output, source, NULL};
+
+    /* close on exec, so no other child holds the pipe open */
+    int logPipe[2];
+    if (pipe(logPipe) != 0)
+    {
+        snprintf(log, logSize, "pipe error\n");
+        return false;
+    }
+    fcntl(logPipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(logPipe[1], F_SETFD, FD_CLOEXEC);
+
+    pid_t child = fork();
+    if (child < 0)
+    {
+        close(logPipe[0]);
+        close(logPipe[1]);
+        snprintf(log, logSize, "fork error\n");
+        return false;
+    }
+    if (child == 0)
+    {
+        /* async signal safe calls only, the parent has other threads */
+        dup2(logPipe[1], STDOUT_FILENO);
+        dup2(logPipe[1], STDERR_FILENO);
+        execvp(arguments[0], arguments);
+        static const char error[] = "can not run the compiler\n";
+        ssize_t           written = write(STDERR_FILENO, error, sizeof(error) - 1);
+        (void) written;
+        _exit(127);
+    }
+    close(logPipe[1]);
+
+    size_t  used = 0;
+    ssize_t size;
+    char    rest[256];
+    /* drain everything so the compiler never blocks on a full pipe */
+    while ((size = read(logPipe[0], rest, sizeof(rest))) != 0)
+    {
+        if (size < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        size_t copied = (size_t) size < logSize - 1 - used ? (size_t) size : logSize - 1 - used;
+        memcpy(log + used, rest, copied);
+        used += copied;
+    }
+    log[used] = '\0';
+    close(logPipe[0]);
+
+    int status = 0;
+    while (waitpid(child, &status, 0) < 0)
+        if (errno != EINTR)
+            return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* compiles the GLSL of stage into a new module, VK_NULL_HANDLE with the
+ * compiler output on stderr if that fails */
+static VkShaderModule hot_reload_compile(struct HotReload* reload, uint32_t stage)
+{
+    /* mkstemp picks a name nobody else can have created first */
+    char output[HOT_RELOAD_PATH_MAX];
+    snprintf(output,
+             sizeof(output),
+             "%s/tjtech1-XXXXXX",
+             getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp");
+    int outputFile = mkstemp(output);
+    if (outputFile < 0)
+    {
+        fprintf(stderr, "hot reload: can not create %s\n", output);
+        return VK_NULL_HANDLE;
+    }
+    close(outputFile);
+
+    char log[8192];
+    if (!hot_reload_run(reload, stage, output, log, sizeof(log)))
+    {
+        fprintf(stderr,
+                "hot reload: %s failed, keeping the old pipeline\n%s",
+                reload->sources[stage],
+                log);
+        remove(output);
+        return VK_NULL_HANDLE;
+    }
+
+    char* code = NULL;
+    int   size = ae_load_file_to_memory(output, &code);
+    remove(output);
+    if (size <= 0 || size % sizeof(uint32_t) != 0)
+    {
+        fprintf(stderr, "hot reload: %s read error\n", output);
+        free(code);
+        return VK_NULL_HANDLE;
+    }
+
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize                 = (size_t) size;
+    moduleInfo.pCode                    = (const uint32_t*) code;
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(reload->device, &moduleInfo, NULL, &module) != VK_SUCCESS)
+    {
+        fprintf(stderr, "hot reload: %s shaderModule create error\n", reload->sources[stage]);
+        module = VK_NULL_HANDLE;
+    }
+    free(code);
+    return module;
+}
+
+/* rebuilds the pipeline with the changed stages and hands it to the render
+ * thread. the previous modules of the changed stages are no longer needed:
+ * pipelines do not reference their modules once created */
+static void hot_reload_build(struct HotReload* reload, const bool* changed)
+{
+    PROFILE_SCOPE("hot reload build");
+    uint64_t start = util_time_ns();
+
+    VkShaderModule modules[HOT_RELOAD_STAGES_MAX] = {};
+    uint32_t       stagesCount                    = reload->pipelineInfo.stageCount;
+    for (uint32_t i = 0; i < stagesCount; ++i)
+    {
+        if (!changed[i])
+            continue;
+        modules[i] = hot_reload_compile(reload, i);
+        if (modules[i] == VK_NULL_HANDLE)
+        {
+            for (uint32_t j = 0; j < i; ++j)
+                if (modules[j] != VK_NULL_HANDLE)
+                    vkDestroyShaderModule(reload->device, modules[j], NULL);
+            return;
+        }
+    }
+    uint64_t compiled = util_time_ns();
+
+    VkPipelineShaderStageCreateInfo stages[HOT_RELOAD_STAGES_MAX];
+    memcpy(stages, reload->stages, sizeof(stages));
+    for (uint32_t i = 0; i < stagesCount; ++i)
+        if (modules[i] != VK_NULL_HANDLE)
+            stages[i].module = modules[i];
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = reload->pipelineInfo;
+    pipelineInfo.pStages                      = stages;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(
+            reload->device, reload->cache, 1, &pipelineInfo, NULL, &pipeline) != VK_SUCCESS)
+    {
+        fprintf(stderr, "hot reload: pipeline create error, keeping the old pipeline\n");
+        for (uint32_t i = 0; i < stagesCount; ++i)
+            if (modules[i] != VK_NULL_HANDLE)
+                vkDestroyShaderModule(reload->device, modules[i], NULL);
+        return;
+    }
+
+    for (uint32_t i = 0; i < stagesCount; ++i)
+    {
+        if (modules[i] == VK_NULL_HANDLE)
+            continue;
+        if (reload->owned[i])
+            vkDestroyShaderModule(reload->device, reload->stages[i].module, NULL);
+        reload->stages[i].module = modules[i];
+        reload->owned[i]         = true;
+    }
+
+    pthread_mutex_lock(&reload->mutex);
+    /* a build the render thread has not picked up yet was never used */
+    if (reload->ready != VK_NULL_HANDLE)
+        vkDestroyPipeline(reload->device, reload->ready, NULL);
+    reload->ready = pipeline;
+    pthread_mutex_unlock(&reload->mutex);
+
+    uint64_t end = util_time_ns();
+    printf("hot reload: pipeline rebuilt in %.3f ms (compile %.3f ms)\n",
+           (double) (end - start) / 1e6,
+           (double) (compiled - start) / 1e6);
+}
+
+/* marks the stages named by the events in buffer */
+static void hot_reload_events(struct HotReload* reload,
+                              const char*       buffer,
+                              ssize_t           size,
+                              bool*             changed)
+{
+    for (ssize_t offset = 0; offset < size;)
+    {
+        const struct inotify_event* event = (const struct inotify_event*) (buffer + offset);
+        for (uint32_t i = 0; i < reload->pipelineInfo.stageCount && event->len > 0; ++i)
+            if (strcmp(event->name, reload->sources[i]) == 0)
+                changed[i] = true;
+        offset += (ssize_t) sizeof(*event) + event->len;
+    }
+}
+
+static void* hot_reload_worker(void* argument)
+{
+    struct HotReload* reload = argument;
+    PROFILE_THREAD("hot reload");
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (!atomic_load(&reload->quit))
+    {
+        /* wake up now and then to see quit */
+        struct pollfd pollNotify = {reload->notify, POLLIN, 0};
+        if (poll(&pollNotify, 1, 100) <= 0)
+            continue;
+
+        bool changed[HOT_RELOAD_STAGES_MAX] = {};
+        bool any                            = false;
+        for (;;)
+        {
+            ssize_t size = read(reload->notify, buffer, sizeof(buffer));
+            if (size > 0)
+            {
+                hot_reload_events(reload, buffer, size, changed);
+                continue;
+            }
+            /* drained, give the editor time to finish writing */
+            if (poll(&pollNotify, 1, HOT_RELOAD_DEBOUNCE_MS) <= 0)
+                break;
+        }
+        for (uint32_t i = 0; i < reload->pipelineInfo.stageCount; ++i)
+            any |= changed[i];
+        if (any && !atomic_load(&reload->quit))
+            hot_reload_build(reload, changed);
+    }
+    return NULL;
+}
+
+#endif
+
+bool hot_reload_start(struct HotReload*                   reload,
+                      VkDevice                            device,
+                      VkPipelineCache                     cache,
+                      const VkGraphicsPipelineCreateInfo* pipelineInfo,
+                      const char* const*                  sources,
+                      const char*                         dir,
+                      const char*                         compiler)
+{
+    *reload = (struct HotReload){};
+#ifdef __linux__
+    if (pipelineInfo->stageCount > HOT_RELOAD_STAGES_MAX || strlen(dir) >= HOT_RELOAD_PATH_MAX)
+        return false;
+
+    reload->device       = device;
+    reload->cache        = cache;
+    reload->pipelineInfo = *pipelineInfo;
+    reload->compiler     = compiler;
+    memcpy(reload->stages,
+           pipelineInfo->pStages,
+           pipelineInfo->stageCount * sizeof(reload->stages[0]));
+    memcpy(reload->sources, sources, pipelineInfo->stageCount * sizeof(reload->sources[0]));
+    strcpy(reload->dir, dir);
+
+    reload->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    /* editors save in place (CLOSE_WRITE) or write a copy and rename it (MOVED_TO) */
+    if (reload->notify < 0 ||
+        inotify_add_watch(reload->notify, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        fprintf(stderr, "hot reload: can not watch %s\n", dir);
+        if (reload->notify >= 0)
+            close(reload->notify);
+        return false;
+    }
+
+    pthread_mutex_init(&reload->mutex, NULL);
+    atomic_init(&reload->quit, false);
+    if (pthread_create(&reload->thread, NULL, hot_reload_worker, reload) != 0)
+    {
+        fprintf(stderr, "hot reload thread create error\n");
+        exit(EXIT_FAILURE);
+    }
+    reload->running = true;
+    printf("hot reload: watching %s\n", dir);
+    return true;
+#else
+    (void) device;
+    (void) cache;
+    (void) pipelineInfo;
+    (void) sources;
+    (void) dir;
+    (void) compiler;
+    fprintf(stderr, "hot reload needs inotify (linux)\n");
+    return false;
+#endif
+}
+
+bool hot_reload_poll(struct HotReload* reload,
+                     VkPipeline*       pipeline,
+                     uint64_t          frame,
+                     uint32_t          framesInFlight)
+{
+    if (!reload->running)
+        return false;
+
+    /* frames up to frame - framesInFlight - 1 have completed */
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < reload->retiredCount; ++i)
+    {
+        if (frame >= reload->retired[i].frame)
+            vkDestroyPipeline(reload->device, reload->retired[i].pipeline, NULL);
+        else
+            reload->retired[kept++] = reload->retired[i];
+    }
+    reload->retiredCount = kept;
+
+    /* full: keep the current pipeline a little longer */
+    if (reload->retiredCount == HOT_RELOAD_RETIRED_MAX ||
+        pthread_mutex_trylock(&reload->mutex) != 0)
+        return false;
+    VkPipeline ready = reload->ready;
+    reload->ready    = VK_NULL_HANDLE;
+    pthread_mutex_unlock(&reload->mutex);
+    if (ready == VK_NULL_HANDLE)
+        return false;
+
+    struct HotReloadRetired* retired = &reload->retired[reload->retiredCount++];
+    retired->pipeline                = *pipeline;
+    retired->frame                   = frame + framesInFlight;
+    *pipeline                        = ready;
+    return true;
+}
+
+void hot_reload_stop(struct HotReload* reload)
+{
+    if (!reload->running)
+        return;
+
+#ifdef __linux__
+    atomic_store(&reload->quit, true);
+    pthread_join(reload->thread, NULL);
+    close(reload->notify);
+#endif
+    pthread_mutex_destroy(&reload->mutex);
+
+    if (reload->ready != VK_NULL_HANDLE)
+        vkDestroyPipeline(reload->device, reload->ready, NULL);
+    for (uint32_t i = 0; i < reload->retiredCount; ++i)
+        vkDestroyPipeline(reload->device, reload->retired[i].pipeline, NULL);
+    for (uint32_t i = 0; i < reload->pipelineInfo.stageCount; ++i)
+        if (reload->owned[i])
+            vkDestroyShaderModule(reload->device, reload->stages[i].module, NULL);
+    *reload = (struct HotReload){};
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define HOT_RELOAD_STAGES_MAX  4
+#define HOT_RELOAD_RETIRED_MAX 8  /* swapped out pipelines waiting for their frames */
+#define HOT_RELOAD_PATH_MAX    1024
+/* clang-format on */
+
+struct HotReloadRetired
+{
+    VkPipeline pipeline;
+    uint64_t   frame; /* destroyable once this many frames were submitted */
+};
+
+/* watches the GLSL sources of one graphics pipeline with inotify. a worker
+ * thread recompiles a changed stage with glslangValidator and builds a new
+ * VkShaderModule and VkPipeline, the render loop picks the pipeline up at a
+ * frame boundary with hot_reload_poll and never waits for a build. linux
+ * only, hot_reload_start fails elsewhere. */
+struct HotReload
+{
+    VkDevice                        device;
+    VkPipelineCache                 cache;
+    VkGraphicsPipelineCreateInfo    pipelineInfo; /* pointers stay the caller's */
+    VkPipelineShaderStageCreateInfo stages[HOT_RELOAD_STAGES_MAX];
+    const char*                     sources[HOT_RELOAD_STAGES_MAX]; /* file names in dir */
+    bool                            owned[HOT_RELOAD_STAGES_MAX];   /* module built here */
+    char                            dir[HOT_RELOAD_PATH_MAX];
+    const char*                     compiler;
+
+    pthread_t   thread;
+    int         notify;
+    atomic_bool quit;
+    bool        running;
+
+    pthread_mutex_t mutex;
+    VkPipeline      ready; /* built, not picked up yet, guarded by mutex */
+
+    /* render thread only */
+    struct HotReloadRetired retired[HOT_RELOAD_RETIRED_MAX];
+    uint32_t                retiredCount;
+};
+
+/* starts watching dir for sources[i], the GLSL file of pipelineInfo's
+ * pStages[i]. the modules in pipelineInfo stay the caller's, everything
+ * pipelineInfo points to must outlive the watcher. false if dir can not be
+ * watched */
+bool hot_reload_start(struct HotReload*                   reload,
+                      VkDevice                            device,
+                      VkPipelineCache                     cache,
+                      const VkGraphicsPipelineCreateInfo* pipelineInfo,
+                      const char* const*                  sources,
+                      const char*                         dir,
+                      const char*                         compiler);
+
+/* call at a frame boundary with the number of frames submitted so far.
+ * swaps in a rebuilt pipeline (true if it did) and destroys swapped out
+ * ones once framesInFlight more frames were submitted, so the GPU is done
+ * with them without waiting on a fence */
+bool hot_reload_poll(struct HotReload* reload,
+                     VkPipeline*       pipeline,
+                     uint64_t          frame,
+                     uint32_t          framesInFlight);
+
+/* joins the worker and destroys what it built but the current pipeline.
+ * the device must be idle */
+void hot_reload_stop(struct HotReload* reload);
@@ -0,0 +1,119 @@
+#include "jobs.h"
+
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+uint32_t jobs_cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = (long) info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (uint32_t) count : 1;
+}
+
+/* takes jobs of the current batch until none are left, mutex held on entry and exit */
+static void jobs_drain(struct Jobs* jobs)
+{
+    while (jobs->next < jobs->count)
+    {
+        uint32_t    index    = jobs->next++;
+        JobFunction function = jobs->function;
+        void*       context  = jobs->context;
+
+        pthread_mutex_unlock(&jobs->mutex);
+        function(context, index);
+        pthread_mutex_lock(&jobs->mutex);
+
+        if (--jobs->pending == 0)
+            pthread_cond_signal(&jobs->done);
+    }
+}
+
+static void* jobs_worker(void* argument)
+{
+    struct Jobs* jobs = argument;
+    uint64_t     seen = 0;
+    PROFILE_THREAD("job worker");
+
+    pthread_mutex_lock(&jobs->mutex);
+    for (;;)
+    {
+        while (!jobs->quit && jobs->generation == seen)
+            pthread_cond_wait(&jobs->start, &jobs->mutex);
+        if (jobs->quit)
+            break;
+
+        seen = jobs->generation;
+        jobs_drain(jobs);
+    }
+    pthread_mutex_unlock(&jobs->mutex);
+    return NULL;
+}
+
+void jobs_init(struct Jobs* jobs, uint32_t threadsCount)
+{
+    *jobs              = (struct Jobs){};
+    jobs->workersCount = threadsCount > 1 ? threadsCount - 1 : 0;
+    jobs->workers      = calloc(jobs->workersCount ? jobs->workersCount : 1, sizeof(pthread_t));
+    pthread_mutex_init(&jobs->mutex, NULL);
+    pthread_cond_init(&jobs->start, NULL);
+    pthread_cond_init(&jobs->done, NULL);
+
+    for (uint32_t i = 0; i < jobs->workersCount; ++i)
+    {
+        if (pthread_create(&jobs->workers[i], NULL, jobs_worker, jobs) != 0)
+        {
+            fprintf(stderr, "jobs worker create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void jobs_destroy(struct Jobs* jobs)
+{
+    pthread_mutex_lock(&jobs->mutex);
+    jobs->quit = true;
+    pthread_cond_broadcast(&jobs->start);
+    pthread_mutex_unlock(&jobs->mutex);
+
+    for (uint32_t i = 0; i < jobs->workersCount; ++i)
+        pthread_join(jobs->workers[i], NULL);
+
+    pthread_cond_destroy(&jobs->done);
+    pthread_cond_destroy(&jobs->start);
+    pthread_mutex_destroy(&jobs->mutex);
+    free(jobs->workers);
+    *jobs = (struct Jobs){};
+}
+
+void jobs_run(struct Jobs* jobs, JobFunction function, void* context, uint32_t count)
+{
+    if (count == 0)
+        return;
+
+    pthread_mutex_lock(&jobs->mutex);
+    jobs->function = function;
+    jobs->context  = context;
+    jobs->count    = count;
+    jobs->next     = 0;
+    jobs->pending  = count;
+    ++jobs->generation;
+    if (jobs->workersCount > 0 && count > 1)
+        pthread_cond_broadcast(&jobs->start);
+
+    jobs_drain(jobs);
+    while (jobs->pending > 0)
+        pthread_cond_wait(&jobs->done, &jobs->mutex);
+    pthread_mutex_unlock(&jobs->mutex);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* called once per index, from any thread of the pool */
+typedef void (*JobFunction)(void* context, uint32_t index);
+
+/* fixed set of worker threads that run one batch of jobs at a time. the
+ * calling thread takes part in every batch, so a pool of n threads starts
+ * n - 1 workers. */
+struct Jobs
+{
+    pthread_t*      workers;
+    uint32_t        workersCount;
+    pthread_mutex_t mutex;
+    pthread_cond_t  start;
+    pthread_cond_t  done;
+
+    /* current batch, guarded by mutex */
+    JobFunction function;
+    void*       context;
+    uint32_t    count;
+    uint32_t    next;
+    uint32_t    pending;
+    uint64_t    generation;
+    bool        quit;
+};
+
+/* number of online CPUs, at least 1 */
+uint32_t jobs_cpu_count(void);
+
+void jobs_init(struct Jobs* jobs, uint32_t threadsCount);
+
+void jobs_destroy(struct Jobs* jobs);
+
+/* runs function(context, i) for i in [0, count) and returns when all are done */
+void jobs_run(struct Jobs* jobs, JobFunction function, void* context, uint32_t count);
+
+static inline uint32_t jobs_threads_count(const struct Jobs* jobs)
+{
+    return jobs->workersCount + 1;
+}
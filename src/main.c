@@ -1,19 +1,58 @@
 #include "main.h"
 
+#include "allocator.h"
+#include "bench.h"
+#include "bindless.h"
+#include "buffer.h"
+#include "cull.h"
+#include "device.h"
+#include "frame.h"
+#include "gpu_timer.h"
+#include "hot_reload.h"
+#include "mesh.h"
+#include "mesh_import.h"
+#include "mesh_optimize.h"
+#include "pack.h"
+#include "pipeline_cache.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "scene.h"
+#include "shaders.h"
+#include "swapchain.h"
+#include "texture.h"
+#include "uniform.h"
 #include "util.h"
+#include "vecmath.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* per-frame slots are sized at compile time, every frame in flight needs one */
+_Static_assert(BINDLESS_SLOTS_MAX >= MAX_FRAMES_IN_FLIGHT, "a bindless set per frame slot");
+_Static_assert(CULL_SLOTS_MAX >= MAX_FRAMES_IN_FLIGHT, "a cull count per frame slot");
+_Static_assert(GPU_TIMER_FRAMES_MAX >= MAX_FRAMES_IN_FLIGHT, "timestamps per frame slot");
+_Static_assert(SCENE_FRAMES_MAX >= MAX_FRAMES_IN_FLIGHT, "an instance buffer per frame slot");
+_Static_assert(TEXTURE_SLOTS_MAX >= MAX_FRAMES_IN_FLIGHT, "a texture ticket per frame slot");
+
 void error_glfw_callback(int error, const char* description)
 {
     fprintf(stderr, "Error (%d): %s\n", error, description);
 }
 
+/* the window user pointer is the draw loop's resize flag */
+void framebuffer_size_glfw_callback(GLFWwindow* window, int width, int height)
+{
+    (void) width;
+    (void) height;
+    bool* framebufferResized = glfwGetWindowUserPointer(window);
+    *framebufferResized      = true;
+}
+
 VkBool32 vk_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
                            VkDebugUtilsMessageTypeFlagsEXT             messageTypes,
                            const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
@@ -25,35 +64,541 @@ VkBool32 vk_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT      messageSe
     return VK_FALSE;
 }
 
-int main(void)
+struct PresentModeName
 {
-    /***************************************************************************/
-    /*                                   GLFW                                  */
-    /***************************************************************************/
-    /* init ********************************************************************/
-    glfwSetErrorCallback(error_glfw_callback);
+    VkPresentModeKHR mode;
+    const char*      name;
+};
+
+static const struct PresentModeName presentModeNames[] = {
+    {VK_PRESENT_MODE_IMMEDIATE_KHR, "immediate"},
+    {VK_PRESENT_MODE_MAILBOX_KHR, "mailbox"},
+    {VK_PRESENT_MODE_FIFO_KHR, "fifo"},
+    {VK_PRESENT_MODE_FIFO_RELAXED_KHR, "fifo-relaxed"},
+};
+#define PRESENT_MODE_NAMES_COUNT (sizeof(presentModeNames) / sizeof(presentModeNames[0]))
+
+const char* present_mode_name(VkPresentModeKHR mode)
+{
+    for (size_t i = 0; i < PRESENT_MODE_NAMES_COUNT; ++i)
+    {
+        if (presentModeNames[i].mode == mode)
+            return presentModeNames[i].name;
+    }
+    return "unknown";
+}
 
-    printf("Compiled against GLFW %i.%i.%i\n",
-           GLFW_VERSION_MAJOR,
-           GLFW_VERSION_MINOR,
-           GLFW_VERSION_REVISION);
+bool present_mode_parse(const char* name, VkPresentModeKHR* mode)
+{
+    for (size_t i = 0; i < PRESENT_MODE_NAMES_COUNT; ++i)
+    {
+        if (strcmp(presentModeNames[i].name, name) == 0)
+        {
+            *mode = presentModeNames[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+void usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --headless      render offscreen without a window or surface\n"
+            "  --frames <n>    number of frames to render in headless mode (default %d,\n"
+            "                  %d per step in benchmarks)\n"
+            "  --present-mode <immediate|mailbox|fifo|fifo-relaxed>\n"
+            "                  present mode, falls back to fifo if unsupported\n"
+            "                  (default: mailbox if supported, else fifo)\n"
+            "  --frames-in-flight <n>\n"
+            "                  frames the CPU may queue ahead, 1 to %d (default %d)\n"
+            "  --record-threads <n>\n"
+            "                  record secondary command buffers on n threads\n"
+            "                  (default 0, record inline on the main thread)\n"
+            "  --bench-instancing\n"
+            "                  headless, draw 1 to 1M instances of a mesh per call\n"
+            "  --bench-recording\n"
+            "                  headless, time recording of the draw list on 1 to all cores\n"
+            "  --draws <n>     draws in the recording benchmark (default %d)\n"
+            "  --bench-pipelines\n"
+            "                  headless, time to first frame with pipeline variants\n"
+            "                  compiled up front or on worker threads\n"
+            "  --pipelines <n> variants in the pipeline benchmark, 1 to %d (default %d)\n"
+            "  --bench-upload  headless, frame times while streaming %d MiB per frame\n"
+            "                  with blocking uploads and through the transfer queue\n"
+            "  --mesh <file.obj>\n"
+            "                  import and draw a mesh instead of the triangle\n"
+            "  --gpu-culling   cull and emit the draws in a compute pass, drawn indirect\n"
+            "  --bench-culling\n"
+            "                  headless, frame times with 10k to 1M objects culled on\n"
+            "                  the CPU and in the compute pass\n"
+            "  --bench-textures\n"
+            "                  headless, stream %d textures, %d in use at a time, under\n"
+            "                  the texture budget\n"
+            "  --texture-budget <MiB>\n"
+            "                  memory of streamed texture images (default %d)\n"
+            "  --bench-draw-data\n"
+            "                  headless, %d draws with a transform each, pushed, in the\n"
+            "                  uniform ring or read from a storage buffer\n"
+            "  --bench-math    CPU only, time the math kernels on %d elements with the\n"
+            "                  scalar, SSE2 and AVX2 paths\n"
+            "  --bench-scene   headless, update and draw %d entities of the SoA scene\n"
+            "                  and of one heap object per entity\n"
+            "  --bench-latency\n"
+            "                  windowed, measure throughput and submit latency for every\n"
+            "                  present mode and frames in flight combination\n"
+            "  --gpu-timings   time GPU regions with timestamp queries, summary on exit\n"
+            "  --gpu-trace <file>\n"
+            "                  --gpu-timings and write every frame to a .csv or .json file\n"
+            "  --profile <file.json>\n"
+            "                  print CPU phase timings on exit and write a chrome trace\n"
+            "  --shader-dir <dir>\n"
+            "                  load .spv files found in dir instead of the embedded ones\n"
+            "  --pack <file>   map an asset pack (see tjpack), its shaders win over the\n"
+            "                  embedded ones\n"
+            "  --hot-reload    watch the GLSL sources (TJTECH1_SHADER_SOURCE, default\n"
+            "                  %s) and swap in a rebuilt pipeline on change\n"
+            "  --pipeline-cache <file>\n"
+            "                  pipeline cache file (default %s)\n"
+            "  --no-pipeline-cache\n"
+            "                  compile pipelines without a cache\n"
+            "environment: TJTECH1_PRESENT_MODE, TJTECH1_FRAMES_IN_FLIGHT,\n"
+            "             TJTECH1_SHADER_DIR (options win)\n",
+            name,
+            HEADLESS_FRAMES_DEFAULT,
+            BENCH_FRAMES_DEFAULT,
+            MAX_FRAMES_IN_FLIGHT,
+            FRAMES_IN_FLIGHT_DEFAULT,
+            BENCH_DRAWS_DEFAULT,
+            BENCH_PIPELINES_MAX,
+            BENCH_PIPELINES_DEFAULT,
+            BENCH_UPLOAD_CHUNK >> 20,
+            BENCH_TEXTURES,
+            BENCH_TEXTURES_WINDOW,
+            TEXTURE_BUDGET_DEFAULT,
+            BENCH_DRAW_DATA_DRAWS,
+            BENCH_MATH_COUNT,
+            BENCH_SCENE_ENTITIES,
+            TJTECH1_SHADER_SOURCE_DIR,
+            PIPELINE_CACHE_FILE);
+}
 
-    printf("%s\n", glfwGetVersionString());
+struct Options parse_options(int argc, char** argv)
+{
+    struct Options options  = {};
+    options.headless        = false;
+    options.frames          = 0; /* 0: default of the mode */
+    options.pipelineCache   = PIPELINE_CACHE_FILE;
+    options.recordThreads   = 0;
+    options.benchInstancing = false;
+    options.benchRecording  = false;
+    options.draws           = BENCH_DRAWS_DEFAULT;
+    options.presentMode     = getenv("TJTECH1_PRESENT_MODE");
+    options.framesInFlight  = FRAMES_IN_FLIGHT_DEFAULT;
+    options.benchLatency    = false;
+    options.gpuTimings      = false;
+    options.gpuTrace        = NULL;
+    options.profile         = NULL;
+    options.shaderDir       = getenv("TJTECH1_SHADER_DIR");
+    options.pack            = NULL;
+    options.hotReload       = false;
+    options.benchPipelines  = false;
+    options.pipelines       = BENCH_PIPELINES_DEFAULT;
+    options.benchUpload     = false;
+    options.gpuCulling      = false;
+    options.benchCulling    = false;
+    options.mesh            = NULL;
+    options.benchTextures   = false;
+    options.textureBudget   = TEXTURE_BUDGET_DEFAULT;
+    options.benchDrawData   = false;
+    options.benchMath       = false;
+    options.benchScene      = false;
+
+    const char* framesInFlight = getenv("TJTECH1_FRAMES_IN_FLIGHT");
+    if (framesInFlight != NULL)
+    {
+        options.framesInFlight = (uint32_t) strtoul(framesInFlight, NULL, 10);
+    }
 
-    if (!glfwInit())
+    for (int i = 1; i < argc; ++i)
     {
-        glfwTerminate();
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            options.headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            options.frames = (uint32_t) strtoul(argv[++i], NULL, 10);
+            if (options.frames == 0)
+            {
+                fprintf(stderr, "--frames must be greater than 0\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc)
+        {
+            options.shaderDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+        {
+            options.pack = argv[++i];
+        }
+        else if (strcmp(argv[i], "--hot-reload") == 0)
+        {
+            options.hotReload = true;
+        }
+        else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc)
+        {
+            options.pipelineCache = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-pipeline-cache") == 0)
+        {
+            options.pipelineCache = NULL;
+        }
+        else if (strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+        {
+            options.presentMode = argv[++i];
+        }
+        else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+        {
+            options.framesInFlight = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-latency") == 0)
+        {
+            options.benchLatency = true;
+        }
+        else if (strcmp(argv[i], "--gpu-timings") == 0)
+        {
+            options.gpuTimings = true;
+        }
+        else if (strcmp(argv[i], "--gpu-trace") == 0 && i + 1 < argc)
+        {
+            options.gpuTrace   = argv[++i];
+            options.gpuTimings = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            options.profile = argv[++i];
+            if (!PROFILER_ENABLED)
+            {
+                fprintf(stderr, "--profile needs a build with TJTECH1_PROFILER=ON\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc)
+        {
+            options.recordThreads = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-instancing") == 0)
+        {
+            options.benchInstancing = true;
+            options.headless        = true;
+        }
+        else if (strcmp(argv[i], "--bench-recording") == 0)
+        {
+            options.benchRecording = true;
+            options.headless       = true;
+        }
+        else if (strcmp(argv[i], "--draws") == 0 && i + 1 < argc)
+        {
+            options.draws = (uint32_t) strtoul(argv[++i], NULL, 10);
+            if (options.draws == 0)
+            {
+                fprintf(stderr, "--draws must be greater than 0\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--bench-pipelines") == 0)
+        {
+            options.benchPipelines = true;
+            options.headless       = true;
+        }
+        else if (strcmp(argv[i], "--bench-upload") == 0)
+        {
+            options.benchUpload = true;
+            options.headless    = true;
+        }
+        else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc)
+        {
+            options.mesh = argv[++i];
+        }
+        else if (strcmp(argv[i], "--gpu-culling") == 0)
+        {
+            options.gpuCulling = true;
+        }
+        else if (strcmp(argv[i], "--bench-culling") == 0)
+        {
+            options.benchCulling = true;
+            options.headless     = true;
+        }
+        else if (strcmp(argv[i], "--bench-textures") == 0)
+        {
+            options.benchTextures = true;
+            options.headless      = true;
+        }
+        else if (strcmp(argv[i], "--bench-draw-data") == 0)
+        {
+            options.benchDrawData = true;
+            options.headless      = true;
+        }
+        else if (strcmp(argv[i], "--bench-math") == 0)
+        {
+            options.benchMath = true;
+        }
+        else if (strcmp(argv[i], "--bench-scene") == 0)
+        {
+            options.benchScene = true;
+            options.headless   = true;
+        }
+        else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+        {
+            options.textureBudget = (uint32_t) strtoul(argv[++i], NULL, 10);
+            if (options.textureBudget == 0)
+            {
+                fprintf(stderr, "--texture-budget must be greater than 0\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--pipelines") == 0 && i + 1 < argc)
+        {
+            options.pipelines = (uint32_t) strtoul(argv[++i], NULL, 10);
+            if (options.pipelines == 0 || options.pipelines > BENCH_PIPELINES_MAX)
+            {
+                fprintf(stderr, "--pipelines must be 1 to %d\n", BENCH_PIPELINES_MAX);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else
+        {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    VkPresentModeKHR presentMode;
+    if (options.presentMode != NULL && !present_mode_parse(options.presentMode, &presentMode))
+    {
+        fprintf(stderr, "unknown present mode: %s\n", options.presentMode);
         exit(EXIT_FAILURE);
     }
+    if (options.framesInFlight < 1 || options.framesInFlight > MAX_FRAMES_IN_FLIGHT)
+    {
+        fprintf(stderr, "frames in flight must be 1 to %d\n", MAX_FRAMES_IN_FLIGHT);
+        exit(EXIT_FAILURE);
+    }
+    if (options.benchLatency && options.headless)
+    {
+        fprintf(stderr, "--bench-latency needs a window\n");
+        exit(EXIT_FAILURE);
+    }
+    if (options.hotReload && options.headless)
+    {
+        fprintf(stderr, "--hot-reload needs a window\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (options.frames == 0)
+    {
+        bool bench = options.benchInstancing || options.benchRecording || options.benchLatency ||
+                     options.benchUpload || options.benchCulling || options.benchTextures ||
+                     options.benchDrawData || options.benchMath || options.benchScene;
+        options.frames = bench ? BENCH_FRAMES_DEFAULT : HEADLESS_FRAMES_DEFAULT;
+    }
+
+    return options;
+}
+
+/* state of the windowed draw loop */
+struct Presenter
+{
+    GLFWwindow*             window;
+    bool*                   framebufferResized;
+    VkDevice                device;
+    VkQueue                 graphicsQueue;
+    VkQueue                 presentQueue;
+    VkRenderPass            renderPass;
+    struct Swapchain*       swapchain;
+    struct SwapchainConfig* swapchainConfig;
+    struct Frame*           frames;
+    uint32_t                framesInFlight;
+    uint32_t                currentFrame;
+    VkFence                 imagesInFlight[SWAPCHAIN_IMAGES_MAX]; /* see frame_claim_image */
+};
+
+/* rebuilds the swapChain for the window's current framebuffer size, waits
+ * while the window is minimized. views, framebuffers and the next
+ * recordings change, render pass and pipeline are kept. */
+void presenter_recreate(struct Presenter* presenter, struct FrameRecord* record)
+{
+    int width, height;
+    glfwGetFramebufferSize(presenter->window, &width, &height);
+    while ((width == 0 || height == 0) && !glfwWindowShouldClose(presenter->window))
+    {
+        glfwWaitEvents();
+        glfwGetFramebufferSize(presenter->window, &width, &height);
+    }
+    if (width == 0 || height == 0)
+        return;
+
+    uint64_t idleStart = util_time_ns();
+    vkDeviceWaitIdle(presenter->device);
+    uint64_t recreateStart = util_time_ns();
+
+    VkExtent2D extent = {(uint32_t) width, (uint32_t) height};
+    swapchain_recreate(
+        presenter->swapchain, presenter->swapchainConfig, presenter->renderPass, extent);
+    record->pass.extent = presenter->swapchain->extent;
+    for (uint32_t i = 0; i < SWAPCHAIN_IMAGES_MAX; ++i)
+        presenter->imagesInFlight[i] = VK_NULL_HANDLE;
+    *presenter->framebufferResized = false;
+
+    uint64_t recreateEnd = util_time_ns();
+    printf("swapChain recreate %dx%d, %d image(s), %s: %.3f ms (+%.3f ms device idle)\n",
+           presenter->swapchain->extent.width,
+           presenter->swapchain->extent.height,
+           presenter->swapchain->imagesCount,
+           present_mode_name(presenter->swapchainConfig->presentMode),
+           (double) (recreateEnd - recreateStart) / 1e6,
+           (double) (recreateStart - idleStart) / 1e6);
+}
+
+/* waits for a free frame, acquires, records, submits and presents. returns
+ * false if the swapChain was out of date and nothing was submitted */
+bool presenter_frame(struct Presenter*   presenter,
+                     struct FrameRecord* record,
+                     struct Samples*     latencies)
+{
+    VkDevice      device = presenter->device;
+    struct Frame* frame  = &presenter->frames[presenter->currentFrame];
+
+    PROFILE_BEGIN(wait, "wait");
+    frames_poll(device, presenter->frames, presenter->framesInFlight, latencies);
+    frame_wait(device, frame, latencies);
+    PROFILE_END(wait);
+
+    PROFILE_BEGIN(acquire, "acquire");
+    uint32_t imageIndex;
+    VkResult acquireResult = vkAcquireNextImageKHR(device,
+                                                   presenter->swapchain->swapchain,
+                                                   UINT64_MAX,
+                                                   frame->imageAvailable,
+                                                   VK_NULL_HANDLE,
+                                                   &imageIndex);
+    PROFILE_END(acquire);
+    if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        /* nothing was submitted, the fence stays signaled */
+        presenter_recreate(presenter, record);
+        return false;
+    }
+    else if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+    {
+        fprintf(stderr, "swapChain acquire error: %d\n", acquireResult);
+        exit(EXIT_FAILURE);
+    }
+
+    PROFILE_BEGIN(claim, "claim image");
+    frame_claim_image(device, presenter->imagesInFlight, imageIndex, frame);
+    vkResetFences(device, 1, &frame->inFlight);
+    PROFILE_END(claim);
+
+    PROFILE_BEGIN(recording, "record");
+    frame_record(device, frame, presenter->currentFrame, imageIndex, record);
+    PROFILE_END(recording);
+
+    PROFILE_BEGIN(submit, "submit");
+    frame_submit(presenter->graphicsQueue, frame, true);
+    PROFILE_END(submit);
+
+    VkPresentInfoKHR presentInfo = {};
+    presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores    = &frame->renderFinished;
+
+    VkSwapchainKHR swapChains[] = {presenter->swapchain->swapchain};
+    presentInfo.swapchainCount  = 1;
+    presentInfo.pSwapchains     = swapChains;
+    presentInfo.pImageIndices   = &imageIndex;
+
+    presentInfo.pResults = NULL;    // Optional
+
+    PROFILE_BEGIN(present, "present");
+    VkResult presentResult = vkQueuePresentKHR(presenter->presentQueue, &presentInfo);
+    PROFILE_END(present);
+
+    presenter->currentFrame = (presenter->currentFrame + 1) % presenter->framesInFlight;
+
+    /* suboptimal still presented, recreate before the next frame */
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR ||
+        *presenter->framebufferResized)
+    {
+        presenter_recreate(presenter, record);
+    }
+    else if (presentResult != VK_SUCCESS)
+    {
+        fprintf(stderr, "queue present error: %d\n", presentResult);
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    struct Options options = parse_options(argc, argv);
+    PROFILE_THREAD("main");
+    printf("math kernels: %s\n", vecmath_path_name(vecmath_init()));
+
+    if (options.benchMath)
+    {
+        bench_math(BENCH_MATH_COUNT, options.frames);
+        profiler_shutdown();
+        exit(EXIT_SUCCESS);
+    }
+
+    /***************************************************************************/
+    /*                                   GLFW                                  */
+    /***************************************************************************/
+    GLFWwindow* window             = NULL;
+    bool        framebufferResized = false;
+
+    if (options.headless)
+    {
+        printf("headless, rendering %d frame(s)\n", options.frames);
+    }
+    else
+    {
+        /* init ****************************************************************/
+        glfwSetErrorCallback(error_glfw_callback);
+
+        printf("Compiled against GLFW %i.%i.%i\n",
+               GLFW_VERSION_MAJOR,
+               GLFW_VERSION_MINOR,
+               GLFW_VERSION_REVISION);
+
+        printf("%s\n", glfwGetVersionString());
+
+        if (!glfwInit())
+        {
+            glfwTerminate();
+            exit(EXIT_FAILURE);
+        }
 
-    printf("glfw init\n");
+        printf("glfw init\n");
 
-    /* window create **********************************************************/
-    glfwDefaultWindowHints();
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        /* window create ******************************************************/
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, NULL, NULL);
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, NULL, NULL);
+        if (window)
+        {
+            glfwSetWindowUserPointer(window, &framebufferResized);
+            glfwSetFramebufferSizeCallback(window, framebuffer_size_glfw_callback);
+        }
+    }
 
 
     /*************************************************************************/
@@ -61,7 +606,7 @@ int main(void)
     /*************************************************************************/
 
 
-    if (!glfwVulkanSupported())
+    if (!options.headless && !glfwVulkanSupported())
     {
         fprintf(stderr, "Vulkan missing.\n");
         exit(EXIT_FAILURE);
@@ -136,23 +681,40 @@ int main(void)
     instanceCreateInfo.flags                = 0;
     instanceCreateInfo.pApplicationInfo     = &appInfo;
 
+    /* headless needs no surface extensions, so GLFW is never asked */
     uint32_t     glfwExtensionCount = 0;
-    const char** glfwExtensions;
+    const char** glfwExtensions     = NULL;
+    if (!options.headless)
+    {
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    }
+
+    /* every GLFW extension, then debug utils and properties 2 */
+    const char* instanceExtensions[glfwExtensionCount + 2];
+    uint32_t    instanceExtensionsCount = 0;
 
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    for (uint32_t i = 0; i < glfwExtensionCount; ++i)
+    {
+        instanceExtensions[instanceExtensionsCount++] = glfwExtensions[i];
+    }
 
     if (validationLayersEnable)
     {
-        instanceCreateInfo.enabledExtensionCount   = glfwExtensionCount + 1;
-        glfwExtensions[glfwExtensionCount]         = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
-        instanceCreateInfo.ppEnabledExtensionNames = glfwExtensions;
+        instanceExtensions[instanceExtensionsCount++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
     }
-    else
+
+    /* device features past Vulkan 1.0 are queried through it */
+    bool instanceProperties2 =
+        instance_extension_supported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    if (instanceProperties2)
     {
-        instanceCreateInfo.enabledExtensionCount   = glfwExtensionCount;
-        instanceCreateInfo.ppEnabledExtensionNames = glfwExtensions;
+        instanceExtensions[instanceExtensionsCount++] =
+            VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME;
     }
 
+    instanceCreateInfo.enabledExtensionCount   = instanceExtensionsCount;
+    instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions;
+
 
     if (validationLayersEnable && !validationPossible)
     {
@@ -172,7 +734,9 @@ int main(void)
     }
 
     PFN_vkCreateInstance pfnCreateInstance =
-        (PFN_vkCreateInstance) glfwGetInstanceProcAddress(NULL, "vkCreateInstance");
+        options.headless
+            ? vkCreateInstance
+            : (PFN_vkCreateInstance) glfwGetInstanceProcAddress(NULL, "vkCreateInstance");
 
     VkInstance instance;
     VkResult   instanceCreateResult;
@@ -228,11 +792,12 @@ int main(void)
 
 
     /* surface ***************************************************************/
-    VkSurfaceKHR surface;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
 
     VkResult surfaceCreateResult;
-    if ((surfaceCreateResult = glfwCreateWindowSurface(instance, window, NULL, &surface)) !=
-        VK_SUCCESS)
+    if (!options.headless &&
+        (surfaceCreateResult = glfwCreateWindowSurface(instance, window, NULL, &surface)) !=
+            VK_SUCCESS)
     {
         fprintf(stderr, "Vulkan Surface Creation Error: %d.\n", surfaceCreateResult);
         exit(EXIT_FAILURE);
@@ -240,9 +805,12 @@ int main(void)
 
 
     /* physical device *******************************************************/
-    const char*   devicePhysicalExtensionsRequired[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    const char* devicePhysicalExtensionsRequired[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    /* headless renders without a swapchain */
     const uint8_t devicePhysicalExtensionsRequiredLength =
-        sizeof(devicePhysicalExtensionsRequired) / sizeof(devicePhysicalExtensionsRequired[0]);
+        options.headless
+            ? 0
+            : sizeof(devicePhysicalExtensionsRequired) / sizeof(devicePhysicalExtensionsRequired[0]);
 
     uint32_t devicesPhysicalCount = 0;
     vkEnumeratePhysicalDevices(instance, &devicesPhysicalCount, NULL);
@@ -260,7 +828,10 @@ int main(void)
     printf("found %d physical device(s)\n", devicesPhysicalCount);
 
     /* find suitable device **************************************************/
-    VkPhysicalDevice devicePhysical = VK_NULL_HANDLE;
+    /* every suitable device is scored, the best one is used */
+    VkPhysicalDevice    devicePhysical      = VK_NULL_HANDLE;
+    uint64_t            devicePhysicalScore = 0;
+    struct DeviceQueues deviceQueues        = {};
     /* swapchain query details */
     struct SwapChainDetails
     {
@@ -271,12 +842,13 @@ int main(void)
         VkPresentModeKHR* presentModes;
         uint32_t          presentModesCount;
         /* VkPresentModeKHR         presentModeSelected; */
-    } swapChainDetails;
+    } swapChainDetails = {};
 
     for (uint32_t i = 0; i < devicesPhysicalCount; ++i)
     {
         printf("  device %d:\n", i);
-        VkPhysicalDevice device = devicesPhysical[i];
+        VkPhysicalDevice        device  = devicesPhysical[i];
+        struct SwapChainDetails details = {};
 
         /* device features */
         VkPhysicalDeviceFeatures devicePhysicalFeatures;
@@ -321,53 +893,74 @@ int main(void)
         if (!devicePhysicalExtensionsRequirementsMet)
             continue;
 
+        struct DeviceQueues queues;
+        if (!device_queues_select(device, options.headless ? VK_NULL_HANDLE : surface, &queues))
+            continue;
 
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &swapChainDetails.capabilities);
+        /* headless needs no surface support */
+        if (!options.headless)
+        {
+            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
 
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &swapChainDetails.formatsCount, NULL);
-        printf("    found %d format(s)\n", swapChainDetails.formatsCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &details.formatsCount, NULL);
+            printf("    found %d format(s)\n", details.formatsCount);
 
-        if (swapChainDetails.formatsCount != 0)
-        {
-            swapChainDetails.formats = (malloc(
-                (size_t)(swapChainDetails.formatsCount * sizeof(swapChainDetails.formats))));
-            vkGetPhysicalDeviceSurfaceFormatsKHR(
-                device, surface, &swapChainDetails.formatsCount, swapChainDetails.formats);
-        }
+            if (details.formatsCount != 0)
+            {
+                details.formats = (malloc(
+                    (size_t)(details.formatsCount * sizeof(details.formats[0]))));
+                vkGetPhysicalDeviceSurfaceFormatsKHR(
+                    device, surface, &details.formatsCount, details.formats);
+            }
 
-        for (uint32_t i = 0; i < swapChainDetails.formatsCount; ++i)
-        {
-            VkSurfaceFormatKHR format = swapChainDetails.formats[i];
-            printf("      format=%d, colorSpace=%d\n", format.format, format.colorSpace);
-        }
+            for (uint32_t i = 0; i < details.formatsCount; ++i)
+            {
+                VkSurfaceFormatKHR format = details.formats[i];
+                printf("      format=%d, colorSpace=%d\n", format.format, format.colorSpace);
+            }
 
-        vkGetPhysicalDeviceSurfacePresentModesKHR(
-            device, surface, &swapChainDetails.presentModesCount, NULL);
-        printf("    found %d present mode(s)\n", swapChainDetails.presentModesCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(
+                device, surface, &details.presentModesCount, NULL);
+            printf("    found %d present mode(s)\n", details.presentModesCount);
 
-        if (swapChainDetails.presentModesCount != 0)
-        {
-            swapChainDetails.presentModes = (malloc((size_t)(
-                swapChainDetails.presentModesCount * sizeof(swapChainDetails.presentModes))));
-            vkGetPhysicalDeviceSurfacePresentModesKHR(device,
-                                                      surface,
-                                                      &swapChainDetails.presentModesCount,
-                                                      swapChainDetails.presentModes);
-        }
+            if (details.presentModesCount != 0)
+            {
+                details.presentModes = (malloc((size_t)(
+                    details.presentModesCount * sizeof(details.presentModes[0]))));
+                vkGetPhysicalDeviceSurfacePresentModesKHR(device,
+                                                          surface,
+                                                          &details.presentModesCount,
+                                                          details.presentModes);
+            }
 
-        for (uint32_t i = 0; i < swapChainDetails.presentModesCount; ++i)
-        {
-            VkPresentModeKHR mode = swapChainDetails.presentModes[i];
-            printf("      %d\n", mode);
+            for (uint32_t i = 0; i < details.presentModesCount; ++i)
+            {
+                VkPresentModeKHR mode = details.presentModes[i];
+                printf("      %d\n", mode);
+            }
+
+            if (details.formatsCount == 0 || details.presentModesCount == 0)
+            {
+                free(details.formats);
+                free(details.presentModes);
+                continue;
+            }
         }
 
-        if (swapChainDetails.formatsCount == 0 || swapChainDetails.presentModesCount == 0)
+        uint64_t score = device_score(device);
+        printf("    suitable, score %llu\n", (unsigned long long) score);
+        if (devicePhysical != VK_NULL_HANDLE && score <= devicePhysicalScore)
+        {
+            free(details.formats);
+            free(details.presentModes);
             continue;
-
-
-        /* found device */
-        devicePhysical = device;
-        break;
+        }
+        free(swapChainDetails.formats);
+        free(swapChainDetails.presentModes);
+        swapChainDetails    = details;
+        devicePhysical      = device;
+        devicePhysicalScore = score;
+        deviceQueues        = queues;
     }
 
     if (devicePhysical == VK_NULL_HANDLE)
@@ -375,9 +968,21 @@ int main(void)
         fprintf(stderr, "failed to find suitable physical device\n");
         exit(EXIT_FAILURE);
     }
-    else
+
+    VkPhysicalDeviceProperties devicePhysicalProperties;
+    vkGetPhysicalDeviceProperties(devicePhysical, &devicePhysicalProperties);
+
+    /* headless: describe the offscreen images as if they were a surface, so
+     * the swapChain config below picks format and present mode as usual */
+    VkSurfaceFormatKHR headlessFormat      = {VK_FORMAT_B8G8R8A8_UNORM,
+                                         VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+    VkPresentModeKHR   headlessPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    if (options.headless)
     {
-        printf("    suitable physical device\n");
+        swapChainDetails.formats           = &headlessFormat;
+        swapChainDetails.formatsCount      = 1;
+        swapChainDetails.presentModes      = &headlessPresentMode;
+        swapChainDetails.presentModesCount = 1;
     }
 
 
@@ -421,138 +1026,165 @@ int main(void)
 
 
     /* swapChain config presentMode ******************************************/
-    VkPresentModeKHR swapChainConfigPresentMode      = VK_PRESENT_MODE_FIFO_KHR;    // VSYNC
-    bool             swapChainConfigPresentModeFound = false;
-    printf("  %d available present mode(s)\n", swapChainDetails.presentModesCount);
-
-    for (uint32_t i = 0; i < swapChainDetails.presentModesCount; ++i)
+    /* FIFO is the only mode every surface supports */
+    VkPresentModeKHR swapChainConfigPresentMode       = VK_PRESENT_MODE_FIFO_KHR;    // VSYNC
+    VkPresentModeKHR swapChainConfigPresentModeWanted = VK_PRESENT_MODE_MAILBOX_KHR;
+    if (options.presentMode != NULL)
     {
-        VkPresentModeKHR modeKHR = swapChainDetails.presentModes[i];
-        // prefer tripple buffering
-        if (modeKHR == VK_PRESENT_MODE_MAILBOX_KHR)
-        {
-            swapChainConfigPresentMode      = modeKHR;
-            swapChainConfigPresentModeFound = true;
-        }
+        present_mode_parse(options.presentMode, &swapChainConfigPresentModeWanted);
     }
+    printf("  %d available present mode(s)\n", swapChainDetails.presentModesCount);
 
+    bool swapChainConfigPresentModeFound = false;
     for (uint32_t i = 0; i < swapChainDetails.presentModesCount; ++i)
     {
         VkPresentModeKHR modeKHR = swapChainDetails.presentModes[i];
-        // NO VSYNC
-        if (modeKHR == VK_PRESENT_MODE_IMMEDIATE_KHR)
+        if (modeKHR == swapChainConfigPresentModeWanted)
         {
             swapChainConfigPresentMode      = modeKHR;
             swapChainConfigPresentModeFound = true;
         }
     }
 
-    if (!swapChainConfigPresentModeFound)
+    if (!swapChainConfigPresentModeFound && options.presentMode != NULL)
     {
-        printf("    using fallback\n");
+        printf("    %s not supported, using fallback\n", options.presentMode);
     }
 
-    printf("    using present mode %d\n", swapChainConfigPresentMode);
+    printf("    using present mode %s\n", present_mode_name(swapChainConfigPresentMode));
 
 
     /* swapChain config swapExtent *******************************************/
-    VkExtent2D swapChainConfigExtent = swapChainDetails.capabilities.currentExtent;
-
-    if (swapChainConfigExtent.width == UINT32_MAX)
+    /* only used where the surface leaves the size to the swapChain */
+    VkExtent2D swapChainConfigExtent = {WINDOW_WIDTH, WINDOW_HEIGHT};
+    if (!options.headless && window)
     {
-        VkExtent2D swapChainConfigExtentMax = swapChainDetails.capabilities.maxImageExtent;
-        VkExtent2D swapChainConfigExtentMin = swapChainDetails.capabilities.minImageExtent;
-
-        swapChainConfigExtent.width = swapChainConfigExtentMax.width < WINDOW_WIDTH
-                                          ? swapChainConfigExtentMax.width
-                                          : WINDOW_WIDTH;
-        swapChainConfigExtent.height = swapChainConfigExtentMax.height < WINDOW_HEIGHT
-                                           ? swapChainConfigExtentMax.height
-                                           : WINDOW_HEIGHT;
-        swapChainConfigExtent.width = swapChainConfigExtentMin.width > swapChainConfigExtent.width
-                                          ? swapChainConfigExtentMin.width
-                                          : swapChainConfigExtent.width;
-        swapChainConfigExtent.height =
-            swapChainConfigExtentMin.height > swapChainConfigExtent.height
-                ? swapChainConfigExtentMin.height
-                : swapChainConfigExtent.height;
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        swapChainConfigExtent.width  = (uint32_t) width;
+        swapChainConfigExtent.height = (uint32_t) height;
     }
 
-    printf("  currentExtent\n    res: %dx%d\n",
-           swapChainConfigExtent.width,
-           swapChainConfigExtent.height);
-
     /* physical device queues ************************************************/
-    uint32_t devicePhysicalQueueGraphicsFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(
-        devicePhysical, &devicePhysicalQueueGraphicsFamilyCount, NULL);
-
-    printf("found %d physical device queue families\n", devicePhysicalQueueGraphicsFamilyCount);
-
-    VkQueueFamilyProperties
-        devicePhysicalQueueGraphicsFamilies[devicePhysicalQueueGraphicsFamilyCount];
-    vkGetPhysicalDeviceQueueFamilyProperties(devicePhysical,
-                                             &devicePhysicalQueueGraphicsFamilyCount,
-                                             devicePhysicalQueueGraphicsFamilies);
-
-    int32_t devicePhysicalQueueGraphicsIndex = -1;
-    for (uint32_t i = 0; i < devicePhysicalQueueGraphicsFamilyCount; ++i)
-    {
-        VkQueueFamilyProperties family = devicePhysicalQueueGraphicsFamilies[i];
-
-        if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-        {
-            devicePhysicalQueueGraphicsIndex = i;
-            break;
-        }
-    }
+    /* picked while scoring, see device_queues_select */
+    int32_t devicePhysicalQueueGraphicsIndex = deviceQueues.graphics;
+    int32_t devicePhysicalQueuePresentIndex  = deviceQueues.present;
+    int32_t devicePhysicalQueueTransferIndex = deviceQueues.transfer;
+    int32_t devicePhysicalQueueComputeIndex  = deviceQueues.compute;
     printf("using physical device queue graphics with index %d\n",
            devicePhysicalQueueGraphicsIndex);
-
-    int32_t devicePhysicalQueuePresentIndex = -1;
-    for (uint32_t i = 0; i < devicePhysicalQueueGraphicsFamilyCount; ++i)
-    {
-        VkBool32 presentSupport = false;
-        VkResult deviceSurfaceSupportResult;
-        if ((deviceSurfaceSupportResult =
-                 vkGetPhysicalDeviceSurfaceSupportKHR(
-                     devicePhysical, i, surface, &presentSupport) == VK_SUCCESS))
-        {
-            devicePhysicalQueuePresentIndex = i;
-            break;
-        }
-    }
     printf("using physical device queue present with index %d\n", devicePhysicalQueuePresentIndex);
-
-
-    /* TODO: actually check for present queue */
-    /* int32_t devicePhysicalQueuePresentIndex = devicePhysicalQueueGraphicsIndex; */
+    printf("using physical device queue transfer with index %d (%s)\n",
+           devicePhysicalQueueTransferIndex,
+           deviceQueues.transferDedicated ? "dedicated" : "shared with graphics");
+    /* no queue of its own yet: the cull pass is recorded on the graphics queue */
+    printf("using physical device queue compute with index %d (%s, unused)\n",
+           devicePhysicalQueueComputeIndex,
+           deviceQueues.computeDedicated ? "no graphics" : "shared with graphics");
 
 
     /* device ****************************************************************/
     VkDevice device;
 
-    /* queue info */
-    VkDeviceQueueCreateInfo deviceQueueCreateInfo = {};
-    deviceQueueCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    deviceQueueCreateInfo.queueFamilyIndex        = devicePhysicalQueueGraphicsIndex;
-    deviceQueueCreateInfo.queueCount              = 1;
+    /* queue info, one queue per distinct family */
+    int32_t deviceQueueFamilies[] = {devicePhysicalQueueGraphicsIndex,
+                                     devicePhysicalQueuePresentIndex,
+                                     devicePhysicalQueueTransferIndex};
+
+    float                   deviceQueuePriority = 1.0f;
+    VkDeviceQueueCreateInfo deviceQueueCreateInfos[3];
+    uint32_t                deviceQueueCreateInfosCount = 0;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        bool seen = false;
+        for (uint32_t j = 0; j < i; ++j)
+            seen |= deviceQueueFamilies[j] == deviceQueueFamilies[i];
+        if (seen)
+            continue;
+
+        VkDeviceQueueCreateInfo* deviceQueueCreateInfo =
+            &deviceQueueCreateInfos[deviceQueueCreateInfosCount++];
+        *deviceQueueCreateInfo                  = (VkDeviceQueueCreateInfo){};
+        deviceQueueCreateInfo->sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        deviceQueueCreateInfo->queueFamilyIndex = deviceQueueFamilies[i];
+        deviceQueueCreateInfo->queueCount       = 1;
+        deviceQueueCreateInfo->pQueuePriorities = &deviceQueuePriority;
+    }
 
-    float deviceQueuePriority = 1.0f;
+    /* device features, the indirect draws of the cull pass use what is there */
+    VkPhysicalDeviceFeatures devicePhysicalFeatures;
+    vkGetPhysicalDeviceFeatures(devicePhysical, &devicePhysicalFeatures);
+    VkPhysicalDeviceFeatures deviceFeatures  = {};
+    deviceFeatures.multiDrawIndirect         = devicePhysicalFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = devicePhysicalFeatures.drawIndirectFirstInstance;
+
+    /* the bindless arrays are indexed by push constants, dynamically uniform */
+    deviceFeatures.shaderSampledImageArrayDynamicIndexing =
+        devicePhysicalFeatures.shaderSampledImageArrayDynamicIndexing;
+    deviceFeatures.shaderStorageBufferArrayDynamicIndexing =
+        devicePhysicalFeatures.shaderStorageBufferArrayDynamicIndexing;
+
+    /* device extensions, the required ones and optional ones if supported */
+    const char* deviceExtensions[8];
+    uint32_t    deviceExtensionsCount = 0;
+    for (uint32_t i = 0; i < devicePhysicalExtensionsRequiredLength; ++i)
+        deviceExtensions[deviceExtensionsCount++] = devicePhysicalExtensionsRequired[i];
+    bool deviceDrawIndirectCount =
+        device_extension_supported(devicePhysical, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    if (deviceDrawIndirectCount)
+        deviceExtensions[deviceExtensionsCount++] = VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+
+    /* descriptor indexing, only what the bindless set uses is enabled */
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT deviceIndexingFeatures = {};
+    deviceIndexingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    bool deviceIndexing =
+        instanceProperties2 &&
+        device_extension_supported(devicePhysical, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+        device_extension_supported(devicePhysical, VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+    if (deviceIndexing)
+    {
+        PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR =
+            (PFN_vkGetPhysicalDeviceFeatures2KHR) vkGetInstanceProcAddr(
+                instance, "vkGetPhysicalDeviceFeatures2KHR");
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing = {};
+        indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext                     = &indexing;
+        if (vkGetPhysicalDeviceFeatures2KHR != NULL)
+            vkGetPhysicalDeviceFeatures2KHR(devicePhysical, &features2);
+
+        deviceIndexing = indexing.descriptorBindingPartiallyBound &&
+                         indexing.descriptorBindingSampledImageUpdateAfterBind &&
+                         indexing.descriptorBindingStorageBufferUpdateAfterBind &&
+                         indexing.descriptorBindingUpdateUnusedWhilePending;
+    }
+    if (deviceIndexing)
+    {
+        deviceIndexingFeatures.descriptorBindingPartiallyBound              = VK_TRUE;
+        deviceIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE;
+        deviceIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        deviceIndexingFeatures.descriptorBindingUpdateUnusedWhilePending     = VK_TRUE;
 
-    deviceQueueCreateInfo.pQueuePriorities = &deviceQueuePriority;
+        deviceExtensions[deviceExtensionsCount++] = VK_KHR_MAINTENANCE3_EXTENSION_NAME;
+        deviceExtensions[deviceExtensionsCount++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+    }
 
-    /* device features */
-    VkPhysicalDeviceFeatures deviceFeatures = {};
+    struct BindlessFeatures bindlessFeatures;
+    bindless_features(
+        &bindlessFeatures, deviceIndexing, &deviceFeatures, &devicePhysicalProperties.limits);
 
     /* createInfo */
     VkDeviceCreateInfo deviceCreateInfo      = {};
     deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.pQueueCreateInfos       = &deviceQueueCreateInfo;
-    deviceCreateInfo.queueCreateInfoCount    = 1;
+    deviceCreateInfo.pQueueCreateInfos       = deviceQueueCreateInfos;
+    deviceCreateInfo.queueCreateInfoCount    = deviceQueueCreateInfosCount;
     deviceCreateInfo.pEnabledFeatures        = &deviceFeatures;
-    deviceCreateInfo.enabledExtensionCount   = 1;
-    deviceCreateInfo.ppEnabledExtensionNames = devicePhysicalExtensionsRequired;
+    deviceCreateInfo.enabledExtensionCount   = deviceExtensionsCount;
+    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
+    deviceCreateInfo.pNext                   = deviceIndexing ? &deviceIndexingFeatures : NULL;
 
     /* layer injection */
     if (validationLayersEnable)
@@ -575,6 +1207,11 @@ int main(void)
     }
 
 
+    /* allocator *************************************************************/
+    struct Allocator allocator;
+    allocator_init(&allocator, devicePhysical, device);
+
+
     /* grapicsQueue **********************************************************/
     VkQueue graphicsQueue;
     vkGetDeviceQueue(device, devicePhysicalQueueGraphicsIndex, 0, &graphicsQueue);
@@ -585,96 +1222,30 @@ int main(void)
     vkGetDeviceQueue(device, devicePhysicalQueuePresentIndex, 0, &presentQueue);
 
 
-    /* swapChain creation ****************************************************/
-    uint32_t imageCount = swapChainDetails.capabilities.minImageCount + 1;
-    if (swapChainDetails.capabilities.maxImageCount > 0 &&
-        imageCount > swapChainDetails.capabilities.maxImageCount)
-    {
-        imageCount = swapChainDetails.capabilities.maxImageCount;
-    }
-
-    VkSwapchainCreateInfoKHR swapChainCreateInfo = {};
-    swapChainCreateInfo.sType                    = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    swapChainCreateInfo.surface                  = surface;
-
-    swapChainCreateInfo.minImageCount    = imageCount;
-    swapChainCreateInfo.imageFormat      = swapChainConfigFormat.format;
-    swapChainCreateInfo.imageColorSpace  = swapChainConfigFormat.colorSpace;
-    swapChainCreateInfo.imageExtent      = swapChainConfigExtent;
-    swapChainCreateInfo.imageArrayLayers = 1;
-    swapChainCreateInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-
-    if (devicePhysicalQueueGraphicsIndex != devicePhysicalQueuePresentIndex)
-    {
-        uint32_t pQueueFamilyIndices[2];
-        pQueueFamilyIndices[0]                    = devicePhysicalQueueGraphicsIndex;
-        pQueueFamilyIndices[1]                    = devicePhysicalQueuePresentIndex;
-        swapChainCreateInfo.pQueueFamilyIndices   = pQueueFamilyIndices;
-        swapChainCreateInfo.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
-        swapChainCreateInfo.queueFamilyIndexCount = 2;
-    }
-    else
-    {
-        swapChainCreateInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
-        swapChainCreateInfo.queueFamilyIndexCount = 0;
-        swapChainCreateInfo.pQueueFamilyIndices   = NULL;
-    }
-
-    swapChainCreateInfo.preTransform   = swapChainDetails.capabilities.currentTransform;
-    swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swapChainCreateInfo.presentMode    = swapChainConfigPresentMode;
-    swapChainCreateInfo.clipped        = VK_TRUE;
-    swapChainCreateInfo.oldSwapchain   = VK_NULL_HANDLE;
-
-    VkSwapchainKHR swapChain;
-    VkResult       swapChainCreateResult;
-    if ((swapChainCreateResult =
-             vkCreateSwapchainKHR(device, &swapChainCreateInfo, NULL, &swapChain)) != VK_SUCCESS)
-    {
-        fprintf(stderr, "swapChain creation Error: %d.\n", swapChainCreateResult);
-        exit(EXIT_FAILURE);
-    }
-
-
-    /* swapChain Images ******************************************************/
-    uint32_t swapChainImagesCount;
-    vkGetSwapchainImagesKHR(device, swapChain, &swapChainImagesCount, NULL);
-    VkImage swapChainImages[swapChainImagesCount];
-    vkGetSwapchainImagesKHR(device, swapChain, &swapChainImagesCount, swapChainImages);
-
-
-    /* swapChainImageViews ***************************************************/
-    VkImageView swapChainImageViews[swapChainImagesCount];
-    for (uint32_t i = 0; i < swapChainImagesCount; ++i)
-    {
-        VkImage swapChainImage = swapChainImages[i];
-
-        VkImageViewCreateInfo createInfo = {};
-        createInfo.sType                 = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        createInfo.image                 = swapChainImage;
-
-        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        createInfo.format   = swapChainConfigFormat.format;
-
-        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    /* transfer queue ********************************************************/
+    /* the graphics queue itself where the device has no other family */
+    VkQueue transferQueue;
+    vkGetDeviceQueue(device, devicePhysicalQueueTransferIndex, 0, &transferQueue);
 
-        createInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        createInfo.subresourceRange.baseMipLevel   = 0;
-        createInfo.subresourceRange.levelCount     = 1;
-        createInfo.subresourceRange.baseArrayLayer = 0;
-        createInfo.subresourceRange.layerCount     = 1;
 
-        VkResult imageViewCreateResult;
-        if ((imageViewCreateResult = vkCreateImageView(
-                 device, &createInfo, NULL, &swapChainImageViews[i])) != VK_SUCCESS)
-        {
-            fprintf(stderr, "imageView creation Error: %d.\n", imageViewCreateResult);
-            exit(EXIT_FAILURE);
-        }
-    }
+    /* swapChain creation ****************************************************/
+    struct SwapchainConfig swapchainConfig = {};
+    swapchainConfig.devicePhysical         = devicePhysical;
+    swapchainConfig.device                 = device;
+    swapchainConfig.surface                = options.headless ? VK_NULL_HANDLE : surface;
+    swapchainConfig.allocator              = &allocator;
+    swapchainConfig.format                 = swapChainConfigFormat;
+    swapchainConfig.presentMode            = swapChainConfigPresentMode;
+    swapchainConfig.queueFamilyGraphics    = devicePhysicalQueueGraphicsIndex;
+    swapchainConfig.queueFamilyPresent     = devicePhysicalQueuePresentIndex;
+    swapchainConfig.headlessImagesCount    = HEADLESS_IMAGE_COUNT;
+
+    struct Swapchain swapchain;
+    swapchain_create(&swapchain, &swapchainConfig, swapChainConfigExtent);
+    printf("  %d image(s) at %dx%d\n",
+           swapchain.imagesCount,
+           swapchain.extent.width,
+           swapchain.extent.height);
 
 
     /*************************************************************************/
@@ -693,7 +1264,8 @@ int main(void)
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout   = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout   = options.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                                     : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment            = 0;
@@ -731,42 +1303,47 @@ int main(void)
     }
 
     /*************************************************************************/
-    /*                                pipeline                               */
+    /*                                 assets                                */
     /*************************************************************************/
-    char* vertShaderCode;
-    char* fragShaderCode;
-
-    uint32_t vertShaderCodeLength =
-        ae_load_file_to_memory("shaders/shader.vert.spv", &vertShaderCode);
-    uint32_t fragShaderCodeLength =
-        ae_load_file_to_memory("shaders/shader.frag.spv", &fragShaderCode);
-
-    if (!(vertShaderCodeLength > 0 && fragShaderCodeLength > 0))
+    /* mapped, not read: blobs are paged in when they are first used */
+    struct Pack pack = {};
+    if (options.pack != NULL)
     {
-        fprintf(stderr, "shader load error\n");
-        exit(EXIT_FAILURE);
+        uint64_t packStart = util_time_ns();
+        if (!pack_open(&pack, options.pack))
+        {
+            fprintf(stderr, "pack open error: %s\n", options.pack);
+            exit(EXIT_FAILURE);
+        }
+        printf("pack %s: %d blob(s), %zu bytes mapped in %.3f ms\n",
+               options.pack,
+               pack.entriesCount,
+               pack.size,
+               (double) (util_time_ns() - packStart) / 1e6);
     }
 
-    struct ShaderCode
-    {
-        uint32_t length;
-        char*    shader;
-    } shaderCodes[2];
-
-    shaderCodes[0].length = vertShaderCodeLength;
-    shaderCodes[0].shader = vertShaderCode;
-    shaderCodes[1].length = fragShaderCodeLength;
-    shaderCodes[1].shader = fragShaderCode;
+    /*************************************************************************/
+    /*                                pipeline                               */
+    /*************************************************************************/
+    /* embedded at build time, options.shaderDir and options.pack may
+     * override them */
+    const char* shaderNames[3] = {"shader.vert.spv", "shader.frag.spv", "cull.comp.spv"};
 
-    VkShaderModule shaderModules[2];
+    VkShaderModule shaderModules[3];
 
-    for (uint32_t i = 0; i < 2; ++i)
+    for (uint32_t i = 0; i < 3; ++i)
     {
-        struct ShaderCode        shaderCode             = shaderCodes[i];
+        struct ShaderCode shaderCode;
+        if (!shaders_get(shaderNames[i], options.shaderDir, &pack, &shaderCode))
+        {
+            fprintf(stderr, "shader load error: %s\n", shaderNames[i]);
+            exit(EXIT_FAILURE);
+        }
+
         VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
         shaderModuleCreateInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        shaderModuleCreateInfo.codeSize = shaderCode.length;
-        shaderModuleCreateInfo.pCode    = ((uint32_t*) (shaderCode.shader));
+        shaderModuleCreateInfo.codeSize = shaderCode.size;
+        shaderModuleCreateInfo.pCode    = shaderCode.code;
 
         VkShaderModule shaderModule;
         if (vkCreateShaderModule(device, &shaderModuleCreateInfo, NULL, &shaderModule) !=
@@ -777,8 +1354,23 @@ int main(void)
             exit(EXIT_FAILURE);
         }
         shaderModules[i] = shaderModule;
+        shaders_release(&shaderCode);
     }
 
+    /* the one descriptor set of every pipeline, its array sizes are
+     * specialization constants of the fragment shader */
+    struct Bindless bindless;
+    bindless_init(&bindless, device, &bindlessFeatures, options.framesInFlight);
+    printf("bindless descriptors: %s, %u textures, %u buffers\n",
+           bindless.features.indexing ? "descriptor indexing, update after bind"
+                                      : "a set per frame in flight",
+           bindless.features.texturesCount,
+           bindless.features.buffersCount);
+
+    /* per frame data, set 1 of every pipeline */
+    struct UniformRing uniforms;
+    uniform_ring_init(&uniforms, &allocator, &devicePhysicalProperties.limits, UNIFORM_RING_SIZE);
+
     VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -786,45 +1378,82 @@ int main(void)
     vertShaderStageInfo.module = shaderModules[0];
     vertShaderStageInfo.pName  = "main";
 
+    /* the storage buffer count of the fragment stage, and the transform source */
+    VkSpecializationMapEntry vertSpecializationEntries[] = {
+        {1, 0, sizeof(uint32_t)},
+        {2, sizeof(uint32_t), sizeof(uint32_t)},
+    };
+    uint32_t vertSpecializationData[] = {bindless.features.buffersCount, RECORDER_TRANSFORM_PUSH};
+
+    VkSpecializationInfo vertSpecialization = {};
+    vertSpecialization.mapEntryCount        = 2;
+    vertSpecialization.pMapEntries          = vertSpecializationEntries;
+    vertSpecialization.dataSize             = sizeof(vertSpecializationData);
+    vertSpecialization.pData                = vertSpecializationData;
+
+    vertShaderStageInfo.pSpecializationInfo = &vertSpecialization;
+
     VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
     fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
     fragShaderStageInfo.module = shaderModules[1];
     fragShaderStageInfo.pName  = "main";
 
+    fragShaderStageInfo.pSpecializationInfo = &bindless.specialization;
+
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
+    /* binding 0: per vertex, binding 1: per instance */
+    VkVertexInputBindingDescription vertexBindingDescriptions[2] = {};
+    vertexBindingDescriptions[0].binding                         = 0;
+    vertexBindingDescriptions[0].stride                          = sizeof(struct Vertex);
+    vertexBindingDescriptions[0].inputRate                       = VK_VERTEX_INPUT_RATE_VERTEX;
+    vertexBindingDescriptions[1].binding                         = 1;
+    vertexBindingDescriptions[1].stride                          = sizeof(struct Instance);
+    vertexBindingDescriptions[1].inputRate                       = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription vertexAttributeDescriptions[7] = {};
+    vertexAttributeDescriptions[0].location                          = 0;
+    vertexAttributeDescriptions[0].binding                           = 0;
+    vertexAttributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    vertexAttributeDescriptions[0].offset = offsetof(struct Vertex, position);
+    vertexAttributeDescriptions[1].location = 1;
+    vertexAttributeDescriptions[1].binding  = 0;
+    vertexAttributeDescriptions[1].format   = VK_FORMAT_R32G32B32_SFLOAT;
+    vertexAttributeDescriptions[1].offset   = offsetof(struct Vertex, color);
+    /* mat4 model takes one location per column */
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        vertexAttributeDescriptions[2 + i].location = 2 + i;
+        vertexAttributeDescriptions[2 + i].binding  = 1;
+        vertexAttributeDescriptions[2 + i].format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+        vertexAttributeDescriptions[2 + i].offset =
+            offsetof(struct Instance, model) + i * 4 * sizeof(float);
+    }
+    vertexAttributeDescriptions[6].location = 6;
+    vertexAttributeDescriptions[6].binding  = 1;
+    vertexAttributeDescriptions[6].format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+    vertexAttributeDescriptions[6].offset   = offsetof(struct Instance, color);
+
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount   = 0;
-    vertexInputInfo.pVertexBindingDescriptions      = NULL;    // Optional
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions    = NULL;    // Optional
+    vertexInputInfo.vertexBindingDescriptionCount   = 2;
+    vertexInputInfo.pVertexBindingDescriptions      = vertexBindingDescriptions;
+    vertexInputInfo.vertexAttributeDescriptionCount = 7;
+    vertexInputInfo.pVertexAttributeDescriptions    = vertexAttributeDescriptions;
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
     inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport = {};
-    viewport.x          = 0.0f;
-    viewport.y          = 0.0f;
-    viewport.width      = (float) swapChainConfigExtent.width;
-    viewport.height     = (float) swapChainConfigExtent.height;
-    viewport.minDepth   = 0.0f;
-    viewport.maxDepth   = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent   = swapChainConfigExtent;
-
+    /* viewport and scissor are set while recording, see dynamicState */
     VkPipelineViewportStateCreateInfo viewportState = {};
     viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports    = &viewport;
+    viewportState.pViewports    = NULL;
     viewportState.scissorCount  = 1;
-    viewportState.pScissors     = &scissor;
+    viewportState.pScissors     = NULL;
 
     VkPipelineRasterizationStateCreateInfo rasterizer = {};
     rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -870,13 +1499,30 @@ int main(void)
     colorBlending.blendConstants[2] = 0.0f;    // Optional
     colorBlending.blendConstants[3] = 0.0f;    // Optional
 
+    /* per draw data without descriptors: the payload of the vertex stage,
+     * then the bindless indices the fragment stage reads */
+    VkPushConstantRange pushConstantRanges[2] = {};
+    pushConstantRanges[0].stageFlags          = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRanges[0].offset              = 0;
+    pushConstantRanges[0].size                = sizeof(struct DrawPayload);
+    pushConstantRanges[1].stageFlags          = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRanges[1].offset              = RECORDER_CONSTANTS_OFFSET;
+    pushConstantRanges[1].size                = sizeof(struct BindlessConstants);
+    if (RECORDER_PUSH_SIZE > devicePhysicalProperties.limits.maxPushConstantsSize)
+    {
+        fprintf(stderr, "push constants exceed maxPushConstantsSize\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkDescriptorSetLayout setLayouts[] = {bindless.setLayout, uniforms.setLayout};
+
     VkPipelineLayout           pipelineLayout;
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount             = 0;       // Optional
-    pipelineLayoutInfo.pSetLayouts                = NULL;    // Optional
-    pipelineLayoutInfo.pushConstantRangeCount     = 0;       // Optional
-    pipelineLayoutInfo.pPushConstantRanges        = NULL;    // Optional
+    pipelineLayoutInfo.setLayoutCount             = 2;
+    pipelineLayoutInfo.pSetLayouts                = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount     = 2;
+    pipelineLayoutInfo.pPushConstantRanges        = pushConstantRanges;
 
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, NULL, &pipelineLayout) != VK_SUCCESS)
     {
@@ -884,6 +1530,14 @@ int main(void)
         exit(EXIT_FAILURE);
     }
 
+    /* a resize only rebuilds the swapChain, the pipeline stays */
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates    = dynamicStates;
+
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
     pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount                   = 2;
@@ -895,46 +1549,80 @@ int main(void)
     pipelineInfo.pMultisampleState            = &multisampling;
     pipelineInfo.pDepthStencilState           = NULL;    // Optional
     pipelineInfo.pColorBlendState             = &colorBlending;
-    pipelineInfo.pDynamicState                = NULL;    // Optional
+    pipelineInfo.pDynamicState                = &dynamicState;
     pipelineInfo.layout                       = pipelineLayout;
     pipelineInfo.renderPass                   = renderPass;
     pipelineInfo.subpass                      = 0;
     pipelineInfo.basePipelineHandle           = VK_NULL_HANDLE;    // Optional
     pipelineInfo.basePipelineIndex            = -1;                // Optional
 
+    /* pipeline cache */
+    bool            pipelineCacheWarm = false;
+    VkPipelineCache pipelineCache     = VK_NULL_HANDLE;
+    if (options.pipelineCache)
+    {
+        pipelineCache = pipeline_cache_load(
+            device, &devicePhysicalProperties, options.pipelineCache, &pipelineCacheWarm);
+    }
+
     VkPipeline graphicsPipeline;
+    uint64_t   pipelineCreateStart = util_time_ns();
     if (vkCreateGraphicsPipelines(
-            device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &graphicsPipeline) != VK_SUCCESS)
+            device, pipelineCache, 1, &pipelineInfo, NULL, &graphicsPipeline) != VK_SUCCESS)
     {
         fprintf(stderr, "pipeline create error\n");
         exit(EXIT_FAILURE);
     }
+    printf("pipeline create %.3f ms (%s)\n",
+           (double) (util_time_ns() - pipelineCreateStart) / 1e6,
+           options.pipelineCache == NULL ? "no cache" : pipelineCacheWarm ? "warm" : "cold");
+
+    /* hot reload ************************************************************/
+    /* builds on its own thread, the draw loop swaps at a frame boundary */
+    struct HotReload hotReload = {};
+    if (options.hotReload)
+    {
+        const char* shaderSources[2] = {"shader.vert", "shader.frag"};
+        const char* shaderSourceDir  = getenv("TJTECH1_SHADER_SOURCE");
+        hot_reload_start(&hotReload,
+                         device,
+                         pipelineCache,
+                         &pipelineInfo,
+                         shaderSources,
+                         shaderSourceDir != NULL ? shaderSourceDir : TJTECH1_SHADER_SOURCE_DIR,
+                         TJTECH1_GLSLANG);
+    }
+
+    /* cull pass *************************************************************/
+    /* compute pipeline beside graphicsPipeline. an indirect draw selects its
+     * object through firstInstance, which needs drawIndirectFirstInstance */
+    bool        cullSupported = devicePhysicalFeatures.drawIndirectFirstInstance;
+    struct Cull cull          = {};
+    if (cullSupported)
+    {
+        struct CullFeatures cullFeatures  = {};
+        cullFeatures.multiDrawIndirect    = devicePhysicalFeatures.multiDrawIndirect;
+        cullFeatures.maxDrawIndirectCount = devicePhysicalProperties.limits.maxDrawIndirectCount;
+        if (deviceDrawIndirectCount)
+            cullFeatures.drawIndirectCount =
+                (PFN_vkCmdDrawIndexedIndirectCountKHR) vkGetDeviceProcAddr(
+                    device, "vkCmdDrawIndexedIndirectCountKHR");
+        cull_init(&cull, &allocator, shaderModules[2], pipelineCache, cullFeatures);
+        printf("cull pass: %s\n",
+               cullFeatures.drawIndirectCount != NULL ? "compacted, indirect count"
+               : cullFeatures.multiDrawIndirect       ? "multi draw indirect"
+                                                      : "one indirect draw per object");
+    }
+    else if (options.gpuCulling || options.benchCulling)
+    {
+        printf("cull pass: no drawIndirectFirstInstance, culling on the CPU\n");
+    }
 
 
     /*************************************************************************/
     /*                              framebuffer                              */
     /*************************************************************************/
-    VkFramebuffer swapChainFramebuffers[swapChainImagesCount];
-    for (size_t i = 0; i < swapChainImagesCount; ++i)
-    {
-        VkImageView attachments[] = {swapChainImageViews[i]};
-
-        VkFramebufferCreateInfo framebufferInfo = {};
-        framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass              = renderPass;
-        framebufferInfo.attachmentCount         = 1;
-        framebufferInfo.pAttachments            = attachments;
-        framebufferInfo.width                   = swapChainConfigExtent.width;
-        framebufferInfo.height                  = swapChainConfigExtent.height;
-        framebufferInfo.layers                  = 1;
-
-        if (vkCreateFramebuffer(device, &framebufferInfo, NULL, &swapChainFramebuffers[i]) !=
-            VK_SUCCESS)
-        {
-            fprintf(stderr, "framebuffer create error\n");
-            exit(EXIT_FAILURE);
-        }
-    }
+    swapchain_framebuffers_create(&swapchain, &swapchainConfig, renderPass);
 
     /*************************************************************************/
     /*                              commandPool                              */
@@ -951,95 +1639,198 @@ int main(void)
         fprintf(stderr, "commandPool create error\n");
         exit(EXIT_FAILURE);
     }
+    bindless_defaults(&bindless, &allocator, commandPool, graphicsQueue);
 
 
     /*************************************************************************/
-    /*                             commandBuffer                             */
+    /*                                geometry                               */
     /*************************************************************************/
-    /* allocate **************************************************************/
-    VkCommandBuffer commandBuffers[swapChainImagesCount];
-
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool                 = commandPool;
-    allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount          = swapChainImagesCount;
-
-    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers) != VK_SUCCESS)
+    const struct Vertex triangleVertices[] = {
+        {{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+        {{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    };
+    const uint32_t triangleIndices[] = {0, 1, 2};
+
+    struct MeshBatch meshBatch = {};
+    uint32_t         triangle =
+        mesh_batch_add(&meshBatch, triangleVertices, 3, triangleIndices, 3);
+
+    /* an imported mesh is drawn instead of the triangle */
+    uint32_t sceneMesh = triangle;
+    if (options.mesh != NULL)
     {
-        fprintf(stderr, "commandBuffer allocate error\n");
-        exit(EXIT_FAILURE);
+        struct Jobs importJobs;
+        jobs_init(&importJobs, jobs_cpu_count());
+        struct MeshData        meshData;
+        struct MeshImportStats importStats;
+        if (!mesh_import_obj(options.mesh, &importJobs, &meshData, &importStats))
+            exit(EXIT_FAILURE);
+        jobs_destroy(&importJobs);
+
+        sceneMesh = mesh_batch_add(&meshBatch,
+                                   meshData.vertices,
+                                   meshData.verticesCount,
+                                   meshData.indices,
+                                   meshData.indicesCount);
+        printf("mesh %s\n", options.mesh);
+        printf("  %.1f MB parsed in %.3f ms, %d chunk(s) on %d thread(s), %.1f MB/s\n",
+               (double) importStats.bytes / 1e6,
+               importStats.parseSeconds * 1e3,
+               importStats.chunks,
+               jobs_cpu_count(),
+               (double) importStats.bytes / 1e6 / importStats.parseSeconds);
+        printf("  %u corner(s) welded into %u vertices in %.3f ms\n",
+               importStats.corners,
+               meshData.verticesCount,
+               importStats.weldSeconds * 1e3);
+        printf("  %u triangle(s), ACMR %.3f before, %.3f after (FIFO %d) in %.3f ms\n",
+               meshData.indicesCount / 3,
+               importStats.acmrBefore,
+               importStats.acmrAfter,
+               MESH_ACMR_CACHE_SIZE,
+               importStats.optimizeSeconds * 1e3);
+        mesh_data_destroy(&meshData);
     }
 
-    /* record ****************************************************************/
-    for (size_t i = 0; i < swapChainImagesCount; i++)
+    struct MeshBuffers meshBuffers;
+    mesh_batch_upload(&meshBatch, &allocator, commandPool, graphicsQueue, &meshBuffers);
+
+    /* bounding spheres for culling, by mesh */
+    float meshRadii[meshBatch.meshesCount];
+    for (uint32_t i = 0; i < meshBatch.meshesCount; ++i)
+        meshRadii[i] = mesh_batch_radius(&meshBatch, i);
+    mesh_batch_clear(&meshBatch);
+
+    /* the scene: one full size entity of the scene mesh, an imported mesh
+     * is fit into the view with y up and z in 0..1 */
+    struct Scene scene;
+    scene_init(&scene, SCENE_CAPACITY);
+    struct Vec3 scenePosition = {0.0f, 0.0f, 0.0f};
+    struct Vec3 sceneScale    = {2.0f, 2.0f, 1.0f}; /* the whole view, see instances_grid */
+    if (sceneMesh != triangle && meshRadii[sceneMesh] > 0.0f)
     {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        beginInfo.pInheritanceInfo         = NULL;    // Optional
+        float scale   = 1.0f / meshRadii[sceneMesh];
+        scenePosition = (struct Vec3){0.0f, 0.0f, 0.5f};
+        sceneScale    = (struct Vec3){scale, -scale, 0.5f * scale};
+    }
+    float    sceneColor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    uint32_t sceneEntity   = scene_entity_create(&scene);
+    scene_transform_add(&scene, sceneEntity, scenePosition, quat_identity(), sceneScale);
+    scene_render_add(&scene, sceneEntity, sceneMesh, sceneColor, meshRadii[sceneMesh]);
 
-        if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
-        {
-            fprintf(stderr, "commandBuffer record start error\n");
-            exit(EXIT_FAILURE);
-        }
+    /* written by frame_record into the slot of every frame */
+    struct SceneFrames sceneFrames;
+    scene_frames_init(&sceneFrames, &allocator, SCENE_CAPACITY, MAX_FRAMES_IN_FLIGHT);
 
-        /* render pass begin */
-        VkRenderPassBeginInfo renderPassBeginInfo = {};
-        renderPassBeginInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassBeginInfo.renderPass            = renderPass;
-        renderPassBeginInfo.framebuffer           = swapChainFramebuffers[i];
+    allocator_stats_print(&allocator);
 
-        renderPassBeginInfo.renderArea.offset.x = 0;
-        renderPassBeginInfo.renderArea.offset.y = 0;
-        renderPassBeginInfo.renderArea.extent   = swapChainConfigExtent;
 
-        VkClearValue clearColor             = {0.0f, 0.0f, 0.0f, 1.0f};
-        renderPassBeginInfo.clearValueCount = 1;
-        renderPassBeginInfo.pClearValues    = &clearColor;
+    /*************************************************************************/
+    /*                                recorder                               */
+    /*************************************************************************/
+    /* worker threads with a command pool per thread and frame in flight */
+    struct Jobs     jobs     = {};
+    struct Recorder recorder = {};
+    if (options.recordThreads > 0 || options.benchRecording)
+    {
+        uint32_t threadsCount = options.benchRecording ? jobs_cpu_count() : options.recordThreads;
+        if (options.recordThreads > threadsCount)
+            threadsCount = options.recordThreads;
+
+        jobs_init(&jobs, threadsCount);
+        recorder_init(&recorder,
+                      device,
+                      devicePhysicalQueueGraphicsIndex,
+                      MAX_FRAMES_IN_FLIGHT,
+                      threadsCount);
+        printf("recording on %d thread(s)\n", threadsCount);
+    }
 
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-        vkCmdDraw(commandBuffers[i], 3, 1, 0, 0);
-        vkCmdEndRenderPass(commandBuffers[i]);
 
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
+    /*************************************************************************/
+    /*                                 frames                                */
+    /*************************************************************************/
+    /* command buffers are re-recorded every frame, see frame_record */
+    /* all slots exist, options.framesInFlight of them are used */
+    struct Frame frames[MAX_FRAMES_IN_FLIGHT];
+    frames_create(device, devicePhysicalQueueGraphicsIndex, frames, MAX_FRAMES_IN_FLIGHT);
+    printf("%d frame(s) in flight\n", options.framesInFlight);
+
+    /* timestamps of frame slot n are read back when slot n is recorded again */
+    struct GpuTimer gpuTimer = {};
+    if (options.gpuTimings)
+    {
+        gpu_timer_init(&gpuTimer,
+                       devicePhysical,
+                       device,
+                       devicePhysicalQueueGraphicsIndex,
+                       MAX_FRAMES_IN_FLIGHT);
+        if (options.gpuTrace != NULL && !gpu_timer_trace_open(&gpuTimer, options.gpuTrace))
         {
-            fprintf(stderr, "commandBuffer record end error\n");
+            fprintf(stderr, "gpu trace open error: %s\n", options.gpuTrace);
             exit(EXIT_FAILURE);
         }
     }
 
-    /*************************************************************************/
-    /*                                  sync                                 */
-    /*************************************************************************/
-    VkSemaphore imageAvailableSemaphore[MAX_FRAMES_IN_FLIGHT];
-    VkSemaphore renderFinishedSemaphore[MAX_FRAMES_IN_FLIGHT];
-    VkFence     inFlightFences[MAX_FRAMES_IN_FLIGHT];
-
-    VkSemaphoreCreateInfo semaphoreInfo = {};
-    semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    struct FrameRecord frameRecord  = {};
+    frameRecord.pass.renderPass     = renderPass;
+    frameRecord.pass.extent         = swapchain.extent;
+    frameRecord.pass.pipeline       = graphicsPipeline;
+    frameRecord.pass.layout         = pipelineLayout;
+    frameRecord.pass.meshBuffers    = &meshBuffers;
+    frameRecord.pass.meshes         = meshBatch.meshes;
+    frameRecord.framebuffers        = swapchain.framebuffers;
+    frameRecord.bindless            = &bindless;
+    frameRecord.uniforms            = &uniforms;
+    /* identity until there is a camera, draws without a payload as before */
+    struct Mat4 identity = mat4_identity();
+    memcpy(frameRecord.frameUniforms.viewProjection, identity.m, sizeof(identity.m));
+    memcpy(frameRecord.pass.payload.transform, identity.m, sizeof(identity.m));
+    if (options.recordThreads > 0)
+    {
+        frameRecord.recorder = &recorder;
+        frameRecord.jobs     = &jobs;
+        frameRecord.threads  = options.recordThreads;
+    }
+    if (options.gpuTimings)
+        frameRecord.gpuTimer = &gpuTimer;
+    struct Buffer instanceBuffer = {};
+    if (options.gpuCulling && cullSupported)
     {
-        if (vkCreateSemaphore(device, &semaphoreInfo, NULL, &imageAvailableSemaphore[i]) !=
-                VK_SUCCESS ||
-            vkCreateSemaphore(device, &semaphoreInfo, NULL, &renderFinishedSemaphore[i]) !=
-                VK_SUCCESS ||
-            vkCreateFence(device, &fenceInfo, NULL, &inFlightFences[i]) != VK_SUCCESS)
+        /* the transforms of the scene become the objects of the cull pass,
+         * read from a copy written once */
+        const struct ScenePool* transforms = &scene.pools[SCENE_TRANSFORM];
+        struct Instance         objects[transforms->count];
+        uint32_t                objectMeshes[transforms->count];
+        scene_instances_write(&scene, objects);
+        for (uint32_t t = 0; t < transforms->count; ++t)
         {
-            fprintf(stderr, "sync create error\n");
-            exit(EXIT_FAILURE);
+            uint32_t r      = scene_slot(&scene, SCENE_RENDER, transforms->entities[t]);
+            objectMeshes[t] = r != SCENE_NONE ? scene.meshes[r] : sceneMesh;
         }
+        mesh_instances_upload(
+            objects, transforms->count, &allocator, commandPool, graphicsQueue, &instanceBuffer);
+        cull_scene(&cull,
+                   commandPool,
+                   graphicsQueue,
+                   meshBatch.meshes,
+                   meshRadii,
+                   meshBatch.meshesCount,
+                   objectMeshes,
+                   instanceBuffer.buffer,
+                   transforms->count);
+        frameRecord.pass.instanceBuffer = instanceBuffer.buffer;
+        frameRecord.pass.cull           = &cull;
+    }
+    else
+    {
+        frameRecord.scene       = &scene;
+        frameRecord.sceneFrames = &sceneFrames;
     }
 
     /* window check **********************************************************/
-    if (!window)
+    if (!options.headless && !window)
     {
         /* XXX:  missing validation layer destruction  */
         /* TODO: implement deconstructor  */
@@ -1054,64 +1845,172 @@ int main(void)
     /*************************************************************************/
     /*                                  Main                                 */
     /*************************************************************************/
-    /* draw loop *************************************************************/
-    size_t currentFrame = 0;
-    while (!glfwWindowShouldClose(window))
+    /* headless loop *********************************************************/
+    if (options.headless && !options.benchInstancing && !options.benchRecording &&
+        !options.benchPipelines && !options.benchUpload && !options.benchCulling &&
+        !options.benchTextures && !options.benchDrawData && !options.benchScene)
     {
-        glfwPollEvents();
-
-        vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-        vkResetFences(device, 1, &inFlightFences[currentFrame]);
-
-        uint32_t imageIndex;
-        vkAcquireNextImageKHR(device,
-                              swapChain,
-                              UINT64_MAX,
-                              imageAvailableSemaphore[currentFrame],
-                              VK_NULL_HANDLE,
-                              &imageIndex);
-
-        VkSubmitInfo submitInfo = {};
-        submitInfo.sType        = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-        VkSemaphore          waitSemaphores[] = {imageAvailableSemaphore[currentFrame]};
-        VkPipelineStageFlags waitStages[]     = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount         = 1;
-        submitInfo.pWaitSemaphores            = waitSemaphores;
-        submitInfo.pWaitDstStageMask          = waitStages;
-
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers    = &commandBuffers[imageIndex];
-
-        VkSemaphore signalSemaphores[]  = {renderFinishedSemaphore[currentFrame]};
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores    = signalSemaphores;
+        struct FrameStats stats;
+        headless_render(device,
+                        graphicsQueue,
+                        frames,
+                        options.framesInFlight,
+                        swapchain.imagesCount,
+                        &frameRecord,
+                        options.frames,
+                        NULL,
+                        NULL,
+                        &stats);
+
+        printf("headless %s\n", devicePhysicalProperties.deviceName);
+        printf("  %d frame(s) at %dx%d in %.3f s\n",
+               options.frames,
+               swapchain.extent.width,
+               swapchain.extent.height,
+               stats.seconds);
+        printf("  %.1f frames/s\n", stats.framesPerSecond);
+        printf("  frame time p50 %.3f ms\n", stats.frameTimeP50);
+        printf("  frame time p99 %.3f ms\n", stats.frameTimeP99);
+        printf("  record time p50 %.3f ms\n", stats.recordTimeP50);
+        printf("  submit latency p50 %.3f ms, p99 %.3f ms\n", stats.latencyP50, stats.latencyP99);
+    }
 
-        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS)
+    /* benchmarks ************************************************************/
+    struct BenchContext bench = {};
+    bench.options             = &options;
+    bench.device              = device;
+    bench.properties          = &devicePhysicalProperties;
+    bench.graphicsQueue       = graphicsQueue;
+    bench.graphicsFamily      = devicePhysicalQueueGraphicsIndex;
+    bench.transferQueue       = transferQueue;
+    bench.transferFamily      = devicePhysicalQueueTransferIndex;
+    bench.allocator           = &allocator;
+    bench.commandPool         = commandPool;
+    bench.pipelineCache       = pipelineCache;
+    bench.pipelineInfo        = &pipelineInfo;
+    bench.frames              = frames;
+    bench.imagesCount         = swapchain.imagesCount;
+    bench.record              = &frameRecord;
+    bench.bindless            = &bindless;
+    bench.recorder            = &recorder;
+    bench.jobs                = &jobs;
+    bench.cull                = cullSupported ? &cull : NULL;
+    bench.triangle            = triangle;
+    bench.meshRadii           = meshRadii;
+    bench.meshesCount         = meshBatch.meshesCount;
+    bench_run(&bench);
+
+    /* presenter *************************************************************/
+    struct Presenter presenter   = {};
+    presenter.window             = window;
+    presenter.framebufferResized = &framebufferResized;
+    presenter.device             = device;
+    presenter.graphicsQueue      = graphicsQueue;
+    presenter.presentQueue       = presentQueue;
+    presenter.renderPass         = renderPass;
+    presenter.swapchain          = &swapchain;
+    presenter.swapchainConfig    = &swapchainConfig;
+    presenter.frames             = frames;
+    presenter.framesInFlight     = options.framesInFlight;
+
+    /* latency benchmark *****************************************************/
+    /* every supported present mode with 1 to MAX_FRAMES_IN_FLIGHT frames in
+     * flight. latency is CPU submit until the frame's fence is seen
+     * signaled: with vsync the GPU waits for images the display still
+     * holds, so queueing more frames shows up here. */
+    if (options.benchLatency)
+    {
+        printf("latency %s, %d frame(s) per step\n",
+               devicePhysicalProperties.deviceName,
+               options.frames);
+        printf("%-13s %8s %10s %12s %12s\n",
+               "present mode",
+               "frames",
+               "frames/s",
+               "latency p50",
+               "latency p99");
+
+        struct Samples latencies;
+        samples_init(&latencies, options.frames + MAX_FRAMES_IN_FLIGHT);
+
+        for (size_t m = 0; m < PRESENT_MODE_NAMES_COUNT && !glfwWindowShouldClose(window); ++m)
         {
-            fprintf(stderr, "queue submit error\n");
-            exit(EXIT_FAILURE);
-        }
+            VkPresentModeKHR mode      = presentModeNames[m].mode;
+            bool             supported = false;
+            for (uint32_t i = 0; i < swapChainDetails.presentModesCount; ++i)
+                supported |= swapChainDetails.presentModes[i] == mode;
+            if (!supported)
+                continue;
 
-        VkPresentInfoKHR presentInfo = {};
-        presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+            swapchainConfig.presentMode = mode;
+            presenter_recreate(&presenter, &frameRecord);
 
-        presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores    = signalSemaphores;
+            for (uint32_t depth = 1; depth <= MAX_FRAMES_IN_FLIGHT; ++depth)
+            {
+                vkDeviceWaitIdle(device);
+                frames_poll(device, frames, MAX_FRAMES_IN_FLIGHT, NULL);
+                presenter.framesInFlight = depth;
+                presenter.currentFrame   = 0;
 
-        VkSwapchainKHR swapChains[] = {swapChain};
-        presentInfo.swapchainCount  = 1;
-        presentInfo.pSwapchains     = swapChains;
-        presentInfo.pImageIndices   = &imageIndex;
+                /* fill the queue before measuring */
+                for (uint32_t i = 0; i < 2 * depth; ++i)
+                {
+                    glfwPollEvents();
+                    presenter_frame(&presenter, &frameRecord, NULL);
+                }
 
-        presentInfo.pResults = NULL;    // Optional
+                latencies.count    = 0;
+                uint32_t presented = 0;
+                uint64_t start     = util_time_ns();
+                while (presented < options.frames && !glfwWindowShouldClose(window))
+                {
+                    glfwPollEvents();
+                    presented += presenter_frame(&presenter, &frameRecord, &latencies);
+                }
+                for (uint32_t i = 0; i < depth; ++i)
+                    frame_wait(device, &frames[i], &latencies);
+                double seconds = (double) (util_time_ns() - start) / 1e9;
+
+                printf("%-13s %8u %10.1f %9.3f ms %9.3f ms\n",
+                       present_mode_name(mode),
+                       depth,
+                       (double) presented / seconds,
+                       util_percentile(latencies.values, latencies.count, 0.50),
+                       util_percentile(latencies.values, latencies.count, 0.99));
+            }
+        }
+        samples_destroy(&latencies);
 
-        vkQueuePresentKHR(presentQueue, &presentInfo);
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    /* draw loop *************************************************************/
+    uint64_t framesSubmitted = 0;
+    while (!options.headless && !glfwWindowShouldClose(window))
+    {
+        PROFILE_SCOPE("frame");
+        PROFILE_BEGIN(events, "poll events");
+        glfwPollEvents();
+        PROFILE_END(events);
+        hot_reload_poll(
+            &hotReload, &frameRecord.pass.pipeline, framesSubmitted, presenter.framesInFlight);
+        framesSubmitted += presenter_frame(&presenter, &frameRecord, NULL);
     }
     vkDeviceWaitIdle(device);
+    graphicsPipeline = frameRecord.pass.pipeline;
+    hot_reload_stop(&hotReload);
+
+    if (options.gpuTimings)
+    {
+        gpu_timer_flush(&gpuTimer);
+        gpu_timer_stats_print(&gpuTimer);
+    }
+    if (options.profile != NULL)
+    {
+        profiler_summary_print();
+        if (!profiler_trace_write(options.profile))
+            fprintf(stderr, "profile write error: %s\n", options.profile);
+    }
 
 
     /*************************************************************************/
@@ -1130,37 +2029,56 @@ int main(void)
             vkDestroyDebugUtilsMessengerEXT(instance, vkDebugUtilsMessengerEXT, NULL);
         }
     }
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    gpu_timer_destroy(&gpuTimer);
+    frames_destroy(device, frames, MAX_FRAMES_IN_FLIGHT);
+    if (recorder.pools != NULL)
     {
-        vkDestroySemaphore(device, renderFinishedSemaphore[i], NULL);
-        vkDestroySemaphore(device, imageAvailableSemaphore[i], NULL);
-        vkDestroyFence(device, inFlightFences[i], NULL);
+        recorder_destroy(&recorder);
+        jobs_destroy(&jobs);
     }
     vkDestroyCommandPool(device, commandPool, NULL);
-    for (uint32_t i = 0; i < 2; ++i)
+    if (cullSupported)
+        cull_destroy(&cull);
+    if (instanceBuffer.buffer != VK_NULL_HANDLE)
+        buffer_destroy(&allocator, &instanceBuffer);
+    scene_frames_destroy(&sceneFrames, &allocator);
+    scene_destroy(&scene);
+    mesh_buffers_destroy(&allocator, &meshBuffers);
+    mesh_batch_destroy(&meshBatch);
+    vkDestroyPipeline(device, graphicsPipeline, NULL);
+    if (pipelineCache != VK_NULL_HANDLE)
     {
-        VkFramebuffer frameBuffer = swapChainFramebuffers[i];
-        vkDestroyFramebuffer(device, frameBuffer, NULL);
+        if (!pipeline_cache_save(
+                device, &devicePhysicalProperties, pipelineCache, options.pipelineCache))
+        {
+            fprintf(stderr, "pipeline cache save error: %s\n", options.pipelineCache);
+        }
+        vkDestroyPipelineCache(device, pipelineCache, NULL);
     }
-    vkDestroyPipeline(device, graphicsPipeline, NULL);
     vkDestroyPipelineLayout(device, pipelineLayout, NULL);
+    bindless_destroy(&bindless, &allocator);
+    uniform_ring_destroy(&uniforms, &allocator);
     vkDestroyRenderPass(device, renderPass, NULL);
-    for (uint32_t i = 0; i < 2; ++i)
+    for (uint32_t i = 0; i < 3; ++i)
     {
         VkShaderModule shaderModule = shaderModules[i];
         vkDestroyShaderModule(device, shaderModule, NULL);
     }
-    for (uint32_t i = 0; i < swapChainImagesCount; ++i)
+    pack_close(&pack);
+    swapchain_destroy(&swapchain, &swapchainConfig);
+    if (!options.headless)
     {
-        VkImageView imageView = swapChainImageViews[i];
-        vkDestroyImageView(device, imageView, NULL);
+        vkDestroySurfaceKHR(instance, surface, NULL);
     }
-    vkDestroySwapchainKHR(device, swapChain, NULL);
-    vkDestroySurfaceKHR(instance, surface, NULL);
+    allocator_destroy(&allocator);
     vkDestroyDevice(device, NULL);
     vkDestroyInstance(instance, NULL);
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (!options.headless)
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    profiler_shutdown();
 
     exit(EXIT_SUCCESS);
 }
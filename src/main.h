@@ -1,11 +1,80 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /* clang-format off */
 #define WINDOW_WIDTH  800
 #define WINDOW_HEIGHT 600
 #define WINDOW_TITLE  "tjtech1"
 
-#define MAX_FRAMES_IN_FLIGHT 2
+#define MAX_FRAMES_IN_FLIGHT     4
+#define FRAMES_IN_FLIGHT_DEFAULT 2
+
+#define HEADLESS_IMAGE_COUNT    3
+#define HEADLESS_FRAMES_DEFAULT 1000
+#define BENCH_FRAMES_DEFAULT    100  /* per benchmark step */
+#define BENCH_DRAWS_DEFAULT     10000
+#define BENCH_PIPELINES_DEFAULT 64
+#define BENCH_PIPELINES_MAX     128  /* distinct variants of the pipeline */
+#define BENCH_UPLOAD_CHUNK      (4u << 20) /* streamed per frame */
+#define BENCH_UPLOAD_BUFFERS    8
+#define BENCH_CULLING_SPREAD    2.0f /* grid scale, about 1/SPREAD^2 of it is visible */
+#define BENCH_TEXTURES          128
+#define BENCH_TEXTURES_SIZE     512
+#define BENCH_TEXTURES_WINDOW   32   /* textures used per frame */
+#define BENCH_TEXTURES_STEP     4    /* frames before the window moves on by one */
+#define BENCH_DRAW_DATA_DRAWS   100000
+#define BENCH_MATH_COUNT        100000 /* elements per kernel call */
+#define BENCH_SCENE_ENTITIES    1000000
+
+#define SCENE_CAPACITY 1024 /* entities of the drawn scene */
+
+#define TEXTURE_BUDGET_DEFAULT 32 /* MiB */
+
+#define UPLOAD_STAGING_SIZE (32u << 20)
+
+#define PIPELINE_CACHE_FILE "pipeline.cache"
 /* clang-format on */
 
+/* GLSL sources and compiler for --hot-reload, set by cmake */
+#ifndef TJTECH1_SHADER_SOURCE_DIR
+#define TJTECH1_SHADER_SOURCE_DIR "shaders"
+#endif
+#ifndef TJTECH1_GLSLANG
+#define TJTECH1_GLSLANG "glslangValidator"
+#endif
+
 #define _VK_MAKE_VERSION(major, minor, patch) (((major) << 22u) | ((minor) << 12u) | (patch))
+
+/* command line options */
+struct Options
+{
+    bool        headless;        /* render into offscreen images, no window/surface */
+    uint32_t    frames;          /* headless: number of frames to render */
+    const char* pipelineCache;   /* pipeline cache file, NULL disables it */
+    uint32_t    recordThreads;   /* 0: record inline, else secondaries on n threads */
+    bool        benchInstancing; /* headless, time 1..1M instances per draw */
+    bool        benchRecording;  /* headless, time recording over thread counts */
+    uint32_t    draws;           /* draws in the recording benchmark */
+    const char* presentMode;     /* NULL: mailbox if supported, else fifo */
+    uint32_t    framesInFlight;  /* 1 to MAX_FRAMES_IN_FLIGHT */
+    bool        benchLatency;    /* windowed, time every present mode and depth */
+    bool        gpuTimings;      /* timestamp queries, summary on exit */
+    const char* gpuTrace;        /* .csv or .json file of every timed frame, NULL: none */
+    const char* profile;         /* CPU profiler trace .json, NULL: no summary/trace */
+    const char* shaderDir;       /* .spv overrides, NULL: embedded shaders only */
+    const char* pack;            /* asset pack to map, NULL: none */
+    bool        hotReload;       /* windowed, rebuild the pipeline on GLSL changes */
+    bool        benchPipelines;  /* headless, time to first frame, sync vs async compile */
+    uint32_t    pipelines;       /* variants in the pipeline benchmark */
+    bool        benchUpload;     /* headless, frame times while streaming buffers */
+    bool        gpuCulling;      /* draw the scene through the compute cull pass */
+    bool        benchCulling;    /* headless, CPU vs GPU culling at 10k..1M objects */
+    const char* mesh;            /* .obj file drawn instead of the triangle, NULL: none */
+    bool        benchTextures;   /* headless, texture streaming under textureBudget */
+    uint32_t    textureBudget;   /* MiB of streamed texture images */
+    bool        benchDrawData;   /* headless, per draw transforms: push, uniform, storage */
+    bool        benchMath;       /* CPU only, batch math kernels per SIMD path */
+    bool        benchScene;      /* SoA scene update and draw vs one object per entity */
+};
@@ -0,0 +1,157 @@
+#include "mesh.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* mesh_grow(void* array, uint32_t* capacity, uint32_t required, size_t elementSize)
+{
+    if (required <= *capacity)
+        return array;
+
+    uint32_t capacityNew = *capacity ? *capacity : 64;
+    while (capacityNew < required)
+        capacityNew *= 2;
+
+    array = realloc(array, capacityNew * elementSize);
+    if (array == NULL)
+    {
+        fprintf(stderr, "mesh batch out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = capacityNew;
+    return array;
+}
+
+uint32_t mesh_batch_add(struct MeshBatch*    batch,
+                        const struct Vertex* vertices,
+                        uint32_t             verticesCount,
+                        const uint32_t*      indices,
+                        uint32_t             indicesCount)
+{
+    batch->vertices = mesh_grow(batch->vertices,
+                                &batch->verticesCapacity,
+                                batch->verticesCount + verticesCount,
+                                sizeof(batch->vertices[0]));
+    batch->indices  = mesh_grow(batch->indices,
+                               &batch->indicesCapacity,
+                               batch->indicesCount + indicesCount,
+                               sizeof(batch->indices[0]));
+    batch->meshes   = mesh_grow(
+        batch->meshes, &batch->meshesCapacity, batch->meshesCount + 1, sizeof(batch->meshes[0]));
+
+    struct Mesh* mesh  = &batch->meshes[batch->meshesCount];
+    mesh->indexCount   = indicesCount;
+    mesh->firstIndex   = batch->indicesCount;
+    mesh->vertexOffset = (int32_t) batch->verticesCount;
+
+    memcpy(batch->vertices + batch->verticesCount, vertices, verticesCount * sizeof(vertices[0]));
+    memcpy(batch->indices + batch->indicesCount, indices, indicesCount * sizeof(indices[0]));
+    batch->verticesCount += verticesCount;
+    batch->indicesCount += indicesCount;
+
+    return batch->meshesCount++;
+}
+
+void mesh_batch_upload(const struct MeshBatch* batch,
+                       struct Allocator*       allocator,
+                       VkCommandPool           commandPool,
+                       VkQueue                 queue,
+                       struct MeshBuffers*     buffers)
+{
+    struct BufferUpload uploads[2] = {};
+    uploads[0].buffer              = &buffers->vertices;
+    uploads[0].data                = batch->vertices;
+    uploads[0].size                = batch->verticesCount * sizeof(batch->vertices[0]);
+    uploads[0].usage               = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    uploads[1].buffer              = &buffers->indices;
+    uploads[1].data                = batch->indices;
+    uploads[1].size                = batch->indicesCount * sizeof(batch->indices[0]);
+    uploads[1].usage               = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+    buffer_upload(allocator, commandPool, queue, uploads, 2);
+}
+
+void mesh_instances_upload(const struct Instance* instances,
+                           uint32_t               instancesCount,
+                           struct Allocator*      allocator,
+                           VkCommandPool          commandPool,
+                           VkQueue                queue,
+                           struct Buffer*         buffer)
+{
+    struct BufferUpload upload = {};
+    upload.buffer              = buffer;
+    upload.data                = instances;
+    upload.size                = instancesCount * sizeof(instances[0]);
+    upload.usage               = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+    buffer_upload(allocator, commandPool, queue, &upload, 1);
+}
+
+void mesh_bind(VkCommandBuffer           commandBuffer,
+               const struct MeshBuffers* buffers,
+               VkBuffer                  instanceBuffer)
+{
+    VkBuffer     vertexBuffers[] = {buffers->vertices.buffer, instanceBuffer};
+    VkDeviceSize offsets[]       = {0, 0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, buffers->indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void mesh_draw(VkCommandBuffer    commandBuffer,
+               const struct Mesh* mesh,
+               uint32_t           firstInstance,
+               uint32_t           instancesCount)
+{
+    vkCmdDrawIndexed(commandBuffer,
+                     mesh->indexCount,
+                     instancesCount,
+                     mesh->firstIndex,
+                     mesh->vertexOffset,
+                     firstInstance);
+}
+
+float mesh_batch_radius(const struct MeshBatch* batch, uint32_t mesh)
+{
+    const struct Mesh*   range    = &batch->meshes[mesh];
+    const struct Vertex* vertices = batch->vertices + range->vertexOffset;
+
+    float radius2 = 0.0f;
+    for (uint32_t i = 0; i < range->indexCount; ++i)
+    {
+        const float* p  = vertices[batch->indices[range->firstIndex + i]].position;
+        float        d2 = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+        if (d2 > radius2)
+            radius2 = d2;
+    }
+    return sqrtf(radius2);
+}
+
+void mesh_batch_clear(struct MeshBatch* batch)
+{
+    free(batch->vertices);
+    free(batch->indices);
+    batch->vertices         = NULL;
+    batch->indices          = NULL;
+    batch->verticesCount    = 0;
+    batch->verticesCapacity = 0;
+    batch->indicesCount     = 0;
+    batch->indicesCapacity  = 0;
+}
+
+void mesh_batch_destroy(struct MeshBatch* batch)
+{
+    mesh_batch_clear(batch);
+    free(batch->meshes);
+    batch->meshes         = NULL;
+    batch->meshesCount    = 0;
+    batch->meshesCapacity = 0;
+}
+
+void mesh_buffers_destroy(struct Allocator* allocator, struct MeshBuffers* buffers)
+{
+    buffer_destroy(allocator, &buffers->vertices);
+    buffer_destroy(allocator, &buffers->indices);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "buffer.h"
+
+#include <vulkan/vulkan.h>
+
+struct Vertex
+{
+    float position[3];
+    float color[3];
+};
+
+/* per-instance attributes, bound at binding 1 with VK_VERTEX_INPUT_RATE_INSTANCE */
+struct Instance
+{
+    float model[16]; /* column major */
+    float color[4];
+};
+
+/* a mesh is a range inside the shared vertex and index buffers */
+struct Mesh
+{
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t  vertexOffset;
+};
+
+/* collects meshes on the CPU, then uploads all of them in one transfer */
+struct MeshBatch
+{
+    struct Vertex* vertices;
+    uint32_t       verticesCount;
+    uint32_t       verticesCapacity;
+
+    uint32_t* indices;
+    uint32_t  indicesCount;
+    uint32_t  indicesCapacity;
+
+    struct Mesh* meshes;
+    uint32_t     meshesCount;
+    uint32_t     meshesCapacity;
+};
+
+/* device-local geometry shared by all meshes of a batch */
+struct MeshBuffers
+{
+    struct Buffer vertices;
+    struct Buffer indices;
+};
+
+/* appends a mesh, indices are relative to its own vertices. returns its id */
+uint32_t mesh_batch_add(struct MeshBatch*    batch,
+                        const struct Vertex* vertices,
+                        uint32_t             verticesCount,
+                        const uint32_t*      indices,
+                        uint32_t             indicesCount);
+
+/* copies every mesh into device-local buffers with a single staged
+ * submission, see buffer_upload */
+void mesh_batch_upload(const struct MeshBatch* batch,
+                       struct Allocator*       allocator,
+                       VkCommandPool           commandPool,
+                       VkQueue                 queue,
+                       struct MeshBuffers*     buffers);
+
+/* creates a device-local instance buffer holding instances, also readable
+ * as a storage buffer by the cull pass */
+void mesh_instances_upload(const struct Instance* instances,
+                           uint32_t               instancesCount,
+                           struct Allocator*      allocator,
+                           VkCommandPool          commandPool,
+                           VkQueue                queue,
+                           struct Buffer*         buffer);
+
+/* binds the shared geometry (binding 0) and instanceBuffer (binding 1) */
+void mesh_bind(VkCommandBuffer           commandBuffer,
+               const struct MeshBuffers* buffers,
+               VkBuffer                  instanceBuffer);
+
+/* draws instancesCount copies of mesh, buffers must be bound by mesh_bind */
+void mesh_draw(VkCommandBuffer    commandBuffer,
+               const struct Mesh* mesh,
+               uint32_t           firstInstance,
+               uint32_t           instancesCount);
+
+/* radius of the bounding sphere of mesh around its origin, from the CPU
+ * copy of the geometry: call before mesh_batch_clear */
+float mesh_batch_radius(const struct MeshBatch* batch, uint32_t mesh);
+
+/* frees the CPU copy of the geometry, meshes stay valid */
+void mesh_batch_clear(struct MeshBatch* batch);
+
+void mesh_batch_destroy(struct MeshBatch* batch);
+
+void mesh_buffers_destroy(struct Allocator* allocator, struct MeshBuffers* buffers);
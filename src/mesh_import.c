@@ -0,0 +1,505 @@
+#include "mesh_import.h"
+
+#include "mesh_optimize.h"
+#include "util.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* clang-format off */
+#define OBJ_POSITION_LOCAL 0x1u /* index counts from the start of the chunk */
+#define OBJ_NORMAL_LOCAL   0x2u
+#define OBJ_NORMAL_NONE    0x4u
+#define OBJ_NO_COLOR       (-1.0f) /* color[0] of a v without r g b */
+/* clang-format on */
+
+/* a face corner as written, resolved to global indices after all chunks
+ * are parsed. negative OBJ indices count back from the chunk's own end */
+struct ObjCorner
+{
+    int32_t  position;
+    int32_t  normal;
+    uint32_t flags;
+};
+
+/* what one job parsed out of [begin, end), which starts at a line */
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    float*   positions; /* x y z r g b */
+    uint32_t positionsCount;
+    uint32_t positionsCapacity;
+
+    float*   normals; /* x y z */
+    uint32_t normalsCount;
+    uint32_t normalsCapacity;
+
+    struct ObjCorner* corners; /* three per triangle */
+    uint32_t          cornersCount;
+    uint32_t          cornersCapacity;
+
+    uint32_t positionsBase; /* of the chunk in the whole file */
+    uint32_t normalsBase;
+};
+
+/* exits on failure like mesh_import_grow */
+static void* mesh_import_alloc(size_t size)
+{
+    void* memory = malloc(size > 0 ? size : 1);
+    if (memory == NULL)
+    {
+        fprintf(stderr, "mesh import out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static void* mesh_import_grow(void*     array,
+                              uint32_t* capacity,
+                              uint32_t  required,
+                              size_t    elementSize)
+{
+    if (required <= *capacity)
+        return array;
+
+    uint32_t capacityNew = *capacity ? *capacity : 1024;
+    while (capacityNew < required)
+        capacityNew *= 2;
+
+    array = realloc(array, capacityNew * elementSize);
+    if (array == NULL)
+    {
+        fprintf(stderr, "mesh import out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = capacityNew;
+    return array;
+}
+
+static const char* obj_skip(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+/* strtof without locale or NUL terminator, a few ulp off at most */
+static bool obj_float(const char** cursor, const char* end, float* value)
+{
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char* p        = obj_skip(*cursor, end);
+    bool        negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    double   mantissa = 0.0;
+    int32_t  exponent = 0;
+    uint32_t digits   = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p, ++digits)
+        mantissa = mantissa * 10.0 + (*p - '0');
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++digits, --exponent)
+            mantissa = mantissa * 10.0 + (*p - '0');
+    }
+    if (digits == 0)
+        return false;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool exponentNegative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            exponentNegative = *p++ == '-';
+        int32_t e = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            e = e < 1000 ? e * 10 + (*p - '0') : e;
+        exponent += exponentNegative ? -e : e;
+    }
+
+    if (exponent < 0 && -exponent < (int32_t) (sizeof(powers) / sizeof(powers[0])))
+        mantissa /= powers[-exponent];
+    else if (exponent >= 0 && exponent < (int32_t) (sizeof(powers) / sizeof(powers[0])))
+        mantissa *= powers[exponent];
+    else
+        mantissa *= pow(10.0, exponent);
+
+    *value  = (float) (negative ? -mantissa : mantissa);
+    *cursor = p;
+    return true;
+}
+
+static bool obj_int(const char** cursor, const char* end, int32_t* value)
+{
+    const char* p        = *cursor;
+    bool        negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    int64_t  result = 0;
+    uint32_t digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9' && result <= INT32_MAX; ++p, ++digits)
+        result = result * 10 + (*p - '0');
+    if (digits == 0 || result > INT32_MAX)
+        return false;
+
+    *value  = (int32_t) (negative ? -result : result);
+    *cursor = p;
+    return true;
+}
+
+/* v, v/vt, v//vn or v/vt/vn. vt is skipped, the Vertex has no texcoord */
+static bool obj_corner(const struct ObjChunk* chunk,
+                       const char**           cursor,
+                       const char*            end,
+                       struct ObjCorner*      corner)
+{
+    const char* p = obj_skip(*cursor, end);
+    int32_t     position;
+    if (!obj_int(&p, end, &position) || position == 0)
+        return false;
+
+    *corner       = (struct ObjCorner){};
+    corner->flags = OBJ_NORMAL_NONE;
+    if (position > 0)
+        corner->position = position - 1;
+    else
+    {
+        corner->position = (int32_t) chunk->positionsCount + position;
+        corner->flags |= OBJ_POSITION_LOCAL;
+    }
+
+    if (p < end && *p == '/')
+    {
+        int32_t ignored;
+        ++p;
+        if (p < end && *p != '/' && !obj_int(&p, end, &ignored))
+            return false;
+        if (p < end && *p == '/')
+        {
+            int32_t normal;
+            ++p;
+            if (!obj_int(&p, end, &normal) || normal == 0)
+                return false;
+            corner->flags &= ~OBJ_NORMAL_NONE;
+            if (normal > 0)
+                corner->normal = normal - 1;
+            else
+            {
+                corner->normal = (int32_t) chunk->normalsCount + normal;
+                corner->flags |= OBJ_NORMAL_LOCAL;
+            }
+        }
+    }
+    *cursor = p;
+    return true;
+}
+
+static void obj_chunk_parse(struct ObjChunk* chunk)
+{
+    const char* p   = chunk->begin;
+    const char* end = chunk->end;
+    while (p < end)
+    {
+        const char* lineEnd = memchr(p, '\n', (size_t) (end - p));
+        if (lineEnd == NULL)
+            lineEnd = end;
+        const char* line = obj_skip(p, lineEnd);
+        p                = lineEnd + 1;
+
+        if (lineEnd - line < 2 || (line[1] != ' ' && line[1] != '\t' && line[1] != 'n'))
+            continue;
+
+        if (line[0] == 'v' && line[1] != 'n')
+        {
+            chunk->positions = mesh_import_grow(chunk->positions,
+                                                &chunk->positionsCapacity,
+                                                chunk->positionsCount + 1,
+                                                6 * sizeof(chunk->positions[0]));
+            float*      position = &chunk->positions[chunk->positionsCount * 6];
+            const char* cursor   = line + 1;
+            if (!obj_float(&cursor, lineEnd, &position[0]) ||
+                !obj_float(&cursor, lineEnd, &position[1]) ||
+                !obj_float(&cursor, lineEnd, &position[2]))
+                continue;
+            if (!obj_float(&cursor, lineEnd, &position[3]) ||
+                !obj_float(&cursor, lineEnd, &position[4]) ||
+                !obj_float(&cursor, lineEnd, &position[5]))
+                position[3] = OBJ_NO_COLOR;
+            chunk->positionsCount++;
+        }
+        else if (line[0] == 'v' && line[1] == 'n')
+        {
+            chunk->normals = mesh_import_grow(chunk->normals,
+                                              &chunk->normalsCapacity,
+                                              chunk->normalsCount + 1,
+                                              3 * sizeof(chunk->normals[0]));
+            float*      normal = &chunk->normals[chunk->normalsCount * 3];
+            const char* cursor = line + 2;
+            if (obj_float(&cursor, lineEnd, &normal[0]) &&
+                obj_float(&cursor, lineEnd, &normal[1]) && obj_float(&cursor, lineEnd, &normal[2]))
+                chunk->normalsCount++;
+        }
+        else if (line[0] == 'f' && line[1] != 'n')
+        {
+            /* fan: every corner after the second adds (first, previous, it) */
+            struct ObjCorner fan[3];
+            const char*      cursor = line + 1;
+            uint32_t         count  = 0;
+            while (obj_corner(chunk, &cursor, lineEnd, &fan[count < 2 ? count : 2]))
+            {
+                if (++count < 3)
+                    continue;
+                chunk->corners = mesh_import_grow(chunk->corners,
+                                                  &chunk->cornersCapacity,
+                                                  chunk->cornersCount + 3,
+                                                  sizeof(chunk->corners[0]));
+                memcpy(&chunk->corners[chunk->cornersCount], fan, sizeof(fan));
+                chunk->cornersCount += 3;
+                fan[1] = fan[2];
+            }
+        }
+    }
+}
+
+static void obj_chunk_job(void* context, uint32_t index)
+{
+    obj_chunk_parse(&((struct ObjChunk*) context)[index]);
+}
+
+static uint32_t mesh_import_hash(const struct Vertex* vertex)
+{
+    uint32_t words[sizeof(*vertex) / sizeof(uint32_t)];
+    memcpy(words, vertex, sizeof(words));
+
+    /* FNV-1a over words, with a final avalanche */
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i)
+        hash = (hash ^ words[i]) * 16777619u;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/* corner to vertex: the OBJ color, else the normal mapped to 0..1, else white */
+static bool mesh_import_vertex(const struct ObjChunk* chunk,
+                               const struct ObjCorner* corner,
+                               const float*            positions,
+                               uint32_t                positionsCount,
+                               const float*            normals,
+                               uint32_t                normalsCount,
+                               struct Vertex*          vertex)
+{
+    int64_t position = corner->position;
+    if (corner->flags & OBJ_POSITION_LOCAL)
+        position += chunk->positionsBase;
+    if (position < 0 || position >= positionsCount)
+        return false;
+
+    const float* p = &positions[position * 6];
+    memcpy(vertex->position, p, sizeof(vertex->position));
+    if (p[3] != OBJ_NO_COLOR)
+    {
+        memcpy(vertex->color, &p[3], sizeof(vertex->color));
+        return true;
+    }
+    if (corner->flags & OBJ_NORMAL_NONE)
+    {
+        vertex->color[0] = vertex->color[1] = vertex->color[2] = 1.0f;
+        return true;
+    }
+
+    int64_t normal = corner->normal;
+    if (corner->flags & OBJ_NORMAL_LOCAL)
+        normal += chunk->normalsBase;
+    if (normal < 0 || normal >= normalsCount)
+        return false;
+    for (uint32_t i = 0; i < 3; ++i)
+        vertex->color[i] = normals[normal * 3 + i] * 0.5f + 0.5f;
+    return true;
+}
+
+bool mesh_import_obj(const char*             path,
+                     struct Jobs*            jobs,
+                     struct MeshData*        mesh,
+                     struct MeshImportStats* stats)
+{
+    *mesh  = (struct MeshData){};
+    *stats = (struct MeshImportStats){};
+
+    char* text = NULL;
+    int   size = ae_load_file_to_memory(path, &text);
+    if (size < 0)
+    {
+        fprintf(stderr, "mesh import: can not read %s\n", path);
+        return false;
+    }
+    stats->bytes = (size_t) size;
+
+    /* parse ******************************************************************/
+    uint64_t parseStart = util_time_ns();
+
+    /* a few chunks per thread even out lines of uneven cost */
+    uint32_t threads = jobs != NULL ? jobs_threads_count(jobs) : 1;
+    uint32_t count   = (uint32_t) (stats->bytes / MESH_IMPORT_CHUNK_MIN);
+    if (count > threads * 4)
+        count = threads * 4;
+    if (count == 0)
+        count = 1;
+
+    struct ObjChunk* chunks = mesh_import_alloc(count * sizeof(chunks[0]));
+    memset(chunks, 0, count * sizeof(chunks[0]));
+
+    const char* end   = text + size;
+    const char* begin = text;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const char* split = text + (size_t) ((uint64_t) size * (i + 1) / count);
+        if (split < begin)
+            split = begin;
+        const char* lineEnd = memchr(split, '\n', (size_t) (end - split));
+        chunks[i].begin     = begin;
+        chunks[i].end       = i + 1 == count || lineEnd == NULL ? end : lineEnd + 1;
+        begin               = chunks[i].end;
+    }
+
+    if (jobs != NULL)
+        jobs_run(jobs, obj_chunk_job, chunks, count);
+    else
+        for (uint32_t i = 0; i < count; ++i)
+            obj_chunk_job(chunks, i);
+
+    /* local indices become global once every chunk's counts are known */
+    uint32_t positionsCount = 0;
+    uint32_t normalsCount   = 0;
+    uint32_t cornersCount   = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        chunks[i].positionsBase = positionsCount;
+        chunks[i].normalsBase   = normalsCount;
+        positionsCount += chunks[i].positionsCount;
+        normalsCount += chunks[i].normalsCount;
+        cornersCount += chunks[i].cornersCount;
+    }
+
+    float* positions = mesh_import_alloc(((size_t) positionsCount * 6 + 1) * sizeof(positions[0]));
+    float* normals   = mesh_import_alloc(((size_t) normalsCount * 3 + 1) * sizeof(normals[0]));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (chunks[i].positionsCount > 0)
+            memcpy(positions + (size_t) chunks[i].positionsBase * 6,
+                   chunks[i].positions,
+                   chunks[i].positionsCount * 6 * sizeof(positions[0]));
+        if (chunks[i].normalsCount > 0)
+            memcpy(normals + (size_t) chunks[i].normalsBase * 3,
+                   chunks[i].normals,
+                   chunks[i].normalsCount * 3 * sizeof(normals[0]));
+    }
+    free(text);
+
+    stats->chunks       = count;
+    stats->corners      = cornersCount;
+    stats->parseSeconds = (double) (util_time_ns() - parseStart) / 1e9;
+
+    /* weld *******************************************************************/
+    uint64_t weldStart = util_time_ns();
+
+    /* open addressing, at most half full */
+    uint32_t capacity = 16;
+    while (capacity < cornersCount * 2)
+        capacity *= 2;
+    uint32_t* slots = mesh_import_alloc(capacity * sizeof(slots[0]));
+    memset(slots, 0xff, capacity * sizeof(slots[0]));
+
+    mesh->vertices = mesh_import_alloc(((size_t) cornersCount + 1) * sizeof(mesh->vertices[0]));
+    mesh->indices  = mesh_import_alloc(((size_t) cornersCount + 1) * sizeof(mesh->indices[0]));
+    bool valid     = true;
+    for (uint32_t c = 0; c < count && valid; ++c)
+    {
+        const struct ObjChunk* chunk = &chunks[c];
+        for (uint32_t i = 0; i < chunk->cornersCount && valid; i += 3)
+        {
+            uint32_t triangle[3];
+            for (uint32_t k = 0; k < 3 && valid; ++k)
+            {
+                struct Vertex vertex;
+                valid = mesh_import_vertex(chunk,
+                                           &chunk->corners[i + k],
+                                           positions,
+                                           positionsCount,
+                                           normals,
+                                           normalsCount,
+                                           &vertex);
+                if (!valid)
+                    break;
+
+                uint32_t slot = mesh_import_hash(&vertex) & (capacity - 1);
+                while (slots[slot] != UINT32_MAX &&
+                       memcmp(&mesh->vertices[slots[slot]], &vertex, sizeof(vertex)) != 0)
+                    slot = (slot + 1) & (capacity - 1);
+                if (slots[slot] == UINT32_MAX)
+                {
+                    slots[slot]                           = mesh->verticesCount;
+                    mesh->vertices[mesh->verticesCount++] = vertex;
+                }
+                triangle[k] = slots[slot];
+            }
+
+            /* welding can collapse a sliver into a line */
+            if (valid && triangle[0] != triangle[1] && triangle[1] != triangle[2] &&
+                triangle[2] != triangle[0])
+            {
+                memcpy(&mesh->indices[mesh->indicesCount], triangle, sizeof(triangle));
+                mesh->indicesCount += 3;
+            }
+        }
+    }
+    free(slots);
+    free(normals);
+    free(positions);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        free(chunks[i].positions);
+        free(chunks[i].normals);
+        free(chunks[i].corners);
+    }
+    free(chunks);
+    stats->weldSeconds = (double) (util_time_ns() - weldStart) / 1e9;
+
+    if (!valid || mesh->indicesCount == 0)
+    {
+        fprintf(stderr,
+                "mesh import: %s %s\n",
+                path,
+                valid ? "has no triangles" : "has a face index out of range");
+        mesh_data_destroy(mesh);
+        return false;
+    }
+
+    /* optimize ***************************************************************/
+    uint64_t optimizeStart = util_time_ns();
+    stats->acmrBefore      = mesh_acmr(
+        mesh->indices, mesh->indicesCount, mesh->verticesCount, MESH_ACMR_CACHE_SIZE);
+    mesh_optimize_vertex_cache(mesh->indices, mesh->indicesCount, mesh->verticesCount);
+    mesh->verticesCount = mesh_optimize_vertex_fetch(
+        mesh->vertices, mesh->verticesCount, mesh->indices, mesh->indicesCount);
+    stats->acmrAfter = mesh_acmr(
+        mesh->indices, mesh->indicesCount, mesh->verticesCount, MESH_ACMR_CACHE_SIZE);
+    stats->optimizeSeconds = (double) (util_time_ns() - optimizeStart) / 1e9;
+    return true;
+}
+
+void mesh_data_destroy(struct MeshData* mesh)
+{
+    free(mesh->vertices);
+    free(mesh->indices);
+    *mesh = (struct MeshData){};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "jobs.h"
+#include "mesh.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* clang-format off */
+#define MESH_IMPORT_CHUNK_MIN (1u << 20) /* bytes of OBJ text per parse job, at least */
+/* clang-format on */
+
+/* one imported mesh, ready for mesh_batch_add */
+struct MeshData
+{
+    struct Vertex* vertices;
+    uint32_t       verticesCount;
+    uint32_t*      indices;
+    uint32_t       indicesCount;
+};
+
+struct MeshImportStats
+{
+    size_t   bytes;
+    uint32_t chunks;
+    double   parseSeconds;  /* text to triangles, on all threads */
+    double   weldSeconds;   /* vertex deduplication */
+    double   optimizeSeconds;
+    uint32_t corners;       /* vertices before deduplication */
+    double   acmrBefore;    /* mesh_acmr, MESH_ACMR_CACHE_SIZE */
+    double   acmrAfter;
+};
+
+/* loads a Wavefront OBJ: v (with optional r g b), vn and f with any
+ * number of corners (fanned into triangles, negative indices allowed).
+ * the text is split at line ends into chunks parsed on jobs (NULL: on the
+ * calling thread). vertices are welded through a hash of their contents,
+ * then triangles are reordered for the post-transform cache and vertices
+ * for fetch locality. the vertex color is the OBJ color, else the normal
+ * mapped to 0..1, else white. false with a message on stderr if the file
+ * can not be read or has no triangles */
+bool mesh_import_obj(const char*             path,
+                     struct Jobs*            jobs,
+                     struct MeshData*        mesh,
+                     struct MeshImportStats* stats);
+
+void mesh_data_destroy(struct MeshData* mesh);
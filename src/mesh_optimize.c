@@ -0,0 +1,256 @@
+#include "mesh_optimize.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* clang-format off */
+#define MESH_CACHE_DECAY   1.5f  /* falloff of the score over the cache */
+#define MESH_LAST_TRIANGLE 0.75f /* the three vertices just used, so strips do not win outright */
+#define MESH_VALENCE_BOOST 2.0f  /* vertices with few triangles left go first */
+#define MESH_VALENCE_MAX   32    /* table size, more live triangles score like the last entry */
+/* clang-format on */
+
+double mesh_acmr(const uint32_t* indices,
+                 uint32_t        indicesCount,
+                 uint32_t        verticesCount,
+                 uint32_t        cacheSize)
+{
+    if (indicesCount < 3)
+        return 0.0;
+
+    /* a vertex is still in the FIFO while fewer than cacheSize misses
+     * came after its own */
+    uint32_t* inserted = malloc(verticesCount * sizeof(inserted[0]));
+    if (inserted == NULL)
+    {
+        fprintf(stderr, "mesh acmr out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(inserted, 0xff, verticesCount * sizeof(inserted[0]));
+
+    uint32_t misses = 0;
+    for (uint32_t i = 0; i < indicesCount; ++i)
+    {
+        uint32_t vertex = indices[i];
+        if (inserted[vertex] == UINT32_MAX || misses - inserted[vertex] >= cacheSize)
+            inserted[vertex] = misses++;
+    }
+    free(inserted);
+    return (double) misses / (double) (indicesCount / 3);
+}
+
+static void* mesh_optimize_alloc(size_t size)
+{
+    void* memory = malloc(size > 0 ? size : 1);
+    if (memory == NULL)
+    {
+        fprintf(stderr, "mesh optimize out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+/* score tables, see mesh_vertex_score */
+struct MeshScores
+{
+    float cache[MESH_OPTIMIZE_CACHE_SIZE];
+    float valence[MESH_VALENCE_MAX + 1];
+};
+
+static void mesh_scores_init(struct MeshScores* scores)
+{
+    for (uint32_t i = 0; i < MESH_OPTIMIZE_CACHE_SIZE; ++i)
+    {
+        if (i < 3)
+            scores->cache[i] = MESH_LAST_TRIANGLE;
+        else
+            scores->cache[i] = powf(1.0f - (float) (i - 3) / (MESH_OPTIMIZE_CACHE_SIZE - 3),
+                                    MESH_CACHE_DECAY);
+    }
+    scores->valence[0] = 0.0f;
+    for (uint32_t i = 1; i <= MESH_VALENCE_MAX; ++i)
+        scores->valence[i] = MESH_VALENCE_BOOST / sqrtf((float) i);
+}
+
+/* higher for vertices recently used and with few triangles left, -1 once
+ * all of them are emitted */
+static float mesh_vertex_score(const struct MeshScores* scores,
+                               int32_t                  cachePosition,
+                               uint32_t                 liveTriangles)
+{
+    if (liveTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+        score = scores->cache[cachePosition];
+    if (liveTriangles > MESH_VALENCE_MAX)
+        liveTriangles = MESH_VALENCE_MAX;
+    return score + scores->valence[liveTriangles];
+}
+
+void mesh_optimize_vertex_cache(uint32_t* indices, uint32_t indicesCount, uint32_t verticesCount)
+{
+    uint32_t trianglesCount = indicesCount / 3;
+    if (trianglesCount < 2)
+        return;
+
+    struct MeshScores scores;
+    mesh_scores_init(&scores);
+
+    /* triangles of every vertex: [first[v], first[v] + live[v]) of adjacency
+     * are the ones not emitted yet */
+    uint32_t* live      = mesh_optimize_alloc(verticesCount * sizeof(live[0]));
+    uint32_t* first     = mesh_optimize_alloc(verticesCount * sizeof(first[0]));
+    uint32_t* adjacency = mesh_optimize_alloc(trianglesCount * 3 * sizeof(adjacency[0]));
+    memset(live, 0, verticesCount * sizeof(live[0]));
+    for (uint32_t i = 0; i < trianglesCount * 3; ++i)
+        live[indices[i]]++;
+
+    uint32_t offset = 0;
+    for (uint32_t v = 0; v < verticesCount; ++v)
+    {
+        first[v] = offset;
+        offset += live[v];
+        live[v] = 0;
+    }
+    for (uint32_t i = 0; i < trianglesCount * 3; ++i)
+    {
+        uint32_t vertex                           = indices[i];
+        adjacency[first[vertex] + live[vertex]++] = i / 3;
+    }
+
+    int32_t* cachePosition = mesh_optimize_alloc(verticesCount * sizeof(cachePosition[0]));
+    float*   vertexScore   = mesh_optimize_alloc(verticesCount * sizeof(vertexScore[0]));
+    for (uint32_t v = 0; v < verticesCount; ++v)
+    {
+        cachePosition[v] = -1;
+        vertexScore[v]   = mesh_vertex_score(&scores, -1, live[v]);
+    }
+
+    bool* emitted = mesh_optimize_alloc(trianglesCount * sizeof(emitted[0]));
+    memset(emitted, 0, trianglesCount * sizeof(emitted[0]));
+
+    uint32_t* output = mesh_optimize_alloc(trianglesCount * 3 * sizeof(output[0]));
+
+    /* the three new vertices go in front, the rest is shifted back and
+     * whatever falls past the cache size is evicted */
+    uint32_t cache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    uint32_t cacheNext[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    uint32_t cacheCount = 0;
+
+    int64_t  best   = -1;
+    uint32_t cursor = 0; /* no triangle before it is left */
+    for (uint32_t emittedCount = 0; emittedCount < trianglesCount; ++emittedCount)
+    {
+        /* nothing in the cache has triangles left: next one in input order */
+        if (best < 0)
+        {
+            while (emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+
+        uint32_t        triangle = (uint32_t) best;
+        const uint32_t* corners  = &indices[triangle * 3];
+        memcpy(&output[emittedCount * 3], corners, 3 * sizeof(corners[0]));
+        emitted[triangle] = true;
+
+        uint32_t cacheNextCount = 0;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            uint32_t vertex = corners[c];
+
+            /* drop triangle from the live part of the vertex's list */
+            uint32_t* triangles = &adjacency[first[vertex]];
+            for (uint32_t i = 0; i < live[vertex]; ++i)
+            {
+                if (triangles[i] == triangle)
+                {
+                    triangles[i] = triangles[--live[vertex]];
+                    break;
+                }
+            }
+            cacheNext[cacheNextCount++] = vertex;
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t vertex = cache[i];
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                cacheNext[cacheNextCount++] = vertex;
+        }
+
+        /* new positions and scores for everything that was or is cached */
+        for (uint32_t i = 0; i < cacheNextCount; ++i)
+        {
+            uint32_t vertex       = cacheNext[i];
+            cachePosition[vertex] = i < MESH_OPTIMIZE_CACHE_SIZE ? (int32_t) i : -1;
+            vertexScore[vertex]   = mesh_vertex_score(&scores, cachePosition[vertex], live[vertex]);
+        }
+
+        /* only triangles touching the cache changed, the best one of them
+         * is next */
+        float bestScore = 0.0f;
+        best            = -1;
+        for (uint32_t i = 0; i < cacheNextCount; ++i)
+        {
+            uint32_t        vertex    = cacheNext[i];
+            const uint32_t* triangles = &adjacency[first[vertex]];
+            for (uint32_t j = 0; j < live[vertex]; ++j)
+            {
+                uint32_t        t     = triangles[j];
+                const uint32_t* other = &indices[t * 3];
+                float           score =
+                    vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best      = t;
+                }
+            }
+        }
+
+        cacheCount = cacheNextCount < MESH_OPTIMIZE_CACHE_SIZE ? cacheNextCount
+                                                               : MESH_OPTIMIZE_CACHE_SIZE;
+        memcpy(cache, cacheNext, cacheCount * sizeof(cache[0]));
+    }
+
+    memcpy(indices, output, trianglesCount * 3 * sizeof(indices[0]));
+    free(output);
+    free(emitted);
+    free(vertexScore);
+    free(cachePosition);
+    free(adjacency);
+    free(first);
+    free(live);
+}
+
+uint32_t mesh_optimize_vertex_fetch(struct Vertex* vertices,
+                                    uint32_t       verticesCount,
+                                    uint32_t*      indices,
+                                    uint32_t       indicesCount)
+{
+    uint32_t* remap = mesh_optimize_alloc(verticesCount * sizeof(remap[0]));
+    memset(remap, 0xff, verticesCount * sizeof(remap[0]));
+
+    struct Vertex* reordered = mesh_optimize_alloc(verticesCount * sizeof(reordered[0]));
+    uint32_t       count     = 0;
+    for (uint32_t i = 0; i < indicesCount; ++i)
+    {
+        uint32_t vertex = indices[i];
+        if (remap[vertex] == UINT32_MAX)
+        {
+            remap[vertex]      = count;
+            reordered[count++] = vertices[vertex];
+        }
+        indices[i] = remap[vertex];
+    }
+
+    memcpy(vertices, reordered, count * sizeof(vertices[0]));
+    free(reordered);
+    free(remap);
+    return count;
+}
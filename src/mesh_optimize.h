@@ -0,0 +1,31 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <stdint.h>
+
+/* clang-format off */
+#define MESH_OPTIMIZE_CACHE_SIZE 32 /* LRU cache modelled by the reordering */
+#define MESH_ACMR_CACHE_SIZE     16 /* FIFO cache of mesh_acmr, a typical post-transform cache */
+/* clang-format on */
+
+/* average cache miss ratio: vertex shader invocations per triangle of a
+ * FIFO post-transform cache of cacheSize entries. 0.5 is the best a
+ * regular grid can do, 3 means every corner is transformed */
+double mesh_acmr(const uint32_t* indices,
+                 uint32_t        indicesCount,
+                 uint32_t        verticesCount,
+                 uint32_t        cacheSize);
+
+/* reorders the triangles of indices in place so triangles sharing
+ * vertices follow each other (Forsyth, linear-speed vertex cache
+ * optimisation). the set of triangles and their winding stay the same */
+void mesh_optimize_vertex_cache(uint32_t* indices, uint32_t indicesCount, uint32_t verticesCount);
+
+/* reorders vertices in the order indices first use them, so the vertex
+ * fetch walks memory forwards, and rewrites indices to match. unused
+ * vertices are dropped. returns the new vertex count */
+uint32_t mesh_optimize_vertex_fetch(struct Vertex* vertices,
+                                    uint32_t       verticesCount,
+                                    uint32_t*      indices,
+                                    uint32_t       indicesCount);
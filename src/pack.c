@@ -0,0 +1,241 @@
+#include "pack.h"
+
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t pack_align(uint64_t offset)
+{
+    return (offset + PACK_ALIGNMENT - 1) & ~(uint64_t) (PACK_ALIGNMENT - 1);
+}
+
+static bool pack_valid(const uint8_t* base, size_t size)
+{
+    if (size < sizeof(struct PackHeader))
+        return false;
+
+    const struct PackHeader* header = (const struct PackHeader*) base;
+    if (header->magic != PACK_MAGIC || header->version != PACK_VERSION || header->size != size ||
+        header->entriesCount > (size - sizeof(*header)) / sizeof(struct PackEntry))
+        return false;
+
+    const struct PackEntry* entries = (const struct PackEntry*) (header + 1);
+    for (uint32_t i = 0; i < header->entriesCount; ++i)
+    {
+        const struct PackEntry* entry = &entries[i];
+        if (memchr(entry->name, '\0', PACK_NAME_SIZE) == NULL || entry->offset % PACK_ALIGNMENT ||
+            entry->offset > size || entry->size > size - entry->offset)
+            return false;
+        if (i > 0 && strcmp(entries[i - 1].name, entry->name) >= 0)
+            return false;
+    }
+    return true;
+}
+
+bool pack_open(struct Pack* pack, const char* path)
+{
+    *pack = (struct Pack){};
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    HANDLE        mapping = NULL;
+    void*         base    = NULL;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping != NULL)
+        base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (base == NULL)
+    {
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    pack->file    = file;
+    pack->mapping = mapping;
+    pack->base    = base;
+    pack->size    = (size_t) fileSize.QuadPart;
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status;
+    void*       base = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+        base = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    /* the mapping keeps the file alive */
+    close(file);
+    if (base == MAP_FAILED)
+        return false;
+
+    pack->base = base;
+    pack->size = (size_t) status.st_size;
+#endif
+
+    if (!pack_valid(pack->base, pack->size))
+    {
+        fprintf(stderr, "pack %s is not a version %u pack\n", path, PACK_VERSION);
+        pack_close(pack);
+        return false;
+    }
+
+    const struct PackHeader* header = (const struct PackHeader*) pack->base;
+    pack->entries                   = (const struct PackEntry*) (header + 1);
+    pack->entriesCount              = header->entriesCount;
+    return true;
+}
+
+void pack_close(struct Pack* pack)
+{
+    if (pack->base != NULL)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(pack->base);
+        CloseHandle(pack->mapping);
+        CloseHandle(pack->file);
+#else
+        munmap((void*) pack->base, pack->size);
+#endif
+    }
+    *pack = (struct Pack){};
+}
+
+const void* pack_find(const struct Pack* pack, const char* name, size_t* size)
+{
+    uint32_t first = 0;
+    uint32_t last  = pack->entriesCount;
+    while (first < last)
+    {
+        uint32_t                middle = first + (last - first) / 2;
+        const struct PackEntry* entry  = &pack->entries[middle];
+        int                     order  = strcmp(entry->name, name);
+        if (order == 0)
+        {
+            *size = (size_t) entry->size;
+            return pack->base + entry->offset;
+        }
+        if (order < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return NULL;
+}
+
+static const char* const* packSortNames;
+
+static int pack_compare_names(const void* a, const void* b)
+{
+    return strcmp(packSortNames[*(const uint32_t*) a], packSortNames[*(const uint32_t*) b]);
+}
+
+bool pack_write(const char*        path,
+                const char* const* names,
+                const char* const* files,
+                uint32_t           count)
+{
+    /* table sorted by name for pack_find */
+    uint32_t order[count + 1];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        order[i] = i;
+        if (strlen(names[i]) >= PACK_NAME_SIZE)
+        {
+            fprintf(stderr, "pack name too long: %s\n", names[i]);
+            return false;
+        }
+    }
+    packSortNames = names;
+    qsort(order, count, sizeof(order[0]), pack_compare_names);
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        if (strcmp(names[order[i - 1]], names[order[i]]) == 0)
+        {
+            fprintf(stderr, "pack name twice: %s\n", names[order[i]]);
+            return false;
+        }
+    }
+
+    struct PackHeader header = {};
+    header.magic             = PACK_MAGIC;
+    header.version           = PACK_VERSION;
+    header.entriesCount      = count;
+
+    struct PackEntry* entries = calloc(count + 1, sizeof(entries[0]));
+    char**            blobs   = calloc(count + 1, sizeof(blobs[0]));
+    uint64_t          offset  = sizeof(header) + count * sizeof(entries[0]);
+    bool              loaded  = entries != NULL && blobs != NULL;
+    for (uint32_t i = 0; i < count && loaded; ++i)
+    {
+        uint32_t source = order[i];
+        int      size   = ae_load_file_to_memory(files[source], &blobs[i]);
+        if (size < 0)
+        {
+            fprintf(stderr, "pack input read error: %s\n", files[source]);
+            loaded = false;
+            break;
+        }
+        strcpy(entries[i].name, names[source]);
+        entries[i].offset = pack_align(offset);
+        entries[i].size   = (uint64_t) size;
+        offset            = entries[i].offset + entries[i].size;
+    }
+    header.size = offset;
+
+    /* write next to the target and rename, so a build never sees half a pack */
+    size_t pathLength = strlen(path);
+    char   pathTemp[pathLength + 5];
+    snprintf(pathTemp, sizeof(pathTemp), "%s.tmp", path);
+
+    bool  written = false;
+    FILE* f       = loaded ? fopen(pathTemp, "wb") : NULL;
+    if (f != NULL)
+    {
+        static const uint8_t padding[PACK_ALIGNMENT];
+
+        uint64_t position = sizeof(header) + count * sizeof(entries[0]);
+        written           = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  fwrite(entries, sizeof(entries[0]), count, f) == count;
+        for (uint32_t i = 0; i < count && written; ++i)
+        {
+            size_t pad = (size_t) (entries[i].offset - position);
+            written    = fwrite(padding, 1, pad, f) == pad &&
+                      fwrite(blobs[i], 1, entries[i].size, f) == entries[i].size;
+            position = entries[i].offset + entries[i].size;
+        }
+        written = (fclose(f) == 0) && written;
+    }
+#ifdef _WIN32
+    /* rename does not replace on windows */
+    if (written)
+        remove(path);
+#endif
+    written = written && rename(pathTemp, path) == 0;
+    if (loaded && !written)
+    {
+        fprintf(stderr, "pack write error: %s\n", path);
+        remove(pathTemp);
+    }
+
+    for (uint32_t i = 0; i < count && blobs != NULL; ++i)
+        free(blobs[i]);
+    free(blobs);
+    free(entries);
+    return written;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* clang-format off */
+#define PACK_MAGIC     0x4b504a54u /* "TJPK" */
+#define PACK_VERSION   1u
+#define PACK_ALIGNMENT 256         /* blob offsets, >= optimalBufferCopyOffsetAlignment
+                                      and nonCoherentAtomSize on common devices */
+#define PACK_NAME_SIZE 48          /* NUL terminated */
+/* clang-format on */
+
+/* file layout: header, entriesCount entries sorted by name, then every
+ * blob at a multiple of PACK_ALIGNMENT. little endian, like every target */
+struct PackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entriesCount;
+    uint32_t reserved;
+    uint64_t size; /* whole file */
+};
+
+struct PackEntry
+{
+    char     name[PACK_NAME_SIZE];
+    uint64_t offset; /* from the start of the file */
+    uint64_t size;
+};
+
+/* a read only mapping of a pack. blobs point into it: hand them to
+ * staging buffer memcpys or VkShaderModuleCreateInfo.pCode as they are,
+ * the OS pages them in on first touch */
+struct Pack
+{
+    const uint8_t*          base;
+    size_t                  size;
+    const struct PackEntry* entries;
+    uint32_t                entriesCount;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+};
+
+/* maps path and validates header and table, false if it is missing or not
+ * a pack */
+bool pack_open(struct Pack* pack, const char* path);
+
+void pack_close(struct Pack* pack);
+
+/* blob of name, NULL if the pack has none. O(log n) */
+const void* pack_find(const struct Pack* pack, const char* name, size_t* size);
+
+/* packs files as names (at most PACK_NAME_SIZE - 1 chars each) into path.
+ * false with a message on stderr on failure */
+bool pack_write(const char*        path,
+                const char* const* names,
+                const char* const* files,
+                uint32_t           count);
@@ -0,0 +1,135 @@
+#include "pipeline_cache.h"
+
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPELINE_CACHE_MAGIC   0x43504a54u /* "TJPC" */
+#define PIPELINE_CACHE_VERSION 1u
+
+/* file layout: header, then dataSize bytes of vkGetPipelineCacheData output */
+struct PipelineCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+};
+
+static bool pipeline_cache_header_valid(const struct PipelineCacheHeader* header,
+                                        const VkPhysicalDeviceProperties* properties,
+                                        size_t                            fileSize)
+{
+    return header->magic == PIPELINE_CACHE_MAGIC && header->version == PIPELINE_CACHE_VERSION &&
+           header->vendorID == properties->vendorID && header->deviceID == properties->deviceID &&
+           memcmp(header->pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+           header->dataSize == fileSize - sizeof(*header);
+}
+
+VkPipelineCache pipeline_cache_load(VkDevice                          device,
+                                    const VkPhysicalDeviceProperties* properties,
+                                    const char*                       path,
+                                    bool*                             warm)
+{
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize           = 0;
+    createInfo.pInitialData              = NULL;
+
+    char* file     = NULL;
+    int   fileSize = path ? ae_load_file_to_memory(path, &file) : -1;
+
+    *warm = false;
+    if (fileSize >= (int) sizeof(struct PipelineCacheHeader))
+    {
+        struct PipelineCacheHeader header;
+        memcpy(&header, file, sizeof(header));
+
+        if (pipeline_cache_header_valid(&header, properties, (size_t) fileSize))
+        {
+            createInfo.initialDataSize = header.dataSize;
+            createInfo.pInitialData    = file + sizeof(header);
+            *warm                      = true;
+        }
+        else
+        {
+            printf("pipeline cache %s does not match device, ignoring\n", path);
+        }
+    }
+
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    if (vkCreatePipelineCache(device, &createInfo, NULL, &cache) != VK_SUCCESS)
+    {
+        /* the driver rejected the data, start cold */
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData    = NULL;
+        *warm                      = false;
+        if (vkCreatePipelineCache(device, &createInfo, NULL, &cache) != VK_SUCCESS)
+        {
+            fprintf(stderr, "pipeline cache create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(file);
+    return cache;
+}
+
+bool pipeline_cache_save(VkDevice                          device,
+                         const VkPhysicalDeviceProperties* properties,
+                         VkPipelineCache                   cache,
+                         const char*                       path)
+{
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, cache, &dataSize, NULL) != VK_SUCCESS)
+        return false;
+
+    struct PipelineCacheHeader header = {};
+    header.magic                      = PIPELINE_CACHE_MAGIC;
+    header.version                    = PIPELINE_CACHE_VERSION;
+    header.vendorID                   = properties->vendorID;
+    header.deviceID                   = properties->deviceID;
+    memcpy(header.pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE);
+
+    char* data = malloc(sizeof(header) + dataSize);
+    if (data == NULL)
+    {
+        fprintf(stderr, "pipeline cache save: out of memory, skipping %s\n", path);
+        return false;
+    }
+    if (vkGetPipelineCacheData(device, cache, &dataSize, data + sizeof(header)) != VK_SUCCESS)
+    {
+        free(data);
+        return false;
+    }
+    header.dataSize = dataSize;
+    memcpy(data, &header, sizeof(header));
+
+    /* write next to the target and rename, so a crash never leaves half a cache */
+    size_t pathLength = strlen(path);
+    char   pathTemp[pathLength + 5];
+    snprintf(pathTemp, sizeof(pathTemp), "%s.tmp", path);
+
+    bool  written = false;
+    FILE* f       = fopen(pathTemp, "wb");
+    if (f != NULL)
+    {
+        written = fwrite(data, 1, sizeof(header) + dataSize, f) == sizeof(header) + dataSize;
+        written = (fclose(f) == 0) && written;
+    }
+#ifdef _WIN32
+    /* rename does not replace on windows */
+    if (written)
+        remove(path);
+#endif
+    written = written && rename(pathTemp, path) == 0;
+    if (!written)
+        remove(pathTemp);
+
+    free(data);
+    return written;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+/* on-disk VkPipelineCache, keyed by vendorID, deviceID and pipelineCacheUUID.
+ * a missing, foreign or corrupt file yields an empty (cold) cache. */
+VkPipelineCache pipeline_cache_load(VkDevice                          device,
+                                    const VkPhysicalDeviceProperties* properties,
+                                    const char*                       path,
+                                    bool*                             warm);
+
+/* writes the cache back to path, returns false on failure */
+bool pipeline_cache_save(VkDevice                          device,
+                         const VkPhysicalDeviceProperties* properties,
+                         VkPipelineCache                   cache,
+                         const char*                       path);
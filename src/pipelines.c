@@ -0,0 +1,130 @@
+#include "pipelines.h"
+
+#include "profiler.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void pipelines_compile(struct Pipelines* pipelines, struct PipelineEntry* entry)
+{
+    PROFILE_SCOPE("pipeline compile");
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(
+            pipelines->device, pipelines->cache, 1, &entry->info, NULL, &pipeline) != VK_SUCCESS)
+    {
+        fprintf(stderr, "pipeline create error, its draws keep the fallback\n");
+        atomic_store_explicit(&entry->state, PIPELINE_FAILED, memory_order_release);
+        return;
+    }
+    entry->pipeline  = pipeline;
+    entry->readyTime = util_time_ns();
+    /* publishes pipeline to pipelines_get */
+    atomic_store_explicit(&entry->state, PIPELINE_READY, memory_order_release);
+}
+
+static void* pipelines_worker(void* argument)
+{
+    struct Pipelines* pipelines = argument;
+    PROFILE_THREAD("pipeline worker");
+
+    pthread_mutex_lock(&pipelines->mutex);
+    for (;;)
+    {
+        while (!pipelines->quit && pipelines->queueCount == 0)
+            pthread_cond_wait(&pipelines->wake, &pipelines->mutex);
+        if (pipelines->quit)
+            break;
+
+        uint32_t index        = pipelines->queue[pipelines->queueFirst];
+        pipelines->queueFirst = (pipelines->queueFirst + 1) % pipelines->capacity;
+        pipelines->queueCount--;
+
+        pthread_mutex_unlock(&pipelines->mutex);
+        pipelines_compile(pipelines, &pipelines->entries[index]);
+        pthread_mutex_lock(&pipelines->mutex);
+
+        atomic_fetch_sub(&pipelines->backlog, 1);
+    }
+    pthread_mutex_unlock(&pipelines->mutex);
+    return NULL;
+}
+
+void pipelines_init(struct Pipelines* pipelines,
+                    VkDevice          device,
+                    VkPipelineCache   cache,
+                    uint32_t          threadsCount,
+                    uint32_t          capacity)
+{
+    *pipelines              = (struct Pipelines){};
+    pipelines->device       = device;
+    pipelines->cache        = cache;
+    pipelines->capacity     = capacity;
+    pipelines->workersCount = threadsCount > 0 ? threadsCount : 1;
+    pipelines->workers      = calloc(pipelines->workersCount, sizeof(pipelines->workers[0]));
+    pipelines->entries      = calloc(capacity, sizeof(pipelines->entries[0]));
+    pipelines->queue        = calloc(capacity, sizeof(pipelines->queue[0]));
+    if (pipelines->workers == NULL || pipelines->entries == NULL || pipelines->queue == NULL)
+    {
+        fprintf(stderr, "pipelines alloc error\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&pipelines->backlog, 0);
+    pthread_mutex_init(&pipelines->mutex, NULL);
+    pthread_cond_init(&pipelines->wake, NULL);
+
+    for (uint32_t i = 0; i < pipelines->workersCount; ++i)
+    {
+        if (pthread_create(&pipelines->workers[i], NULL, pipelines_worker, pipelines) != 0)
+        {
+            fprintf(stderr, "pipelines worker create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void pipelines_destroy(struct Pipelines* pipelines)
+{
+    pthread_mutex_lock(&pipelines->mutex);
+    pipelines->quit = true;
+    pthread_cond_broadcast(&pipelines->wake);
+    pthread_mutex_unlock(&pipelines->mutex);
+    for (uint32_t i = 0; i < pipelines->workersCount; ++i)
+        pthread_join(pipelines->workers[i], NULL);
+
+    for (uint32_t i = 0; i < pipelines->entriesCount; ++i)
+        if (atomic_load(&pipelines->entries[i].state) == PIPELINE_READY)
+            vkDestroyPipeline(pipelines->device, pipelines->entries[i].pipeline, NULL);
+
+    pthread_cond_destroy(&pipelines->wake);
+    pthread_mutex_destroy(&pipelines->mutex);
+    free(pipelines->queue);
+    free(pipelines->entries);
+    free(pipelines->workers);
+    *pipelines = (struct Pipelines){};
+}
+
+uint32_t pipelines_request(struct Pipelines* pipelines, const VkGraphicsPipelineCreateInfo* info)
+{
+    pthread_mutex_lock(&pipelines->mutex);
+    if (pipelines->entriesCount == pipelines->capacity)
+    {
+        pthread_mutex_unlock(&pipelines->mutex);
+        return PIPELINES_INVALID;
+    }
+
+    uint32_t              handle = pipelines->entriesCount++;
+    struct PipelineEntry* entry  = &pipelines->entries[handle];
+    entry->info                  = *info;
+    entry->requestTime           = util_time_ns();
+    atomic_init(&entry->state, PIPELINE_PENDING);
+
+    /* every entry is queued once, so the ring never overflows */
+    pipelines->queue[(pipelines->queueFirst + pipelines->queueCount) % pipelines->capacity] =
+        handle;
+    pipelines->queueCount++;
+    atomic_fetch_add(&pipelines->backlog, 1);
+    pthread_cond_signal(&pipelines->wake);
+    pthread_mutex_unlock(&pipelines->mutex);
+    return handle;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define PIPELINES_INVALID UINT32_MAX /* pipelines_request when full */
+/* clang-format on */
+
+enum PipelineState
+{
+    PIPELINE_PENDING = 0,
+    PIPELINE_READY,
+    PIPELINE_FAILED,
+};
+
+struct PipelineEntry
+{
+    VkGraphicsPipelineCreateInfo info;     /* pointers stay the caller's */
+    VkPipeline                   pipeline; /* valid once state is READY */
+    atomic_int                   state;
+    uint64_t                     requestTime;
+    uint64_t                     readyTime;
+};
+
+/* compiles graphics pipelines on its own worker threads, so startup and a
+ * new material never wait for vkCreateGraphicsPipelines. requests return a
+ * handle at once, the render thread looks the pipeline up every frame with
+ * pipelines_get and draws with a fallback until it is ready. all workers
+ * share one VkPipelineCache, which is internally synchronized. */
+struct Pipelines
+{
+    VkDevice        device;
+    VkPipelineCache cache;
+    pthread_t*      workers;
+    uint32_t        workersCount;
+
+    struct PipelineEntry* entries; /* capacity, never moves */
+    uint32_t              capacity;
+    atomic_uint           backlog; /* requested, not compiled yet */
+
+    /* guarded by mutex */
+    pthread_mutex_t mutex;
+    pthread_cond_t  wake;
+    uint32_t*       queue; /* ring of pending entries, oldest first */
+    uint32_t        queueFirst;
+    uint32_t        queueCount;
+    uint32_t        entriesCount;
+    bool            quit;
+};
+
+void pipelines_init(struct Pipelines* pipelines,
+                    VkDevice          device,
+                    VkPipelineCache   cache,
+                    uint32_t          threadsCount,
+                    uint32_t          capacity);
+
+/* joins the workers, pending requests are dropped. destroys every pipeline
+ * built, the device must be idle */
+void pipelines_destroy(struct Pipelines* pipelines);
+
+/* queues info for compilation, everything it points to must stay valid
+ * until the pipeline is ready. thread safe */
+uint32_t pipelines_request(struct Pipelines* pipelines, const VkGraphicsPipelineCreateInfo* info);
+
+/* the pipeline of handle, VK_NULL_HANDLE while pending or if it failed */
+static inline VkPipeline pipelines_get(struct Pipelines* pipelines, uint32_t handle)
+{
+    struct PipelineEntry* entry = &pipelines->entries[handle];
+    if (atomic_load_explicit(&entry->state, memory_order_acquire) != PIPELINE_READY)
+        return VK_NULL_HANDLE;
+    return entry->pipeline;
+}
+
+/* number of requests not compiled yet. once it reads 0, pipelines_get
+ * sees every pipeline */
+static inline uint32_t pipelines_backlog(struct Pipelines* pipelines)
+{
+    return atomic_load_explicit(&pipelines->backlog, memory_order_acquire);
+}
@@ -0,0 +1,259 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include "util.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ProfilerEvent
+{
+    const char* name;
+    uint64_t    start; /* util_time_ns */
+    uint64_t    end;
+};
+
+/* single producer ring: only the owning thread writes events and head */
+struct ProfilerThread
+{
+    struct ProfilerEvent events[PROFILER_RING_EVENTS];
+    _Atomic uint64_t     head; /* events ever written, published with release */
+    const char* _Atomic  name;
+};
+
+static struct ProfilerThread* _Atomic profilerThreads[PROFILER_THREADS_MAX];
+static atomic_uint                    profilerThreadsCount;
+
+static _Thread_local struct ProfilerThread* profilerThread;
+static _Thread_local bool                   profilerThreadDropped;
+
+/* the calling thread's ring, registered on first use. NULL once
+ * PROFILER_THREADS_MAX threads have one */
+static struct ProfilerThread* profiler_thread(void)
+{
+    if (profilerThread != NULL || profilerThreadDropped)
+        return profilerThread;
+
+    uint32_t index = atomic_fetch_add(&profilerThreadsCount, 1);
+    if (index >= PROFILER_THREADS_MAX)
+    {
+        profilerThreadDropped = true;
+        return NULL;
+    }
+
+    struct ProfilerThread* thread = calloc(1, sizeof(*thread));
+    if (thread == NULL)
+    {
+        fprintf(stderr, "profiler thread alloc error\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_store_explicit(&profilerThreads[index], thread, memory_order_release);
+    profilerThread = thread;
+    return thread;
+}
+
+struct ProfilerMarker profiler_begin(const char* name)
+{
+    return (struct ProfilerMarker){name, util_time_ns()};
+}
+
+void profiler_end(struct ProfilerMarker* marker)
+{
+    uint64_t               end    = util_time_ns();
+    struct ProfilerThread* thread = profiler_thread();
+    if (thread == NULL)
+        return;
+
+    uint64_t              head  = atomic_load_explicit(&thread->head, memory_order_relaxed);
+    struct ProfilerEvent* event = &thread->events[head & (PROFILER_RING_EVENTS - 1)];
+    event->name                 = marker->name;
+    event->start                = marker->start;
+    event->end                  = end;
+    atomic_store_explicit(&thread->head, head + 1, memory_order_release);
+}
+
+void profiler_thread_name(const char* name)
+{
+    struct ProfilerThread* thread = profiler_thread();
+    if (thread != NULL)
+        atomic_store_explicit(&thread->name, name, memory_order_relaxed);
+}
+
+/* copies the events of thread that survive the copy: the owner may keep
+ * writing, events it may have overwritten meanwhile are dropped */
+static uint32_t profiler_snapshot(struct ProfilerThread* thread, struct ProfilerEvent* events)
+{
+    uint64_t head  = atomic_load_explicit(&thread->head, memory_order_acquire);
+    uint64_t first = head > PROFILER_RING_EVENTS ? head - PROFILER_RING_EVENTS : 0;
+    for (uint64_t i = first; i < head; ++i)
+        events[i - first] = thread->events[i & (PROFILER_RING_EVENTS - 1)];
+
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t headAfter = atomic_load_explicit(&thread->head, memory_order_relaxed);
+    /* slot of event headAfter may be half written as well */
+    uint64_t valid =
+        headAfter + 1 > PROFILER_RING_EVENTS ? headAfter + 1 - PROFILER_RING_EVENTS : 0;
+    if (valid <= first)
+        return (uint32_t) (head - first);
+    if (valid >= head)
+        return 0;
+
+    memmove(events, &events[valid - first], (head - valid) * sizeof(events[0]));
+    return (uint32_t) (head - valid);
+}
+
+static uint32_t profiler_threads_count(void)
+{
+    uint32_t count = atomic_load(&profilerThreadsCount);
+    return count < PROFILER_THREADS_MAX ? count : PROFILER_THREADS_MAX;
+}
+
+/* snapshot of every thread: events[thread * PROFILER_RING_EVENTS + i] for
+ * i < counts[thread]. NULL entries in threads are not registered yet */
+static struct ProfilerEvent* profiler_snapshot_all(struct ProfilerThread** threads,
+                                                   uint32_t*               counts,
+                                                   uint32_t                threadsCount)
+{
+    struct ProfilerEvent* events =
+        malloc((size_t) threadsCount * PROFILER_RING_EVENTS * sizeof(events[0]));
+    if (events == NULL && threadsCount > 0)
+    {
+        fprintf(stderr, "profiler snapshot alloc error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t t = 0; t < threadsCount; ++t)
+    {
+        threads[t] = atomic_load_explicit(&profilerThreads[t], memory_order_acquire);
+        counts[t]  = threads[t] == NULL
+                         ? 0
+                         : profiler_snapshot(threads[t], &events[t * PROFILER_RING_EVENTS]);
+    }
+    return events;
+}
+
+void profiler_summary_print(void)
+{
+    uint32_t               threadsCount = profiler_threads_count();
+    struct ProfilerThread* threads[PROFILER_THREADS_MAX];
+    uint32_t               counts[PROFILER_THREADS_MAX];
+    struct ProfilerEvent*  events = profiler_snapshot_all(threads, counts, threadsCount);
+
+    const char* names[PROFILER_NAMES_MAX];
+    uint32_t    namesCount = 0;
+    size_t      eventsMax  = 0;
+    for (uint32_t t = 0; t < threadsCount; ++t)
+    {
+        eventsMax += counts[t];
+        for (uint32_t i = 0; i < counts[t]; ++i)
+        {
+            const char* name  = events[t * PROFILER_RING_EVENTS + i].name;
+            bool        known = false;
+            for (uint32_t n = 0; n < namesCount && !known; ++n)
+                known = strcmp(names[n], name) == 0;
+            if (!known && namesCount < PROFILER_NAMES_MAX)
+                names[namesCount++] = name;
+        }
+    }
+
+    printf("cpu %-20s %8s %10s %10s %10s\n", "phase", "count", "min ms", "avg ms", "p99 ms");
+    double* durations = malloc((eventsMax + 1) * sizeof(durations[0]));
+    for (uint32_t n = 0; n < namesCount; ++n)
+    {
+        size_t count = 0;
+        double total = 0.0;
+        double min   = 0.0;
+        for (uint32_t t = 0; t < threadsCount; ++t)
+        {
+            for (uint32_t i = 0; i < counts[t]; ++i)
+            {
+                const struct ProfilerEvent* event = &events[t * PROFILER_RING_EVENTS + i];
+                if (strcmp(event->name, names[n]) != 0)
+                    continue;
+
+                double ms          = (double) (event->end - event->start) / 1e6;
+                min                = count == 0 || ms < min ? ms : min;
+                total              = total + ms;
+                durations[count++] = ms;
+            }
+        }
+        printf("    %-20s %8zu %10.3f %10.3f %10.3f\n",
+               names[n],
+               count,
+               min,
+               total / (double) count,
+               util_percentile(durations, count, 0.99));
+    }
+    free(durations);
+    free(events);
+}
+
+bool profiler_trace_write(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+        return false;
+
+    uint32_t               threadsCount = profiler_threads_count();
+    struct ProfilerThread* threads[PROFILER_THREADS_MAX];
+    uint32_t               counts[PROFILER_THREADS_MAX];
+    struct ProfilerEvent*  events = profiler_snapshot_all(threads, counts, threadsCount);
+
+    uint64_t origin = UINT64_MAX;
+    for (uint32_t t = 0; t < threadsCount; ++t)
+        for (uint32_t i = 0; i < counts[t]; ++i)
+            if (events[t * PROFILER_RING_EVENTS + i].start < origin)
+                origin = events[t * PROFILER_RING_EVENTS + i].start;
+
+    /* pid 1, the gpu_timer trace uses pid 0 */
+    fprintf(file, "[");
+    bool first = true;
+    for (uint32_t t = 0; t < threadsCount; ++t)
+    {
+        if (threads[t] == NULL)
+            continue;
+
+        const char* name = atomic_load_explicit(&threads[t]->name, memory_order_relaxed);
+        fprintf(file,
+                "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",",
+                t,
+                name != NULL ? name : "thread");
+        first = false;
+
+        for (uint32_t i = 0; i < counts[t]; ++i)
+        {
+            const struct ProfilerEvent* event = &events[t * PROFILER_RING_EVENTS + i];
+            fprintf(file,
+                    ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f}",
+                    event->name,
+                    t,
+                    (double) (event->start - origin) / 1e3,
+                    (double) (event->end - event->start) / 1e3);
+        }
+    }
+    fprintf(file, "\n]\n");
+    free(events);
+
+    return fclose(file) == 0;
+}
+
+void profiler_shutdown(void)
+{
+    uint32_t threadsCount = profiler_threads_count();
+    for (uint32_t t = 0; t < threadsCount; ++t)
+    {
+        free(atomic_load(&profilerThreads[t]));
+        atomic_store(&profilerThreads[t], NULL);
+    }
+    atomic_store(&profilerThreadsCount, 0);
+    profilerThread        = NULL;
+    profilerThreadDropped = false;
+}
+
+#endif
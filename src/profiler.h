@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* CPU profiler: scoped markers write {name, start, end} into a ring per
+ * thread. only the owning thread writes its ring, readers never block it.
+ * built with PROFILER_ENABLED=0 (cmake -DTJTECH1_PROFILER=OFF) every
+ * PROFILE_* macro expands to nothing. */
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+/* clang-format off */
+#define PROFILER_RING_EVENTS 16384 /* per thread, power of two, oldest overwritten */
+#define PROFILER_THREADS_MAX 64
+#define PROFILER_NAMES_MAX   64    /* distinct marker names summarized */
+/* clang-format on */
+
+struct ProfilerMarker
+{
+    const char* name;
+    uint64_t    start;
+};
+
+#if PROFILER_ENABLED
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b)  PROFILER_CONCAT_(a, b)
+
+/* times the rest of the enclosing block */
+#define PROFILE_SCOPE(name)                                                                        \
+    struct ProfilerMarker PROFILER_CONCAT(profilerScope, __LINE__)                                 \
+        __attribute__((cleanup(profiler_end))) = profiler_begin(name)
+
+/* times from PROFILE_BEGIN to PROFILE_END(marker) in the same block */
+#define PROFILE_BEGIN(marker, name) struct ProfilerMarker marker = profiler_begin(name)
+#define PROFILE_END(marker)         profiler_end(&(marker))
+
+/* names the calling thread in summaries and traces */
+#define PROFILE_THREAD(name) profiler_thread_name(name)
+
+/* name must be a string with static storage, it is stored as a pointer */
+struct ProfilerMarker profiler_begin(const char* name);
+
+void profiler_end(struct ProfilerMarker* marker);
+
+void profiler_thread_name(const char* name);
+
+/* min/avg/p99 per marker name over the events still in the rings */
+void profiler_summary_print(void);
+
+/* every event still in the rings as a chrome://tracing / Perfetto JSON
+ * file. false if path can not be written */
+bool profiler_trace_write(const char* path);
+
+/* frees the rings. every profiled thread but the caller must have exited */
+void profiler_shutdown(void);
+
+#else
+
+#define PROFILE_SCOPE(name)         ((void) 0)
+#define PROFILE_BEGIN(marker, name) ((void) 0)
+#define PROFILE_END(marker)         ((void) 0)
+#define PROFILE_THREAD(name)        ((void) 0)
+
+static inline void profiler_summary_print(void) {}
+
+static inline bool profiler_trace_write(const char* path)
+{
+    (void) path;
+    return true;
+}
+
+static inline void profiler_shutdown(void) {}
+
+#endif
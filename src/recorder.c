@@ -0,0 +1,314 @@
+#include "recorder.h"
+
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void recorder_init(struct Recorder* recorder,
+                   VkDevice         device,
+                   uint32_t         queueFamilyIndex,
+                   uint32_t         slotsCount,
+                   uint32_t         threadsCount)
+{
+    recorder->device       = device;
+    recorder->slotsCount   = slotsCount;
+    recorder->threadsCount = threadsCount;
+
+    uint32_t count        = slotsCount * threadsCount;
+    recorder->pools       = calloc(count, sizeof(recorder->pools[0]));
+    recorder->secondaries = calloc(count, sizeof(recorder->secondaries[0]));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex        = queueFamilyIndex;
+        poolInfo.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (vkCreateCommandPool(device, &poolInfo, NULL, &recorder->pools[i]) != VK_SUCCESS)
+        {
+            fprintf(stderr, "recorder commandPool create error\n");
+            exit(EXIT_FAILURE);
+        }
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool                 = recorder->pools[i];
+        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount          = 1;
+
+        if (vkAllocateCommandBuffers(device, &allocInfo, &recorder->secondaries[i]) != VK_SUCCESS)
+        {
+            fprintf(stderr, "recorder commandBuffer allocate error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void recorder_destroy(struct Recorder* recorder)
+{
+    for (uint32_t i = 0; i < recorder->slotsCount * recorder->threadsCount; ++i)
+        vkDestroyCommandPool(recorder->device, recorder->pools[i], NULL);
+
+    free(recorder->pools);
+    free(recorder->secondaries);
+    *recorder = (struct Recorder){};
+}
+
+static void recorder_constants_push(VkCommandBuffer                 commandBuffer,
+                                    const struct RecordPass*        pass,
+                                    const struct BindlessConstants* constants)
+{
+    if (pass->layout == VK_NULL_HANDLE)
+        return;
+
+    vkCmdPushConstants(commandBuffer,
+                       pass->layout,
+                       VK_SHADER_STAGE_FRAGMENT_BIT,
+                       RECORDER_CONSTANTS_OFFSET,
+                       sizeof(*constants),
+                       constants);
+}
+
+static void recorder_payload_push(VkCommandBuffer           commandBuffer,
+                                  const struct RecordPass*  pass,
+                                  const struct DrawPayload* payload)
+{
+    if (pass->layout == VK_NULL_HANDLE)
+        return;
+
+    vkCmdPushConstants(
+        commandBuffer, pass->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(*payload), payload);
+}
+
+static void recorder_uniforms_bind(VkCommandBuffer          commandBuffer,
+                                   const struct RecordPass* pass,
+                                   uint32_t                 offset)
+{
+    vkCmdBindDescriptorSets(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pass->layout,
+                            1,
+                            1,
+                            &pass->uniformSet,
+                            1,
+                            &offset);
+}
+
+/* the bindless set, the frame's uniforms, and the constants and payload
+ * every draw starts from */
+static void recorder_sets_bind(VkCommandBuffer commandBuffer, const struct RecordPass* pass)
+{
+    if (pass->bindlessSet != VK_NULL_HANDLE)
+        vkCmdBindDescriptorSets(commandBuffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pass->layout,
+                                0,
+                                1,
+                                &pass->bindlessSet,
+                                0,
+                                NULL);
+    if (pass->uniformSet != VK_NULL_HANDLE)
+        recorder_uniforms_bind(commandBuffer, pass, pass->uniformOffset);
+
+    struct BindlessConstants constants = {};
+    recorder_constants_push(commandBuffer, pass, &constants);
+    recorder_payload_push(commandBuffer, pass, &pass->payload);
+}
+
+/* draws [first, first + count) of the draw list, pipelines, dynamic state
+ * and buffers are set here */
+static void recorder_draws(VkCommandBuffer          commandBuffer,
+                           const struct RecordPass* pass,
+                           uint32_t                 first,
+                           uint32_t                 count)
+{
+    /* dynamic state, secondaries do not inherit it */
+    VkViewport viewport = {};
+    viewport.x          = 0.0f;
+    viewport.y          = 0.0f;
+    viewport.width      = (float) pass->extent.width;
+    viewport.height     = (float) pass->extent.height;
+    viewport.minDepth   = 0.0f;
+    viewport.maxDepth   = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor = {};
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent   = pass->extent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    mesh_bind(commandBuffer, pass->meshBuffers, pass->instanceBuffer);
+    recorder_sets_bind(commandBuffer, pass);
+
+    /* rebound only when it changes, all pipelines share the dynamic state
+     * and the layout, so the sets and push constants stay */
+    VkPipeline                bound         = VK_NULL_HANDLE;
+    struct BindlessConstants  pushed        = {};
+    const struct DrawPayload* pushedPayload = &pass->payload;
+    uint32_t                  boundOffset   = pass->uniformOffset;
+
+    bool uniformOffsets = pass->uniformOffsets != NULL && pass->uniformSet != VK_NULL_HANDLE;
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        const struct Draw* draw     = &pass->draws[i];
+        VkPipeline         pipeline = draw->pipeline;
+        if (pipeline == VK_NULL_HANDLE)
+            pipeline = pass->pipeline;
+        if (pipeline == VK_NULL_HANDLE)
+            continue;
+        if (pipeline != bound)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            bound = pipeline;
+        }
+        if (draw->constants.texture != pushed.texture || draw->constants.buffer != pushed.buffer)
+        {
+            recorder_constants_push(commandBuffer, pass, &draw->constants);
+            pushed = draw->constants;
+        }
+        const struct DrawPayload* payload = draw->payload ? draw->payload : &pass->payload;
+        if (payload != pushedPayload)
+        {
+            recorder_payload_push(commandBuffer, pass, payload);
+            pushedPayload = payload;
+        }
+        if (uniformOffsets && pass->uniformOffsets[i] != boundOffset)
+        {
+            recorder_uniforms_bind(commandBuffer, pass, pass->uniformOffsets[i]);
+            boundOffset = pass->uniformOffsets[i];
+        }
+        mesh_draw(
+            commandBuffer, &pass->meshes[draw->mesh], draw->firstInstance, draw->instancesCount);
+    }
+}
+
+/* the draws of the cull pass, recorded once per pass after the draw list */
+static void recorder_draws_culled(VkCommandBuffer commandBuffer, const struct RecordPass* pass)
+{
+    if (pass->cull == NULL || pass->pipeline == VK_NULL_HANDLE)
+        return;
+
+    /* every culled object draws with the default constants */
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pass->pipeline);
+    recorder_sets_bind(commandBuffer, pass);
+    cull_draw(pass->cull, commandBuffer, pass->cullSlot);
+}
+
+void recorder_begin(VkCommandBuffer                       commandBuffer,
+                    VkCommandBufferUsageFlags             flags,
+                    const VkCommandBufferInheritanceInfo* inheritance)
+{
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = flags;
+    beginInfo.pInheritanceInfo         = inheritance;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        fprintf(stderr, "commandBuffer record start error\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void recorder_end(VkCommandBuffer commandBuffer)
+{
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "commandBuffer record end error\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void recorder_render_pass_begin(VkCommandBuffer          commandBuffer,
+                                       const struct RecordPass* pass,
+                                       VkSubpassContents        contents)
+{
+    VkRenderPassBeginInfo renderPassBeginInfo = {};
+    renderPassBeginInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.renderPass            = pass->renderPass;
+    renderPassBeginInfo.framebuffer           = pass->framebuffer;
+
+    renderPassBeginInfo.renderArea.offset.x = 0;
+    renderPassBeginInfo.renderArea.offset.y = 0;
+    renderPassBeginInfo.renderArea.extent   = pass->extent;
+
+    VkClearValue clearColor             = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+    renderPassBeginInfo.clearValueCount = 1;
+    renderPassBeginInfo.pClearValues    = &clearColor;
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, contents);
+}
+
+void recorder_record_inline(VkCommandBuffer primary, const struct RecordPass* pass)
+{
+    recorder_render_pass_begin(primary, pass, VK_SUBPASS_CONTENTS_INLINE);
+    recorder_draws(primary, pass, 0, pass->drawsCount);
+    recorder_draws_culled(primary, pass);
+    vkCmdEndRenderPass(primary);
+}
+
+struct RecorderJob
+{
+    struct Recorder*         recorder;
+    uint32_t                 slot;
+    uint32_t                 slicesCount;
+    const struct RecordPass* pass;
+};
+
+static void recorder_job(void* context, uint32_t slice)
+{
+    PROFILE_SCOPE("record secondary");
+    struct RecorderJob* job      = context;
+    struct Recorder*    recorder = job->recorder;
+    uint32_t            index    = job->slot * recorder->threadsCount + slice;
+
+    /* the slot's last recording is done with, drop it in one go */
+    vkResetCommandPool(recorder->device, recorder->pools[index], 0);
+
+    VkCommandBufferInheritanceInfo inheritance = {};
+    inheritance.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass  = job->pass->renderPass;
+    inheritance.subpass     = 0;
+    inheritance.framebuffer = job->pass->framebuffer;
+
+    VkCommandBuffer secondary = recorder->secondaries[index];
+    recorder_begin(secondary,
+                   VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                       VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                   &inheritance);
+
+    uint32_t drawsCount = job->pass->drawsCount;
+    uint32_t first      = (uint32_t)((uint64_t) drawsCount * slice / job->slicesCount);
+    uint32_t last       = (uint32_t)((uint64_t) drawsCount * (slice + 1) / job->slicesCount);
+    recorder_draws(secondary, job->pass, first, last - first);
+    if (slice == 0)
+        recorder_draws_culled(secondary, job->pass);
+
+    recorder_end(secondary);
+}
+
+void recorder_record(struct Recorder*         recorder,
+                     struct Jobs*             jobs,
+                     uint32_t                 slot,
+                     uint32_t                 threadsUsed,
+                     VkCommandBuffer          primary,
+                     const struct RecordPass* pass)
+{
+    if (threadsUsed == 0 || threadsUsed > recorder->threadsCount)
+        threadsUsed = recorder->threadsCount;
+
+    struct RecorderJob job = {};
+    job.recorder           = recorder;
+    job.slot               = slot;
+    job.slicesCount        = threadsUsed;
+    job.pass               = pass;
+    jobs_run(jobs, recorder_job, &job, threadsUsed);
+
+    recorder_render_pass_begin(primary, pass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(
+        primary, threadsUsed, &recorder->secondaries[slot * recorder->threadsCount]);
+    vkCmdEndRenderPass(primary);
+}
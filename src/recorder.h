@@ -0,0 +1,114 @@
+#pragma once
+
+#include "bindless.h"
+#include "cull.h"
+#include "jobs.h"
+#include "mesh.h"
+
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define RECORDER_CONSTANTS_OFFSET  sizeof(struct DrawPayload) /* of BindlessConstants */
+#define RECORDER_PUSH_SIZE         (RECORDER_CONSTANTS_OFFSET + sizeof(struct BindlessConstants))
+#define RECORDER_TRANSFORM_PUSH    0 /* shader.vert TRANSFORM_SOURCE: DrawPayload.transform */
+#define RECORDER_TRANSFORM_STORAGE 1 /* the transform buffer, see DrawPayload */
+/* clang-format on */
+
+/* small per draw data pushed to the vertex stage, laid out as the Draw
+ * push constant block of shader.vert */
+struct DrawPayload
+{
+    float    transform[16]; /* column major, before the instance model */
+    uint32_t object;        /* plus gl_InstanceIndex: element of the transform buffer */
+    uint32_t transforms;    /* bindless index of the transform buffer */
+};
+
+/* one vkCmdDrawIndexed of meshes[mesh] */
+struct Draw
+{
+    uint32_t                  mesh;
+    uint32_t                  firstInstance;
+    uint32_t                  instancesCount;
+    VkPipeline                pipeline;  /* VK_NULL_HANDLE: the pass pipeline */
+    struct BindlessConstants  constants; /* pushed when they differ from the last draw's */
+    const struct DrawPayload* payload;   /* NULL: the pass payload, pushed when it changes */
+};
+
+/* a draw with the pass pipeline, the default constants and the pass payload */
+static inline void draw_init(struct Draw* draw,
+                             uint32_t     mesh,
+                             uint32_t     firstInstance,
+                             uint32_t     instancesCount)
+{
+    draw->mesh           = mesh;
+    draw->firstInstance  = firstInstance;
+    draw->instancesCount = instancesCount;
+    draw->pipeline       = VK_NULL_HANDLE;
+    draw->constants      = (struct BindlessConstants){};
+    draw->payload        = NULL;
+}
+
+/* everything needed to record one render pass over a draw list */
+struct RecordPass
+{
+    VkRenderPass              renderPass;
+    VkFramebuffer             framebuffer;
+    VkExtent2D                extent;
+    VkPipeline                pipeline;       /* of draws without one, VK_NULL_HANDLE skips them */
+    VkPipelineLayout          layout;         /* of every pipeline: the sets and push constants */
+    VkDescriptorSet           bindlessSet;    /* set 0, by frame_record, VK_NULL_HANDLE: none */
+    VkDescriptorSet           uniformSet;     /* set 1, by frame_record, VK_NULL_HANDLE: none */
+    uint32_t                  uniformOffset;  /* its dynamic offset, the frame's uniforms */
+    const uint32_t*           uniformOffsets; /* per draw instead, NULL: uniformOffset for all */
+    struct DrawPayload        payload;        /* of draws without one */
+    const struct MeshBuffers* meshBuffers;
+    const struct Mesh*        meshes;
+    VkBuffer                  instanceBuffer;
+    const struct Draw*        draws;
+    uint32_t                  drawsCount;
+    const struct Cull*        cull;     /* drawn after draws with the pass pipeline, NULL: none */
+    uint32_t                  cullSlot; /* its frame slot, by frame_record */
+};
+
+/* records secondary command buffers on worker threads. every thread has
+ * its own TRANSIENT command pool per slot (frame in flight), so pools are
+ * never shared between threads and a slot is reset as a whole with
+ * vkResetCommandPool. all buffers are recorded ONE_TIME_SUBMIT. */
+struct Recorder
+{
+    VkDevice         device;
+    uint32_t         slotsCount;
+    uint32_t         threadsCount;
+    VkCommandPool*   pools;       /* [slot * threadsCount + thread] */
+    VkCommandBuffer* secondaries; /* [slot * threadsCount + thread] */
+};
+
+void recorder_init(struct Recorder* recorder,
+                   VkDevice         device,
+                   uint32_t         queueFamilyIndex,
+                   uint32_t         slotsCount,
+                   uint32_t         threadsCount);
+
+void recorder_destroy(struct Recorder* recorder);
+
+/* vkBeginCommandBuffer / vkEndCommandBuffer, exits on error */
+void recorder_begin(VkCommandBuffer                       commandBuffer,
+                    VkCommandBufferUsageFlags             flags,
+                    const VkCommandBufferInheritanceInfo* inheritance);
+
+void recorder_end(VkCommandBuffer commandBuffer);
+
+/* records pass into primary, which is in the recording state, on the
+ * calling thread only */
+void recorder_record_inline(VkCommandBuffer primary, const struct RecordPass* pass);
+
+/* splits the draw list of pass into threadsUsed slices, records one
+ * secondary per slice on jobs and executes them from primary, which is in
+ * the recording state. the previous recording of slot must no longer be in
+ * use by the device. */
+void recorder_record(struct Recorder*         recorder,
+                     struct Jobs*             jobs,
+                     uint32_t                 slot,
+                     uint32_t                 threadsUsed,
+                     VkCommandBuffer          primary,
+                     const struct RecordPass* pass);
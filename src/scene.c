@@ -0,0 +1,390 @@
+#include "scene.h"
+
+#include "recorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* clang-format off */
+#define SCENE_VALUE_SIZE sizeof(uint32_t) /* of every column value */
+/* clang-format on */
+
+static const uint32_t sceneColumnsCounts[SCENE_COMPONENTS_COUNT] = {10, 6, 6};
+
+/* pools *********************************************************************/
+static void scene_pool_init(struct ScenePool* pool, uint32_t capacity, uint32_t columnsCount)
+{
+    *pool              = (struct ScenePool){};
+    pool->sparse       = malloc(capacity * sizeof(pool->sparse[0]));
+    pool->entities     = malloc(capacity * sizeof(pool->entities[0]));
+    pool->columnsCount = columnsCount;
+    bool allocated     = pool->sparse != NULL && pool->entities != NULL;
+    for (uint32_t i = 0; i < columnsCount; ++i)
+    {
+        pool->columns[i] = malloc(capacity * SCENE_VALUE_SIZE);
+        allocated        = allocated && pool->columns[i] != NULL;
+    }
+    if (!allocated)
+    {
+        fprintf(stderr, "scene pool allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(pool->sparse, 0xff, capacity * sizeof(pool->sparse[0])); /* SCENE_NONE */
+}
+
+static void scene_pool_destroy(struct ScenePool* pool)
+{
+    for (uint32_t i = 0; i < pool->columnsCount; ++i)
+        free(pool->columns[i]);
+    free(pool->entities);
+    free(pool->sparse);
+    *pool = (struct ScenePool){};
+}
+
+/* slot of entity, a new one at the end if it has none */
+static uint32_t scene_pool_add(struct ScenePool* pool, uint32_t entity)
+{
+    uint32_t index = entity & SCENE_INDEX_MASK;
+    uint32_t slot  = pool->sparse[index];
+    if (slot != SCENE_NONE)
+        return slot;
+
+    slot                 = pool->count++;
+    pool->sparse[index]  = slot;
+    pool->entities[slot] = entity;
+    return slot;
+}
+
+static void scene_pool_remove(struct ScenePool* pool, uint32_t index)
+{
+    uint32_t slot = pool->sparse[index];
+    if (slot == SCENE_NONE)
+        return;
+
+    uint32_t last = --pool->count;
+    if (slot != last)
+    {
+        uint32_t moved                         = pool->entities[last];
+        pool->entities[slot]                   = moved;
+        pool->sparse[moved & SCENE_INDEX_MASK] = slot;
+        for (uint32_t i = 0; i < pool->columnsCount; ++i)
+        {
+            char* column = pool->columns[i];
+            memcpy(column + slot * SCENE_VALUE_SIZE,
+                   column + last * SCENE_VALUE_SIZE,
+                   SCENE_VALUE_SIZE);
+        }
+    }
+    pool->sparse[index] = SCENE_NONE;
+}
+
+static void scene_pool_swap(struct ScenePool* pool, uint32_t a, uint32_t b)
+{
+    uint32_t entityA = pool->entities[a];
+    uint32_t entityB = pool->entities[b];
+
+    pool->entities[a]                        = entityB;
+    pool->entities[b]                        = entityA;
+    pool->sparse[entityA & SCENE_INDEX_MASK] = b;
+    pool->sparse[entityB & SCENE_INDEX_MASK] = a;
+    for (uint32_t i = 0; i < pool->columnsCount; ++i)
+    {
+        char*    column = pool->columns[i];
+        uint32_t value;
+        memcpy(&value, column + a * SCENE_VALUE_SIZE, SCENE_VALUE_SIZE);
+        memcpy(column + a * SCENE_VALUE_SIZE, column + b * SCENE_VALUE_SIZE, SCENE_VALUE_SIZE);
+        memcpy(column + b * SCENE_VALUE_SIZE, &value, SCENE_VALUE_SIZE);
+    }
+}
+
+/* the entities of pool that reference holds first, in its order */
+static void scene_pool_order(struct ScenePool* pool, const struct ScenePool* reference)
+{
+    uint32_t next = 0;
+    for (uint32_t r = 0; r < reference->count && next < pool->count; ++r)
+    {
+        uint32_t slot = pool->sparse[reference->entities[r] & SCENE_INDEX_MASK];
+        if (slot == SCENE_NONE)
+            continue;
+        if (slot != next)
+            scene_pool_swap(pool, slot, next);
+        ++next;
+    }
+}
+
+/* scene *********************************************************************/
+void scene_init(struct Scene* scene, uint32_t capacity)
+{
+    if (capacity > SCENE_ENTITIES_MAX)
+    {
+        fprintf(stderr, "scene capacity exceeds %u entities\n", SCENE_ENTITIES_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    *scene             = (struct Scene){};
+    scene->capacity    = capacity;
+    scene->generations = calloc(capacity, sizeof(scene->generations[0]));
+    scene->freeIndices = malloc(capacity * sizeof(scene->freeIndices[0]));
+    if (scene->generations == NULL || scene->freeIndices == NULL)
+    {
+        fprintf(stderr, "scene allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < SCENE_COMPONENTS_COUNT; ++i)
+        scene_pool_init(&scene->pools[i], capacity, sceneColumnsCounts[i]);
+
+    void** transform = scene->pools[SCENE_TRANSFORM].columns;
+    scene->positions = (struct Vec3Soa){transform[0], transform[1], transform[2]};
+    scene->rotations = (struct QuatSoa){transform[3], transform[4], transform[5], transform[6]};
+    scene->scales    = (struct Vec3Soa){transform[7], transform[8], transform[9]};
+
+    void** motion     = scene->pools[SCENE_MOTION].columns;
+    scene->velocities = (struct Vec3Soa){motion[0], motion[1], motion[2]};
+    scene->spins      = (struct Vec3Soa){motion[3], motion[4], motion[5]};
+
+    void** render = scene->pools[SCENE_RENDER].columns;
+    scene->meshes = render[0];
+    for (uint32_t i = 0; i < 4; ++i)
+        scene->colors[i] = render[1 + i];
+    scene->radii = render[5];
+}
+
+void scene_destroy(struct Scene* scene)
+{
+    for (uint32_t i = 0; i < SCENE_COMPONENTS_COUNT; ++i)
+        scene_pool_destroy(&scene->pools[i]);
+    free(scene->freeIndices);
+    free(scene->generations);
+    *scene = (struct Scene){};
+}
+
+uint32_t scene_entity_create(struct Scene* scene)
+{
+    uint32_t index;
+    if (scene->freeCount > 0)
+        index = scene->freeIndices[--scene->freeCount];
+    else if (scene->indicesCount < scene->capacity)
+        index = scene->indicesCount++;
+    else
+        return SCENE_NONE;
+
+    ++scene->aliveCount;
+    return scene->generations[index] << SCENE_INDEX_BITS | index;
+}
+
+void scene_entity_destroy(struct Scene* scene, uint32_t entity)
+{
+    if (!scene_entity_alive(scene, entity))
+        return;
+
+    uint32_t index = entity & SCENE_INDEX_MASK;
+    for (uint32_t i = 0; i < SCENE_COMPONENTS_COUNT; ++i)
+        scene_pool_remove(&scene->pools[i], index);
+    scene->generations[index] = (scene->generations[index] + 1) & SCENE_GENERATION_MASK;
+
+    scene->freeIndices[scene->freeCount++] = index;
+    --scene->aliveCount;
+}
+
+uint32_t scene_transform_add(struct Scene* scene,
+                             uint32_t      entity,
+                             struct Vec3   position,
+                             struct Quat   rotation,
+                             struct Vec3   scale)
+{
+    if (!scene_entity_alive(scene, entity))
+        return SCENE_NONE;
+
+    uint32_t slot            = scene_pool_add(&scene->pools[SCENE_TRANSFORM], entity);
+    scene->positions.x[slot] = position.x;
+    scene->positions.y[slot] = position.y;
+    scene->positions.z[slot] = position.z;
+    scene->rotations.x[slot] = rotation.x;
+    scene->rotations.y[slot] = rotation.y;
+    scene->rotations.z[slot] = rotation.z;
+    scene->rotations.w[slot] = rotation.w;
+    scene->scales.x[slot]    = scale.x;
+    scene->scales.y[slot]    = scale.y;
+    scene->scales.z[slot]    = scale.z;
+    return slot;
+}
+
+uint32_t scene_motion_add(struct Scene* scene,
+                          uint32_t      entity,
+                          struct Vec3   velocity,
+                          struct Vec3   spin)
+{
+    if (!scene_entity_alive(scene, entity))
+        return SCENE_NONE;
+
+    uint32_t slot             = scene_pool_add(&scene->pools[SCENE_MOTION], entity);
+    scene->velocities.x[slot] = velocity.x;
+    scene->velocities.y[slot] = velocity.y;
+    scene->velocities.z[slot] = velocity.z;
+    scene->spins.x[slot]      = spin.x;
+    scene->spins.y[slot]      = spin.y;
+    scene->spins.z[slot]      = spin.z;
+    return slot;
+}
+
+uint32_t scene_render_add(struct Scene* scene,
+                          uint32_t      entity,
+                          uint32_t      mesh,
+                          const float   color[4],
+                          float         radius)
+{
+    if (!scene_entity_alive(scene, entity))
+        return SCENE_NONE;
+
+    uint32_t slot       = scene_pool_add(&scene->pools[SCENE_RENDER], entity);
+    scene->meshes[slot] = mesh;
+    for (uint32_t i = 0; i < 4; ++i)
+        scene->colors[i][slot] = color[i];
+    scene->radii[slot] = radius;
+    return slot;
+}
+
+void scene_remove(struct Scene* scene, enum SceneComponent component, uint32_t entity)
+{
+    if (scene_entity_alive(scene, entity))
+        scene_pool_remove(&scene->pools[component], entity & SCENE_INDEX_MASK);
+}
+
+void scene_order(struct Scene* scene)
+{
+    const struct ScenePool* transforms = &scene->pools[SCENE_TRANSFORM];
+    scene_pool_order(&scene->pools[SCENE_MOTION], transforms);
+    scene_pool_order(&scene->pools[SCENE_RENDER], transforms);
+}
+
+/* systems *******************************************************************/
+void scene_motion_update(struct Scene* scene, float seconds)
+{
+    const struct ScenePool* motion     = &scene->pools[SCENE_MOTION];
+    const uint32_t*         transforms = scene->pools[SCENE_TRANSFORM].sparse;
+    struct Vec3Soa          positions  = scene->positions;
+    struct QuatSoa          rotations  = scene->rotations;
+    float                   half       = 0.5f * seconds;
+    for (uint32_t i = 0; i < motion->count; ++i)
+    {
+        uint32_t t = transforms[motion->entities[i] & SCENE_INDEX_MASK];
+        if (t == SCENE_NONE)
+            continue;
+
+        positions.x[t] += scene->velocities.x[i] * seconds;
+        positions.y[t] += scene->velocities.y[i] * seconds;
+        positions.z[t] += scene->velocities.z[i] * seconds;
+
+        /* q += seconds / 2 * (spin, 0) * q, renormalized */
+        float       wx = scene->spins.x[i] * half;
+        float       wy = scene->spins.y[i] * half;
+        float       wz = scene->spins.z[i] * half;
+        struct Quat q  = {rotations.x[t], rotations.y[t], rotations.z[t], rotations.w[t]};
+        struct Quat d  = quat_mul((struct Quat){wx, wy, wz, 0.0f}, q);
+
+        q = quat_normalize((struct Quat){q.x + d.x, q.y + d.y, q.z + d.z, q.w + d.w});
+
+        rotations.x[t] = q.x;
+        rotations.y[t] = q.y;
+        rotations.z[t] = q.z;
+        rotations.w[t] = q.w;
+    }
+}
+
+uint32_t scene_instances_write(const struct Scene* scene, struct Instance* instances)
+{
+    const struct ScenePool* transforms = &scene->pools[SCENE_TRANSFORM];
+    const struct ScenePool* render     = &scene->pools[SCENE_RENDER];
+    if (transforms->count == 0)
+        return 0;
+
+    vecmath_trs_batch(&scene->positions,
+                      &scene->rotations,
+                      &scene->scales,
+                      instances[0].model,
+                      sizeof(instances[0]),
+                      transforms->count);
+    for (uint32_t i = 0; i < render->count; ++i)
+    {
+        uint32_t t = transforms->sparse[render->entities[i] & SCENE_INDEX_MASK];
+        if (t == SCENE_NONE)
+            continue;
+        for (uint32_t c = 0; c < 4; ++c)
+            instances[t].color[c] = scene->colors[c][i];
+    }
+    return transforms->count;
+}
+
+uint32_t scene_draws_build(const struct Scene* scene, struct Draw* draws)
+{
+    const struct ScenePool* render     = &scene->pools[SCENE_RENDER];
+    const uint32_t*         transforms = scene->pools[SCENE_TRANSFORM].sparse;
+    uint32_t                drawsCount = 0;
+    for (uint32_t i = 0; i < render->count; ++i)
+    {
+        uint32_t t = transforms[render->entities[i] & SCENE_INDEX_MASK];
+        if (t == SCENE_NONE)
+            continue;
+
+        struct Draw* last = drawsCount > 0 ? &draws[drawsCount - 1] : NULL;
+        if (last != NULL && last->mesh == scene->meshes[i] &&
+            last->firstInstance + last->instancesCount == t)
+        {
+            ++last->instancesCount;
+            continue;
+        }
+
+        draw_init(&draws[drawsCount++], scene->meshes[i], t, 1);
+    }
+    return drawsCount;
+}
+
+/* frames ********************************************************************/
+void scene_frames_init(struct SceneFrames* frames,
+                       struct Allocator*   allocator,
+                       uint32_t            capacity,
+                       uint32_t            slotsCount)
+{
+    if (capacity == 0 || slotsCount == 0 || slotsCount > SCENE_FRAMES_MAX)
+    {
+        fprintf(stderr, "scene frames need 1 to %u slots and a capacity\n", SCENE_FRAMES_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    *frames            = (struct SceneFrames){};
+    frames->slotsCount = slotsCount;
+    frames->capacity   = capacity;
+    frames->draws      = malloc(capacity * sizeof(frames->draws[0]));
+    if (frames->draws == NULL)
+    {
+        fprintf(stderr, "scene allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < slotsCount; ++i)
+        buffer_create(allocator,
+                      (VkDeviceSize) capacity * sizeof(struct Instance),
+                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                      &frames->buffers[i]);
+}
+
+void scene_frames_destroy(struct SceneFrames* frames, struct Allocator* allocator)
+{
+    for (uint32_t i = 0; i < frames->slotsCount; ++i)
+        buffer_destroy(allocator, &frames->buffers[i]);
+    free(frames->draws);
+    *frames = (struct SceneFrames){};
+}
+
+void scene_frame_write(struct SceneFrames* frames, const struct Scene* scene, uint32_t slot)
+{
+    if (scene->pools[SCENE_TRANSFORM].count > frames->capacity || slot >= frames->slotsCount)
+    {
+        fprintf(stderr, "scene does not fit its frame buffers\n");
+        exit(EXIT_FAILURE);
+    }
+
+    scene_instances_write(scene, frames->buffers[slot].allocation.mapped);
+    frames->drawsCount = scene_draws_build(scene, frames->draws);
+}
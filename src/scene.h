@@ -0,0 +1,174 @@
+#pragma once
+
+#include "allocator.h"
+#include "buffer.h"
+#include "mesh.h"
+#include "vecmath.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* clang-format off */
+#define SCENE_INDEX_BITS      22
+#define SCENE_ENTITIES_MAX    ((1u << SCENE_INDEX_BITS) - 1) /* capacity, at most */
+#define SCENE_INDEX_MASK      ((1u << SCENE_INDEX_BITS) - 1)
+#define SCENE_GENERATION_MASK ((1u << (32 - SCENE_INDEX_BITS)) - 1)
+#define SCENE_NONE            UINT32_MAX /* no entity, no slot */
+#define SCENE_COLUMNS_MAX     10         /* 32 bit values per component */
+#define SCENE_FRAMES_MAX      4          /* frame slots of SceneFrames */
+/* clang-format on */
+
+struct Draw;
+
+enum SceneComponent
+{
+    SCENE_TRANSFORM, /* position, rotation, scale */
+    SCENE_MOTION,    /* velocity, spin (angular velocity, radians per second) */
+    SCENE_RENDER,    /* mesh, color, bounding radius */
+    SCENE_COMPONENTS_COUNT
+};
+
+/* the entities holding one component, as a sparse set: entities[slot] is
+ * the entity in a slot, sparse[index] the slot of an entity index or
+ * SCENE_NONE. the component is one column of 32 bit values per field,
+ * indexed by slot. a removal moves the last slot into the hole, so slots
+ * 0 to count - 1 stay packed */
+struct ScenePool
+{
+    uint32_t* sparse;
+    uint32_t* entities;
+    uint32_t  count;
+    uint32_t  columnsCount;
+    void*     columns[SCENE_COLUMNS_MAX];
+};
+
+/* entities and their components, stored structure of arrays so systems
+ * walk dense columns instead of following pointers per entity. an entity
+ * is a handle: its index in the low SCENE_INDEX_BITS, the generation of
+ * the index above them. the generation is bumped when the entity is
+ * destroyed, so stale handles stop resolving until it wraps around after
+ * SCENE_GENERATION_MASK + 1 reuses. freed indices are reused first. the
+ * views below alias the pool columns: field f of the component in slot s
+ * is view.f[s]. capacity is fixed at scene_init. not thread safe */
+struct Scene
+{
+    uint32_t  capacity;
+    uint32_t* generations;  /* per index */
+    uint32_t* freeIndices;  /* destroyed, reused last in first out */
+    uint32_t  freeCount;
+    uint32_t  indicesCount; /* handed out so far, free ones included */
+    uint32_t  aliveCount;
+
+    struct ScenePool pools[SCENE_COMPONENTS_COUNT];
+
+    /* SCENE_TRANSFORM */
+    struct Vec3Soa positions;
+    struct QuatSoa rotations;
+    struct Vec3Soa scales;
+
+    /* SCENE_MOTION */
+    struct Vec3Soa velocities;
+    struct Vec3Soa spins;
+
+    /* SCENE_RENDER */
+    uint32_t* meshes;
+    float*    colors[4];
+    float*    radii;
+};
+
+/* room for capacity entities, at most SCENE_ENTITIES_MAX, exits on failure */
+void scene_init(struct Scene* scene, uint32_t capacity);
+
+void scene_destroy(struct Scene* scene);
+
+/* a new entity without components, SCENE_NONE if the scene is full */
+uint32_t scene_entity_create(struct Scene* scene);
+
+/* removes every component of entity, stale handles are ignored */
+void scene_entity_destroy(struct Scene* scene, uint32_t entity);
+
+static inline bool scene_entity_alive(const struct Scene* scene, uint32_t entity)
+{
+    uint32_t index = entity & SCENE_INDEX_MASK;
+    return entity != SCENE_NONE && index < scene->indicesCount &&
+           scene->generations[index] == entity >> SCENE_INDEX_BITS;
+}
+
+/* slot of the component of entity, SCENE_NONE if it has none or is stale.
+ * a slot is valid until a component of that kind is removed or the pools
+ * are reordered */
+static inline uint32_t scene_slot(const struct Scene* scene,
+                                  enum SceneComponent component,
+                                  uint32_t            entity)
+{
+    if (!scene_entity_alive(scene, entity))
+        return SCENE_NONE;
+    return scene->pools[component].sparse[entity & SCENE_INDEX_MASK];
+}
+
+/* the add functions set the component of entity, replacing its values if
+ * it already has one. they return its slot, SCENE_NONE for a stale entity */
+uint32_t scene_transform_add(struct Scene* scene,
+                             uint32_t      entity,
+                             struct Vec3   position,
+                             struct Quat   rotation,
+                             struct Vec3   scale);
+
+uint32_t scene_motion_add(struct Scene* scene,
+                          uint32_t      entity,
+                          struct Vec3   velocity,
+                          struct Vec3   spin);
+
+uint32_t scene_render_add(struct Scene* scene,
+                          uint32_t      entity,
+                          uint32_t      mesh,
+                          const float   color[4],
+                          float         radius);
+
+void scene_remove(struct Scene* scene, enum SceneComponent component, uint32_t entity);
+
+/* moves the motion and render slots into the order of the transform
+ * slots, so the systems below walk the transform columns front to back
+ * instead of jumping around. slots change: call after creating or
+ * destroying many entities, not per frame */
+void scene_order(struct Scene* scene);
+
+/* moves and spins every entity with motion and a transform */
+void scene_motion_update(struct Scene* scene, float seconds);
+
+/* writes the world matrix of transform slot i into instances[i].model and
+ * the color of its render component, if it has one, into
+ * instances[i].color. instances may be a mapped buffer and needs room for
+ * every transform. returns the number of instances written */
+uint32_t scene_instances_write(const struct Scene* scene, struct Instance* instances);
+
+/* a draw per run of render components with the same mesh and consecutive
+ * transform slots, drawing the instances of scene_instances_write. draws
+ * needs room for one per render component. returns their count */
+uint32_t scene_draws_build(const struct Scene* scene, struct Draw* draws);
+
+/* what the renderer reads a scene from: a persistently mapped instance
+ * buffer per frame slot and the draws of the last write. a slot is only
+ * written once its last frame finished on the GPU */
+struct SceneFrames
+{
+    struct Buffer buffers[SCENE_FRAMES_MAX]; /* HOST_VISIBLE, VERTEX and STORAGE */
+    uint32_t      slotsCount;
+    uint32_t      capacity; /* instances per buffer */
+    struct Draw*  draws;    /* room for capacity */
+    uint32_t      drawsCount;
+};
+
+/* buffers of capacity instances for slotsCount slots, at most
+ * SCENE_FRAMES_MAX, exits on failure */
+void scene_frames_init(struct SceneFrames* frames,
+                       struct Allocator*   allocator,
+                       uint32_t            capacity,
+                       uint32_t            slotsCount);
+
+void scene_frames_destroy(struct SceneFrames* frames, struct Allocator* allocator);
+
+/* scene_instances_write into the mapped buffer of slot and
+ * scene_draws_build into frames->draws. exits if the scene has more
+ * transforms than capacity */
+void scene_frame_write(struct SceneFrames* frames, const struct Scene* scene, uint32_t slot);
@@ -0,0 +1,63 @@
+#include "shaders.h"
+
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool shaders_get(const char*        name,
+                 const char*        overrideDir,
+                 const struct Pack* pack,
+                 struct ShaderCode* code)
+{
+    *code = (struct ShaderCode){};
+
+    if (overrideDir != NULL)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", overrideDir, name);
+
+        /* malloc keeps the contents aligned for uint32_t */
+        char* file = NULL;
+        int   size = ae_load_file_to_memory(path, &file);
+        if (size > 0 && size % sizeof(uint32_t) == 0)
+        {
+            printf("shader %s from %s\n", name, path);
+            code->code   = (const uint32_t*) file;
+            code->size   = (size_t) size;
+            code->loaded = file;
+            return true;
+        }
+        if (size > 0)
+            fprintf(stderr, "shader %s is not SPIR-V, using the embedded one\n", path);
+        free(file);
+    }
+
+    size_t      size;
+    const void* blob = pack != NULL ? pack_find(pack, name, &size) : NULL;
+    if (blob != NULL && size > 0 && size % sizeof(uint32_t) == 0)
+    {
+        /* blobs are PACK_ALIGNMENT aligned */
+        code->code = blob;
+        code->size = size;
+        return true;
+    }
+
+    for (uint32_t i = 0; i < shadersEmbeddedCount; ++i)
+    {
+        if (strcmp(shadersEmbedded[i].name, name) == 0)
+        {
+            code->code = shadersEmbedded[i].code;
+            code->size = shadersEmbedded[i].size;
+            return true;
+        }
+    }
+    return false;
+}
+
+void shaders_release(struct ShaderCode* code)
+{
+    free(code->loaded);
+    *code = (struct ShaderCode){};
+}
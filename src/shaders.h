@@ -0,0 +1,37 @@
+#pragma once
+
+#include "pack.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* SPIR-V compiled at build time, table generated by cmake into
+ * <build>/shaders/shaders_embedded.c */
+struct ShaderEmbedded
+{
+    const char*     name; /* file name of the .spv, e.g. "shader.vert.spv" */
+    const uint32_t* code;
+    size_t          size; /* bytes */
+};
+
+extern const struct ShaderEmbedded shadersEmbedded[];
+extern const uint32_t              shadersEmbeddedCount;
+
+struct ShaderCode
+{
+    const uint32_t* code;
+    size_t          size;   /* bytes */
+    char*           loaded; /* owned file contents, NULL if embedded or packed */
+};
+
+/* SPIR-V of name, first found of: <overrideDir>/<name> (for editing
+ * shaders without relinking), the blob in pack (used in place, no copy)
+ * and the embedded copy. overrideDir and pack may be NULL. false if none
+ * has name */
+bool shaders_get(const char*        name,
+                 const char*        overrideDir,
+                 const struct Pack* pack,
+                 struct ShaderCode* code);
+
+void shaders_release(struct ShaderCode* code);
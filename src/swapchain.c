@@ -0,0 +1,275 @@
+#include "swapchain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t swapchain_clamp(uint32_t value, uint32_t min, uint32_t max)
+{
+    return value < min ? min : value > max ? max : value;
+}
+
+static void swapchain_headless_images(struct Swapchain*             swapchain,
+                                      const struct SwapchainConfig* config)
+{
+    swapchain->imagesCount = config->headlessImagesCount;
+    if (swapchain->imagesCount > SWAPCHAIN_IMAGES_MAX)
+        swapchain->imagesCount = SWAPCHAIN_IMAGES_MAX;
+
+    for (uint32_t i = 0; i < swapchain->imagesCount; ++i)
+    {
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType         = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format            = config->format.format;
+        imageCreateInfo.extent.width      = swapchain->extent.width;
+        imageCreateInfo.extent.height     = swapchain->extent.height;
+        imageCreateInfo.extent.depth      = 1;
+        imageCreateInfo.mipLevels         = 1;
+        imageCreateInfo.arrayLayers       = 1;
+        imageCreateInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage =
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageCreateInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(config->device, &imageCreateInfo, NULL, &swapchain->images[i]) !=
+            VK_SUCCESS)
+        {
+            fprintf(stderr, "headless image create error\n");
+            exit(EXIT_FAILURE);
+        }
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(config->device, swapchain->images[i], &memoryRequirements);
+
+        if (!allocator_alloc(config->allocator,
+                             &memoryRequirements,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                             ALLOCATOR_KIND_OPTIMAL,
+                             &swapchain->headlessMemory[i]) ||
+            vkBindImageMemory(config->device,
+                              swapchain->images[i],
+                              swapchain->headlessMemory[i].memory,
+                              swapchain->headlessMemory[i].offset) != VK_SUCCESS)
+        {
+            fprintf(stderr, "headless image memory error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void swapchain_surface_images(struct Swapchain*             swapchain,
+                                     const struct SwapchainConfig* config,
+                                     VkExtent2D                    extent,
+                                     VkSwapchainKHR                oldSwapchain)
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+        config->devicePhysical, config->surface, &capabilities);
+
+    /* UINT32_MAX: the surface takes the size of the swapchain */
+    if (capabilities.currentExtent.width != UINT32_MAX)
+    {
+        swapchain->extent = capabilities.currentExtent;
+    }
+    else
+    {
+        swapchain->extent.width  = swapchain_clamp(extent.width,
+                                                  capabilities.minImageExtent.width,
+                                                  capabilities.maxImageExtent.width);
+        swapchain->extent.height = swapchain_clamp(extent.height,
+                                                   capabilities.minImageExtent.height,
+                                                   capabilities.maxImageExtent.height);
+    }
+
+    uint32_t imageCount = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
+    {
+        imageCount = capabilities.maxImageCount;
+    }
+
+    VkSwapchainCreateInfoKHR swapChainCreateInfo = {};
+    swapChainCreateInfo.sType                    = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapChainCreateInfo.surface                  = config->surface;
+
+    swapChainCreateInfo.minImageCount    = imageCount;
+    swapChainCreateInfo.imageFormat      = config->format.format;
+    swapChainCreateInfo.imageColorSpace  = config->format.colorSpace;
+    swapChainCreateInfo.imageExtent      = swapchain->extent;
+    swapChainCreateInfo.imageArrayLayers = 1;
+    swapChainCreateInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+    uint32_t queueFamilyIndices[2] = {config->queueFamilyGraphics, config->queueFamilyPresent};
+    if (config->queueFamilyGraphics != config->queueFamilyPresent)
+    {
+        swapChainCreateInfo.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
+        swapChainCreateInfo.queueFamilyIndexCount = 2;
+        swapChainCreateInfo.pQueueFamilyIndices   = queueFamilyIndices;
+    }
+    else
+    {
+        swapChainCreateInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
+        swapChainCreateInfo.queueFamilyIndexCount = 0;
+        swapChainCreateInfo.pQueueFamilyIndices   = NULL;
+    }
+
+    swapChainCreateInfo.preTransform   = capabilities.currentTransform;
+    swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    swapChainCreateInfo.presentMode    = config->presentMode;
+    swapChainCreateInfo.clipped        = VK_TRUE;
+    swapChainCreateInfo.oldSwapchain   = oldSwapchain;
+
+    VkResult swapChainCreateResult;
+    if ((swapChainCreateResult = vkCreateSwapchainKHR(
+             config->device, &swapChainCreateInfo, NULL, &swapchain->swapchain)) != VK_SUCCESS)
+    {
+        fprintf(stderr, "swapChain creation Error: %d.\n", swapChainCreateResult);
+        exit(EXIT_FAILURE);
+    }
+
+    vkGetSwapchainImagesKHR(config->device, swapchain->swapchain, &swapchain->imagesCount, NULL);
+    if (swapchain->imagesCount > SWAPCHAIN_IMAGES_MAX)
+    {
+        fprintf(stderr,
+                "swapChain has %d images, at most %d are supported\n",
+                swapchain->imagesCount,
+                SWAPCHAIN_IMAGES_MAX);
+        exit(EXIT_FAILURE);
+    }
+    vkGetSwapchainImagesKHR(
+        config->device, swapchain->swapchain, &swapchain->imagesCount, swapchain->images);
+}
+
+static void swapchain_image_views(struct Swapchain*             swapchain,
+                                  const struct SwapchainConfig* config)
+{
+    for (uint32_t i = 0; i < swapchain->imagesCount; ++i)
+    {
+        VkImageViewCreateInfo createInfo = {};
+        createInfo.sType                 = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.image                 = swapchain->images[i];
+
+        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        createInfo.format   = config->format.format;
+
+        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+        createInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        createInfo.subresourceRange.baseMipLevel   = 0;
+        createInfo.subresourceRange.levelCount     = 1;
+        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.layerCount     = 1;
+
+        VkResult imageViewCreateResult;
+        if ((imageViewCreateResult = vkCreateImageView(
+                 config->device, &createInfo, NULL, &swapchain->imageViews[i])) != VK_SUCCESS)
+        {
+            fprintf(stderr, "imageView creation Error: %d.\n", imageViewCreateResult);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void swapchain_create(struct Swapchain*             swapchain,
+                      const struct SwapchainConfig* config,
+                      VkExtent2D                    extent)
+{
+    *swapchain = (struct Swapchain){};
+
+    if (config->surface == VK_NULL_HANDLE)
+    {
+        swapchain->extent = extent;
+        swapchain_headless_images(swapchain, config);
+    }
+    else
+    {
+        swapchain_surface_images(swapchain, config, extent, VK_NULL_HANDLE);
+    }
+
+    swapchain_image_views(swapchain, config);
+}
+
+void swapchain_framebuffers_create(struct Swapchain*             swapchain,
+                                   const struct SwapchainConfig* config,
+                                   VkRenderPass                  renderPass)
+{
+    for (uint32_t i = 0; i < swapchain->imagesCount; ++i)
+    {
+        VkImageView attachments[] = {swapchain->imageViews[i]};
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass              = renderPass;
+        framebufferInfo.attachmentCount         = 1;
+        framebufferInfo.pAttachments            = attachments;
+        framebufferInfo.width                   = swapchain->extent.width;
+        framebufferInfo.height                  = swapchain->extent.height;
+        framebufferInfo.layers                  = 1;
+
+        if (vkCreateFramebuffer(
+                config->device, &framebufferInfo, NULL, &swapchain->framebuffers[i]) != VK_SUCCESS)
+        {
+            fprintf(stderr, "framebuffer create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/* destroys per image objects, keeps the VkSwapchainKHR itself */
+static void swapchain_release_images(struct Swapchain*             swapchain,
+                                     const struct SwapchainConfig* config)
+{
+    for (uint32_t i = 0; i < swapchain->imagesCount; ++i)
+    {
+        if (swapchain->framebuffers[i] != VK_NULL_HANDLE)
+            vkDestroyFramebuffer(config->device, swapchain->framebuffers[i], NULL);
+        vkDestroyImageView(config->device, swapchain->imageViews[i], NULL);
+        swapchain->framebuffers[i] = VK_NULL_HANDLE;
+        swapchain->imageViews[i]   = VK_NULL_HANDLE;
+
+        /* swapchain images belong to the swapchain */
+        if (config->surface == VK_NULL_HANDLE)
+        {
+            vkDestroyImage(config->device, swapchain->images[i], NULL);
+            allocator_free(config->allocator, &swapchain->headlessMemory[i]);
+        }
+    }
+    swapchain->imagesCount = 0;
+}
+
+void swapchain_recreate(struct Swapchain*             swapchain,
+                        const struct SwapchainConfig* config,
+                        VkRenderPass                  renderPass,
+                        VkExtent2D                    extent)
+{
+    swapchain_release_images(swapchain, config);
+
+    if (config->surface == VK_NULL_HANDLE)
+    {
+        swapchain->extent = extent;
+        swapchain_headless_images(swapchain, config);
+    }
+    else
+    {
+        /* the presentation engine can keep showing the old images while
+         * the new swapchain takes over */
+        VkSwapchainKHR oldSwapchain = swapchain->swapchain;
+        swapchain_surface_images(swapchain, config, extent, oldSwapchain);
+        vkDestroySwapchainKHR(config->device, oldSwapchain, NULL);
+    }
+
+    swapchain_image_views(swapchain, config);
+    swapchain_framebuffers_create(swapchain, config, renderPass);
+}
+
+void swapchain_destroy(struct Swapchain* swapchain, const struct SwapchainConfig* config)
+{
+    swapchain_release_images(swapchain, config);
+    if (swapchain->swapchain != VK_NULL_HANDLE)
+        vkDestroySwapchainKHR(config->device, swapchain->swapchain, NULL);
+    *swapchain = (struct Swapchain){};
+}
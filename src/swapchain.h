@@ -0,0 +1,56 @@
+#pragma once
+
+#include "allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#define SWAPCHAIN_IMAGES_MAX 8
+
+/* everything that stays the same when the swapchain is recreated */
+struct SwapchainConfig
+{
+    VkPhysicalDevice   devicePhysical;
+    VkDevice           device;
+    VkSurfaceKHR       surface;   /* VK_NULL_HANDLE: headless, offscreen images */
+    struct Allocator*  allocator; /* memory of the headless images */
+    VkSurfaceFormatKHR format;
+    VkPresentModeKHR   presentMode;
+    uint32_t           queueFamilyGraphics;
+    uint32_t           queueFamilyPresent;
+    uint32_t           headlessImagesCount;
+};
+
+/* swapchain images and what is built per image. render pass and pipelines
+ * do not depend on the extent (viewport and scissor are dynamic state),
+ * so they survive a recreate. */
+struct Swapchain
+{
+    VkSwapchainKHR    swapchain; /* VK_NULL_HANDLE when headless */
+    VkExtent2D        extent;
+    uint32_t          imagesCount;
+    VkImage           images[SWAPCHAIN_IMAGES_MAX];
+    VkImageView       imageViews[SWAPCHAIN_IMAGES_MAX];
+    VkFramebuffer     framebuffers[SWAPCHAIN_IMAGES_MAX];
+    struct Allocation headlessMemory[SWAPCHAIN_IMAGES_MAX];
+};
+
+/* creates the swapchain (or offscreen images) and their views. extent is
+ * used where the surface leaves the size to the application, clamped to
+ * what it supports. exits on failure. */
+void swapchain_create(struct Swapchain*             swapchain,
+                      const struct SwapchainConfig* config,
+                      VkExtent2D                    extent);
+
+void swapchain_framebuffers_create(struct Swapchain*             swapchain,
+                                   const struct SwapchainConfig* config,
+                                   VkRenderPass                  renderPass);
+
+/* rebuilds swapchain, views and framebuffers for extent. the old swapchain
+ * is handed over as oldSwapchain and destroyed afterwards. no image of the
+ * swapchain may be in use by the device. */
+void swapchain_recreate(struct Swapchain*             swapchain,
+                        const struct SwapchainConfig* config,
+                        VkRenderPass                  renderPass,
+                        VkExtent2D                    extent);
+
+void swapchain_destroy(struct Swapchain* swapchain, const struct SwapchainConfig* config);
@@ -0,0 +1,526 @@
+#include "texture.h"
+
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* texture_alloc(size_t size)
+{
+    void* memory = malloc(size > 0 ? size : 1);
+    if (memory == NULL)
+    {
+        fprintf(stderr, "texture out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static uint32_t texture_mip_extent(uint32_t extent, uint32_t mip)
+{
+    extent >>= mip;
+    return extent > 0 ? extent : 1;
+}
+
+void texture_streamer_init(struct TextureStreamer* streamer,
+                           struct Allocator*       allocator,
+                           struct Uploader*        uploader,
+                           struct Bindless*        bindless,
+                           VkDeviceSize            budget,
+                           uint32_t                capacity,
+                           uint32_t                slotsCount)
+{
+    if (slotsCount < 1 || slotsCount > TEXTURE_SLOTS_MAX)
+    {
+        fprintf(stderr, "texture streamer slots must be 1 to %d\n", TEXTURE_SLOTS_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    *streamer            = (struct TextureStreamer){};
+    streamer->device     = allocator->device;
+    streamer->allocator  = allocator;
+    streamer->uploader   = uploader;
+    streamer->bindless   = bindless;
+    streamer->budget     = budget;
+    streamer->capacity   = capacity;
+    streamer->slotsCount = slotsCount;
+    streamer->textures   = texture_alloc(capacity * sizeof(streamer->textures[0]));
+    streamer->order      = texture_alloc(capacity * sizeof(streamer->order[0]));
+    streamer->sets       = texture_alloc(capacity * slotsCount * sizeof(streamer->sets[0]));
+    /* texture_use before the first texture_streamer_frame counts for it,
+     * lastUsed 0 of a texture never used does not */
+    streamer->frame = 1;
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter           = VK_FILTER_LINEAR;
+    samplerInfo.minFilter           = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.minLod              = 0.0f;
+    samplerInfo.maxLod              = VK_LOD_CLAMP_NONE;
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding                      = 0;
+    binding.descriptorType               = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount              = 1;
+    binding.stageFlags                   = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 1;
+    setLayoutInfo.pBindings    = &binding;
+
+    if (vkCreateSampler(streamer->device, &samplerInfo, NULL, &streamer->sampler) != VK_SUCCESS ||
+        vkCreateDescriptorSetLayout(
+            streamer->device, &setLayoutInfo, NULL, &streamer->setLayout) != VK_SUCCESS)
+    {
+        fprintf(stderr, "texture sampler create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* every set up front, written when the resident image changes */
+    uint32_t             setsCount = capacity * slotsCount;
+    VkDescriptorPoolSize poolSize  = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setsCount};
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets                    = setsCount;
+    poolInfo.poolSizeCount              = 1;
+    poolInfo.pPoolSizes                 = &poolSize;
+
+    if (vkCreateDescriptorPool(streamer->device, &poolInfo, NULL, &streamer->descriptorPool) !=
+        VK_SUCCESS)
+    {
+        fprintf(stderr, "texture descriptor pool create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkDescriptorSetLayout* layouts = texture_alloc(setsCount * sizeof(layouts[0]));
+    for (uint32_t i = 0; i < setsCount; ++i)
+        layouts[i] = streamer->setLayout;
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool              = streamer->descriptorPool;
+    setInfo.descriptorSetCount          = setsCount;
+    setInfo.pSetLayouts                 = layouts;
+    if (setsCount > 0 &&
+        vkAllocateDescriptorSets(streamer->device, &setInfo, streamer->sets) != VK_SUCCESS)
+    {
+        fprintf(stderr, "texture descriptor set allocate error\n");
+        exit(EXIT_FAILURE);
+    }
+    free(layouts);
+}
+
+static void texture_image_destroy(struct TextureStreamer* streamer, struct TextureImage* image)
+{
+    if (image->mip == TEXTURE_NONE)
+        return;
+
+    vkDestroyImageView(streamer->device, image->view, NULL);
+    vkDestroyImage(streamer->device, image->image, NULL);
+    allocator_free(streamer->allocator, &image->allocation);
+    streamer->stats.resident -= image->allocation.size;
+    *image     = (struct TextureImage){};
+    image->mip = TEXTURE_NONE;
+}
+
+void texture_streamer_destroy(struct TextureStreamer* streamer)
+{
+    for (uint32_t i = 0; i < streamer->retiredCount; ++i)
+        texture_image_destroy(streamer, &streamer->retired[i].image);
+    for (uint32_t i = 0; i < streamer->texturesCount; ++i)
+    {
+        struct Texture* texture = &streamer->textures[i];
+        if (streamer->bindless != NULL && texture->bindlessIndex != BINDLESS_DEFAULT)
+            bindless_texture_remove(streamer->bindless, texture->bindlessIndex);
+        texture_image_destroy(streamer, &texture->resident);
+        texture_image_destroy(streamer, &texture->pending);
+        free(texture->owned);
+    }
+
+    vkDestroyDescriptorPool(streamer->device, streamer->descriptorPool, NULL);
+    vkDestroyDescriptorSetLayout(streamer->device, streamer->setLayout, NULL);
+    vkDestroySampler(streamer->device, streamer->sampler, NULL);
+    free(streamer->retired);
+    free(streamer->sets);
+    free(streamer->order);
+    free(streamer->textures);
+    *streamer = (struct TextureStreamer){};
+}
+
+uint32_t texture_mips_count(uint32_t width, uint32_t height)
+{
+    uint32_t extent = width > height ? width : height;
+    uint32_t count  = 1;
+    while (extent > 1)
+    {
+        extent >>= 1;
+        count++;
+    }
+    return count;
+}
+
+/* each texel of a mip is the average of the 2x2 texels under it in the
+ * one before, the last row or column repeats on odd extents */
+static void texture_mips_build(struct Texture* texture)
+{
+    for (uint32_t mip = 1; mip < texture->mipsCount; ++mip)
+    {
+        uint32_t       srcWidth  = texture_mip_extent(texture->width, mip - 1);
+        uint32_t       srcHeight = texture_mip_extent(texture->height, mip - 1);
+        uint32_t       width     = texture_mip_extent(texture->width, mip);
+        uint32_t       height    = texture_mip_extent(texture->height, mip);
+        const uint8_t* src       = texture->owned + texture->mipOffsets[mip - 1];
+        uint8_t*       dst       = texture->owned + texture->mipOffsets[mip];
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            uint32_t y0 = y * 2 < srcHeight ? y * 2 : srcHeight - 1;
+            uint32_t y1 = y * 2 + 1 < srcHeight ? y * 2 + 1 : y0;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint32_t       x0    = x * 2 < srcWidth ? x * 2 : srcWidth - 1;
+                uint32_t       x1    = x * 2 + 1 < srcWidth ? x * 2 + 1 : x0;
+                const uint8_t* a     = &src[(y0 * srcWidth + x0) * TEXTURE_TEXEL_SIZE];
+                const uint8_t* b     = &src[(y0 * srcWidth + x1) * TEXTURE_TEXEL_SIZE];
+                const uint8_t* c     = &src[(y1 * srcWidth + x0) * TEXTURE_TEXEL_SIZE];
+                const uint8_t* d     = &src[(y1 * srcWidth + x1) * TEXTURE_TEXEL_SIZE];
+                uint8_t*       texel = &dst[(y * width + x) * TEXTURE_TEXEL_SIZE];
+                for (uint32_t i = 0; i < TEXTURE_TEXEL_SIZE; ++i)
+                    texel[i] = (uint8_t) ((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+            }
+        }
+    }
+}
+
+uint32_t texture_create(struct TextureStreamer* streamer,
+                        const void*             texels,
+                        uint32_t                width,
+                        uint32_t                height,
+                        uint32_t                mipsCount)
+{
+    if (width == 0 || height == 0)
+    {
+        fprintf(stderr, "texture create error: empty extent %ux%u\n", width, height);
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t chainCount = texture_mips_count(width, height);
+    if (streamer->texturesCount == streamer->capacity || chainCount > TEXTURE_MIPS_MAX ||
+        (mipsCount != 1 && mipsCount != chainCount))
+    {
+        fprintf(stderr, "texture create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct Texture* texture = &streamer->textures[streamer->texturesCount];
+    *texture                = (struct Texture){};
+    texture->width          = width;
+    texture->height         = height;
+    texture->mipsCount      = chainCount;
+    texture->resident.mip   = TEXTURE_NONE;
+    texture->pending.mip    = TEXTURE_NONE;
+    texture->tailMip        = chainCount - 1;
+    texture->bindlessIndex  = BINDLESS_DEFAULT;
+    for (uint32_t mip = 0; mip < chainCount; ++mip)
+    {
+        uint32_t     mipWidth  = texture_mip_extent(width, mip);
+        uint32_t     mipHeight = texture_mip_extent(height, mip);
+        VkDeviceSize mipSize   = (VkDeviceSize) mipWidth * mipHeight * TEXTURE_TEXEL_SIZE;
+        texture->mipOffsets[mip + 1] = texture->mipOffsets[mip] + mipSize;
+        if (mip < texture->tailMip && mipWidth <= TEXTURE_TAIL_SIZE &&
+            mipHeight <= TEXTURE_TAIL_SIZE)
+            texture->tailMip = mip;
+    }
+
+    if (mipsCount == 1)
+    {
+        texture->owned = texture_alloc(texture->mipOffsets[chainCount]);
+        memcpy(texture->owned, texels, texture->mipOffsets[1]);
+        texture_mips_build(texture);
+        texture->texels = texture->owned;
+    }
+    else
+    {
+        texture->texels = texels;
+    }
+    return streamer->texturesCount++;
+}
+
+/* frames up to the current one may sample image, it goes once they are done */
+static void texture_retire(struct TextureStreamer* streamer, struct TextureImage* image)
+{
+    if (image->mip == TEXTURE_NONE)
+        return;
+    if (streamer->retiredCount == streamer->retiredCapacity)
+    {
+        streamer->retiredCapacity = streamer->retiredCapacity ? streamer->retiredCapacity * 2 : 16;
+        streamer->retired =
+            realloc(streamer->retired, streamer->retiredCapacity * sizeof(streamer->retired[0]));
+        if (streamer->retired == NULL)
+        {
+            fprintf(stderr, "texture out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    struct TextureRetired* retired = &streamer->retired[streamer->retiredCount++];
+    retired->image                 = *image;
+    retired->frame                 = streamer->frame;
+    *image                         = (struct TextureImage){};
+    image->mip                     = TEXTURE_NONE;
+}
+
+/* points texture's bindless entry at its resident image, the old entry
+ * stays readable by frames in flight as the image it holds does */
+static void texture_bindless_update(struct TextureStreamer* streamer, struct Texture* texture)
+{
+    if (streamer->bindless == NULL)
+        return;
+    if (texture->bindlessIndex != BINDLESS_DEFAULT)
+        bindless_texture_remove(streamer->bindless, texture->bindlessIndex);
+    texture->bindlessIndex = BINDLESS_DEFAULT;
+    if (texture->resident.mip != TEXTURE_NONE)
+        texture->bindlessIndex =
+            bindless_texture_add(streamer->bindless, texture->resident.view, streamer->sampler);
+}
+
+static bool texture_wanted(const struct TextureStreamer* streamer, const struct Texture* texture)
+{
+    return texture->lastUsed + 1 >= streamer->frame;
+}
+
+/* bytes retired images still hold, free within frames in flight */
+static VkDeviceSize texture_retiring(const struct TextureStreamer* streamer)
+{
+    VkDeviceSize bytes = 0;
+    for (uint32_t i = 0; i < streamer->retiredCount; ++i)
+        bytes += streamer->retired[i].image.allocation.size;
+    return bytes;
+}
+
+/* retires least recently used textures no frame wants until size more
+ * bytes fit the budget once retired images are gone. false if they do
+ * not even then */
+static bool texture_evict(struct TextureStreamer* streamer, VkDeviceSize size)
+{
+    VkDeviceSize retiring = texture_retiring(streamer);
+    while (streamer->stats.resident - retiring + size > streamer->budget)
+    {
+        struct Texture* victim = NULL;
+        for (uint32_t i = 0; i < streamer->texturesCount; ++i)
+        {
+            struct Texture* texture = &streamer->textures[i];
+            if (texture->resident.mip == TEXTURE_NONE || texture->pending.mip != TEXTURE_NONE ||
+                texture_wanted(streamer, texture))
+                continue;
+            if (victim == NULL || texture->lastUsed < victim->lastUsed)
+                victim = texture;
+        }
+        if (victim == NULL)
+            return false;
+
+        retiring += victim->resident.allocation.size;
+        texture_retire(streamer, &victim->resident);
+        texture_bindless_update(streamer, victim);
+        streamer->stats.evictions++;
+    }
+    return true;
+}
+
+/* image of texture's mips from mip on, uploading. false, with nothing
+ * created, if it does not fit budget, memory or the staging ring now */
+static bool texture_upload(struct TextureStreamer* streamer,
+                           struct Texture*         texture,
+                           uint32_t                mip,
+                           struct TextureImage*    image)
+{
+    VkExtent3D extent = {
+        texture_mip_extent(texture->width, mip), texture_mip_extent(texture->height, mip), 1};
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = TEXTURE_FORMAT;
+    imageInfo.extent            = extent;
+    imageInfo.mipLevels         = texture->mipsCount - mip;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(streamer->device, &imageInfo, NULL, &image->image) != VK_SUCCESS)
+    {
+        fprintf(stderr, "texture image create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(streamer->device, image->image, &memoryRequirements);
+    if (streamer->stats.resident + memoryRequirements.size > streamer->budget)
+    {
+        /* room shows up once the evicted images are retired */
+        texture_evict(streamer, memoryRequirements.size);
+        vkDestroyImage(streamer->device, image->image, NULL);
+        return false;
+    }
+    if (!allocator_alloc(streamer->allocator,
+                         &memoryRequirements,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         ALLOCATOR_KIND_OPTIMAL,
+                         &image->allocation))
+    {
+        vkDestroyImage(streamer->device, image->image, NULL);
+        return false;
+    }
+
+    VkImageViewCreateInfo viewInfo           = {};
+    viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                           = image->image;
+    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                          = TEXTURE_FORMAT;
+    viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel   = 0;
+    viewInfo.subresourceRange.levelCount     = imageInfo.mipLevels;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount     = 1;
+
+    if (vkBindImageMemory(streamer->device,
+                          image->image,
+                          image->allocation.memory,
+                          image->allocation.offset) != VK_SUCCESS ||
+        vkCreateImageView(streamer->device, &viewInfo, NULL, &image->view) != VK_SUCCESS)
+    {
+        fprintf(stderr, "texture image memory error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkDeviceSize size = texture->mipOffsets[texture->mipsCount] - texture->mipOffsets[mip];
+    image->ticket     = upload_image(streamer->uploader,
+                                     image->image,
+                                     extent,
+                                     imageInfo.mipLevels,
+                                     texture->texels + texture->mipOffsets[mip],
+                                     size);
+    if (image->ticket == 0)
+    {
+        /* nothing recorded yet, the image can go right away */
+        vkDestroyImageView(streamer->device, image->view, NULL);
+        vkDestroyImage(streamer->device, image->image, NULL);
+        allocator_free(streamer->allocator, &image->allocation);
+        return false;
+    }
+
+    image->mip = mip;
+    streamer->stats.resident += image->allocation.size;
+    if (streamer->stats.resident > streamer->stats.residentPeak)
+        streamer->stats.residentPeak = streamer->stats.resident;
+    streamer->stats.uploadedBytes += size;
+    streamer->stats.uploads++;
+    return true;
+}
+
+static int texture_order_compare(const void* a, const void* b)
+{
+    uint64_t left  = *(const uint64_t*) a;
+    uint64_t right = *(const uint64_t*) b;
+    return (left > right) - (left < right);
+}
+
+void texture_streamer_frame(struct TextureStreamer* streamer)
+{
+    PROFILE_SCOPE("texture stream");
+    streamer->frame++;
+
+    /* the frame retiring an image has been waited for slotsCount frames on */
+    for (uint32_t i = 0; i < streamer->retiredCount;)
+    {
+        struct TextureRetired* retired = &streamer->retired[i];
+        if (retired->frame + streamer->slotsCount > streamer->frame)
+        {
+            ++i;
+            continue;
+        }
+        texture_image_destroy(streamer, &retired->image);
+        *retired = streamer->retired[--streamer->retiredCount];
+    }
+
+    /* acquired by an earlier frame's upload_frame, so usable from this one */
+    uint32_t candidates = 0;
+    for (uint32_t i = 0; i < streamer->texturesCount; ++i)
+    {
+        struct Texture* texture = &streamer->textures[i];
+        if (texture->pending.mip != TEXTURE_NONE &&
+            upload_done(streamer->uploader, texture->pending.ticket))
+        {
+            texture_retire(streamer, &texture->resident);
+            texture->resident    = texture->pending;
+            texture->pending     = (struct TextureImage){};
+            texture->pending.mip = TEXTURE_NONE;
+            texture_bindless_update(streamer, texture);
+        }
+
+        if (texture->pending.mip == TEXTURE_NONE && texture->resident.mip != 0 &&
+            texture_wanted(streamer, texture))
+        {
+            /* coarsest resident first, none at all before anything */
+            uint64_t width = texture->resident.mip == TEXTURE_NONE
+                                 ? 0
+                                 : texture_mip_extent(texture->width, texture->resident.mip);
+            streamer->order[candidates++] = width << 32 | i;
+        }
+    }
+    qsort(streamer->order, candidates, sizeof(streamer->order[0]), texture_order_compare);
+
+    VkDeviceSize staged = 0;
+    for (uint32_t i = 0; i < candidates && staged < TEXTURE_FRAME_BYTES; ++i)
+    {
+        struct Texture* texture = &streamer->textures[(uint32_t) streamer->order[i]];
+        uint32_t        mip     = texture->resident.mip == TEXTURE_NONE ? texture->tailMip
+                                                                        : texture->resident.mip - 1;
+        if (!texture_upload(streamer, texture, mip, &texture->pending))
+        {
+            /* the rest is finer still, it waits for the next frame too */
+            streamer->stats.deferred++;
+            break;
+        }
+        staged += texture->mipOffsets[texture->mipsCount] - texture->mipOffsets[mip];
+    }
+}
+
+VkDescriptorSet texture_descriptor(struct TextureStreamer* streamer,
+                                   uint32_t                texture,
+                                   uint32_t                slot)
+{
+    struct Texture* entry = &streamer->textures[texture];
+    if (entry->resident.mip == TEXTURE_NONE)
+        return VK_NULL_HANDLE;
+
+    /* the slot's last frame is done with the set, it can be rewritten */
+    VkDescriptorSet set = streamer->sets[texture * streamer->slotsCount + slot];
+    if (entry->slotTickets[slot] != entry->resident.ticket)
+    {
+        VkDescriptorImageInfo imageInfo = {};
+        imageInfo.sampler               = streamer->sampler;
+        imageInfo.imageView             = entry->resident.view;
+        imageInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkWriteDescriptorSet write = {};
+        write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet               = set;
+        write.dstBinding           = 0;
+        write.descriptorCount      = 1;
+        write.descriptorType       = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo           = &imageInfo;
+        vkUpdateDescriptorSets(streamer->device, 1, &write, 0, NULL);
+        entry->slotTickets[slot] = entry->resident.ticket;
+    }
+    return set;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "allocator.h"
+#include "bindless.h"
+#include "upload.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define TEXTURE_FORMAT      VK_FORMAT_R8G8B8A8_UNORM
+#define TEXTURE_TEXEL_SIZE  4
+#define TEXTURE_MIPS_MAX    UPLOAD_LEVELS_MAX
+#define TEXTURE_TAIL_SIZE   64           /* mips this wide or smaller stream in together, first */
+#define TEXTURE_FRAME_BYTES (8u << 20)   /* staged per frame, past the first upload */
+#define TEXTURE_SLOTS_MAX   4            /* frames in flight, one descriptor set each */
+#define TEXTURE_NONE        UINT32_MAX   /* TextureImage.mip of no image */
+/* clang-format on */
+
+/* one GPU copy of a texture, holding its mips from mip to the last */
+struct TextureImage
+{
+    VkImage           image;
+    VkImageView       view;
+    struct Allocation allocation;
+    uint32_t          mip;
+    uint64_t          ticket; /* of the upload, unique per texture */
+};
+
+struct Texture
+{
+    const uint8_t*      texels; /* every mip, finest first, tightly packed */
+    uint8_t*            owned;  /* texels if texture_create built the chain, else NULL */
+    uint32_t            width;
+    uint32_t            height;
+    uint32_t            mipsCount;
+    uint32_t            tailMip; /* first mip of the tail */
+    VkDeviceSize        mipOffsets[TEXTURE_MIPS_MAX + 1];
+    struct TextureImage resident;
+    struct TextureImage pending; /* uploading, replaces resident once done */
+    uint64_t            lastUsed;
+    uint64_t            slotTickets[TEXTURE_SLOTS_MAX]; /* resident ticket each set holds */
+    uint32_t            bindlessIndex; /* of resident, BINDLESS_DEFAULT while none */
+};
+
+/* an image frames in flight may still sample */
+struct TextureRetired
+{
+    struct TextureImage image;
+    uint64_t            frame;
+};
+
+struct TextureStreamerStats
+{
+    VkDeviceSize resident; /* bytes of every image alive, retired ones included */
+    VkDeviceSize residentPeak;
+    uint64_t     uploadedBytes;
+    uint32_t     uploads;
+    uint32_t     evictions;
+    uint32_t     deferred; /* upgrades put off: over budget or staging full */
+};
+
+/* keeps the mip chains of many textures on the CPU and streams them to
+ * the GPU coarsest first: a texture in use gets its tail (every mip up to
+ * TEXTURE_TAIL_SIZE), then one finer mip at a time, in a new image that
+ * replaces the old one once its upload is done. all textures get their
+ * tail before any gets finer. images never take more than budget bytes:
+ * the least recently used textures no frame asked for are evicted to make
+ * room, and upgrades wait while that is not enough. one sampler, one
+ * combined image sampler set per texture and frame slot, and with a
+ * bindless table an entry per resident image. not thread safe */
+struct TextureStreamer
+{
+    VkDevice                    device;
+    struct Allocator*           allocator;
+    struct Uploader*            uploader;
+    struct Bindless*            bindless; /* NULL: the per texture sets only */
+    VkDeviceSize                budget;
+    uint32_t                    slotsCount;
+    VkSampler                   sampler;
+    VkDescriptorSetLayout       setLayout; /* binding 0: combined image sampler, fragment */
+    VkDescriptorPool            descriptorPool;
+    VkDescriptorSet*            sets; /* slotsCount per texture */
+    struct Texture*             textures;
+    uint32_t                    texturesCount;
+    uint32_t                    capacity;
+    struct TextureRetired*      retired;
+    uint32_t                    retiredCount;
+    uint32_t                    retiredCapacity;
+    uint64_t*                   order; /* texture_streamer_frame scratch */
+    uint64_t                    frame;
+    struct TextureStreamerStats stats;
+};
+
+/* room for capacity textures, used by up to slotsCount frames in flight.
+ * resident images are added to bindless if it is not NULL */
+void texture_streamer_init(struct TextureStreamer* streamer,
+                           struct Allocator*       allocator,
+                           struct Uploader*        uploader,
+                           struct Bindless*        bindless,
+                           VkDeviceSize            budget,
+                           uint32_t                capacity,
+                           uint32_t                slotsCount);
+
+/* the device must be idle */
+void texture_streamer_destroy(struct TextureStreamer* streamer);
+
+/* mips of a full chain down to 1x1 */
+uint32_t texture_mips_count(uint32_t width, uint32_t height);
+
+/* adds a TEXTURE_FORMAT texture, nothing resident yet. with mipsCount 1
+ * the chain is built here with a box filter into a copy of texels, with
+ * texture_mips_count mips texels are used as they are and must outlive
+ * the streamer (a mapped pack, say). width and height must not be 0.
+ * returns its index */
+uint32_t texture_create(struct TextureStreamer* streamer,
+                        const void*             texels,
+                        uint32_t                width,
+                        uint32_t                height,
+                        uint32_t                mipsCount);
+
+/* the frame being built draws with texture, keep it and stream it in */
+static inline void texture_use(struct TextureStreamer* streamer, uint32_t texture)
+{
+    streamer->textures[texture].lastUsed = streamer->frame;
+}
+
+/* call once per frame once its slot's fence signaled, before recording:
+ * destroys images no frame can use anymore, swaps in finished uploads,
+ * evicts and starts the next uploads (upload_frame submits them) */
+void texture_streamer_frame(struct TextureStreamer* streamer);
+
+/* set of texture for frames recorded in slot, VK_NULL_HANDLE while
+ * nothing is resident: draw with a fallback then */
+VkDescriptorSet texture_descriptor(struct TextureStreamer* streamer,
+                                   uint32_t                texture,
+                                   uint32_t                slot);
+
+/* bindless index of texture for frames recorded from now on, the default
+ * white texture while nothing is resident */
+static inline uint32_t texture_bindless_index(const struct TextureStreamer* streamer,
+                                              uint32_t                      texture)
+{
+    return streamer->textures[texture].bindlessIndex;
+}
+
+/* finest mip resident, TEXTURE_NONE if none */
+static inline uint32_t texture_resident_mip(const struct TextureStreamer* streamer,
+                                            uint32_t                      texture)
+{
+    return streamer->textures[texture].resident.mip;
+}
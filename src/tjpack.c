@@ -0,0 +1,206 @@
+/* tjpack: builds and inspects asset packs, see pack.h */
+#include "pack.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_ROUNDS 3
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s create <out.pack> <file>...\n"
+            "       %s list <pack>\n"
+            "       %s bench <pack> <file>...\n"
+            "create packs every file under its base name. bench loads the files\n"
+            "with the malloc + copy loader and the pack with mmap, and prints\n"
+            "time and peak RSS of each\n",
+            name,
+            name,
+            name);
+}
+
+static const char* base_name(const char* path)
+{
+    const char* slash     = strrchr(path, '/');
+    const char* backslash = strrchr(path, '\\');
+    if (backslash != NULL && (slash == NULL || backslash > slash))
+        slash = backslash;
+    return slash != NULL ? slash + 1 : path;
+}
+
+static int pack_create(const char* path, const char* const* files, uint32_t count)
+{
+    const char* names[count + 1];
+    for (uint32_t i = 0; i < count; ++i)
+        names[i] = base_name(files[i]);
+
+    if (!pack_write(path, names, files, count))
+        return EXIT_FAILURE;
+    printf("packed %d file(s) into %s\n", count, path);
+    return EXIT_SUCCESS;
+}
+
+static int pack_list(const char* path)
+{
+    struct Pack pack;
+    if (!pack_open(&pack, path))
+    {
+        fprintf(stderr, "pack open error: %s\n", path);
+        return EXIT_FAILURE;
+    }
+    for (uint32_t i = 0; i < pack.entriesCount; ++i)
+        printf("%10llu %10llu %s\n",
+               (unsigned long long) pack.entries[i].offset,
+               (unsigned long long) pack.entries[i].size,
+               pack.entries[i].name);
+    pack_close(&pack);
+    return EXIT_SUCCESS;
+}
+
+/* reads every byte, like the memcpy into a staging buffer would */
+static uint64_t bench_consume(const void* data, size_t size)
+{
+    const uint8_t* bytes = data;
+    uint64_t       sum   = 0;
+    for (size_t i = 0; i < size; ++i)
+        sum += bytes[i];
+    return sum;
+}
+
+enum BenchMode
+{
+    BENCH_NONE = 0, /* baseline RSS of the process */
+    BENCH_FILES,
+    BENCH_PACK,
+};
+
+/* loads everything and keeps it resident until all is consumed, as for
+ * one batched upload. returns the checksum */
+static uint64_t bench_load(enum BenchMode     mode,
+                           const char*        path,
+                           const char* const* files,
+                           int                count)
+{
+    uint64_t sum = 0;
+    if (mode == BENCH_FILES)
+    {
+        char* blobs[count + 1];
+        int   sizes[count + 1];
+        for (int i = 0; i < count; ++i)
+            sizes[i] = ae_load_file_to_memory(files[i], &blobs[i]);
+        for (int i = 0; i < count; ++i)
+            if (sizes[i] > 0)
+                sum += bench_consume(blobs[i], (size_t) sizes[i]);
+        for (int i = 0; i < count; ++i)
+            free(blobs[i]);
+    }
+    else if (mode == BENCH_PACK)
+    {
+        struct Pack pack;
+        if (pack_open(&pack, path))
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                size_t      size;
+                const void* blob = pack_find(&pack, base_name(files[i]), &size);
+                if (blob != NULL)
+                    sum += bench_consume(blob, size);
+            }
+            pack_close(&pack);
+        }
+    }
+    return sum;
+}
+
+static int pack_bench(const char* path, const char* const* files, int count)
+{
+#ifdef _WIN32
+    (void) path;
+    (void) files;
+    (void) count;
+    fprintf(stderr, "bench needs fork and wait4\n");
+    return EXIT_FAILURE;
+#else
+    const char* modeNames[] = {"baseline", "files", "pack"};
+    double      best[3]     = {};
+    long        rss[3]      = {};
+    uint64_t    sums[3]     = {};
+
+    /* every load in a fresh process, so peak RSS is its own */
+    for (int round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        for (int mode = BENCH_NONE; mode <= BENCH_PACK; ++mode)
+        {
+            int channel[2];
+            if (pipe(channel) != 0)
+            {
+                fprintf(stderr, "bench pipe error\n");
+                return EXIT_FAILURE;
+            }
+
+            pid_t child = fork();
+            if (child == 0)
+            {
+                close(channel[0]);
+                uint64_t start     = util_time_ns();
+                uint64_t result[2] = {bench_load(mode, path, files, count), 0};
+                result[1]          = util_time_ns() - start;
+                ssize_t written    = write(channel[1], result, sizeof(result));
+                _exit(written == sizeof(result) ? EXIT_SUCCESS : EXIT_FAILURE);
+            }
+            close(channel[1]);
+
+            uint64_t      result[2] = {};
+            ssize_t       received  = child > 0 ? read(channel[0], result, sizeof(result)) : 0;
+            int           status    = 0;
+            struct rusage usage     = {};
+            close(channel[0]);
+            if (child < 0 || wait4(child, &status, 0, &usage) != child ||
+                received != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                fprintf(stderr, "bench %s error\n", modeNames[mode]);
+                return EXIT_FAILURE;
+            }
+
+            double ms = (double) result[1] / 1e6;
+            if (round == 0 || ms < best[mode])
+                best[mode] = ms;
+            if (usage.ru_maxrss > rss[mode])
+                rss[mode] = usage.ru_maxrss;
+            sums[mode] = result[0];
+        }
+    }
+    if (sums[BENCH_FILES] != sums[BENCH_PACK])
+    {
+        fprintf(stderr, "bench: pack content differs from the files\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%d file(s), best of %d, peak RSS per process\n", count, BENCH_ROUNDS);
+    printf("%-10s %10s %14s\n", "loader", "ms", "peak RSS KiB");
+    for (int mode = BENCH_NONE; mode <= BENCH_PACK; ++mode)
+        printf("%-10s %10.3f %14ld\n", modeNames[mode], best[mode], rss[mode]);
+    return EXIT_SUCCESS;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "create") == 0)
+        return pack_create(argv[2], (const char* const*) &argv[3], (uint32_t) (argc - 3));
+    if (argc == 3 && strcmp(argv[1], "list") == 0)
+        return pack_list(argv[2]);
+    if (argc >= 4 && strcmp(argv[1], "bench") == 0)
+        return pack_bench(argv[2], (const char* const*) &argv[3], argc - 3);
+
+    usage(argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,140 @@
+#include "uniform.h"
+
+#include "buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void uniform_ring_init(struct UniformRing*           ring,
+                       struct Allocator*             allocator,
+                       const VkPhysicalDeviceLimits* limits,
+                       VkDeviceSize                  size)
+{
+    *ring           = (struct UniformRing){};
+    ring->device    = allocator->device;
+    ring->alignment = limits->minUniformBufferOffsetAlignment;
+    if (limits->minStorageBufferOffsetAlignment > ring->alignment)
+        ring->alignment = limits->minStorageBufferOffsetAlignment;
+    if (ring->alignment < 16)
+        ring->alignment = 16;
+    if (UNIFORM_RANGE > limits->maxUniformBufferRange)
+    {
+        fprintf(stderr, "uniform range exceeds maxUniformBufferRange\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* the buffer reaches UNIFORM_RANGE past the last offset, so the
+     * descriptor stays inside it whatever it is bound with */
+    buffer_ring_create(allocator,
+                       size + UNIFORM_RANGE,
+                       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       &ring->ring,
+                       &ring->buffer);
+    ring->ring.size = size;
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding                      = 0;
+    binding.descriptorType               = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount              = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 1;
+    setLayoutInfo.pBindings    = &binding;
+
+    if (vkCreateDescriptorSetLayout(ring->device, &setLayoutInfo, NULL, &ring->setLayout) !=
+        VK_SUCCESS)
+    {
+        fprintf(stderr, "uniform ring layout create error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* one set for every frame: only the dynamic offset changes */
+    VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1};
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets                    = 1;
+    poolInfo.poolSizeCount              = 1;
+    poolInfo.pPoolSizes                 = &poolSize;
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorSetCount          = 1;
+    setInfo.pSetLayouts                 = &ring->setLayout;
+
+    if (vkCreateDescriptorPool(ring->device, &poolInfo, NULL, &ring->descriptorPool) !=
+        VK_SUCCESS)
+    {
+        fprintf(stderr, "uniform ring descriptor pool create error\n");
+        exit(EXIT_FAILURE);
+    }
+    setInfo.descriptorPool = ring->descriptorPool;
+    if (vkAllocateDescriptorSets(ring->device, &setInfo, &ring->set) != VK_SUCCESS)
+    {
+        fprintf(stderr, "uniform ring descriptor set allocate error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer                 = ring->buffer;
+    bufferInfo.offset                 = 0;
+    bufferInfo.range                  = UNIFORM_RANGE;
+
+    VkWriteDescriptorSet write = {};
+    write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet               = ring->set;
+    write.dstBinding           = 0;
+    write.descriptorCount      = 1;
+    write.descriptorType       = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo          = &bufferInfo;
+    vkUpdateDescriptorSets(ring->device, 1, &write, 0, NULL);
+}
+
+void uniform_ring_destroy(struct UniformRing* ring, struct Allocator* allocator)
+{
+    vkDestroyDescriptorPool(ring->device, ring->descriptorPool, NULL);
+    vkDestroyDescriptorSetLayout(ring->device, ring->setLayout, NULL);
+    buffer_ring_destroy(allocator, &ring->ring, ring->buffer);
+    *ring = (struct UniformRing){};
+}
+
+void uniform_ring_frame_begin(struct UniformRing* ring, uint32_t slot)
+{
+    allocator_ring_frame_begin(&ring->ring, slot);
+    ring->slot = slot;
+}
+
+void uniform_ring_frame_end(struct UniformRing* ring)
+{
+    ring->frameBytes = ring->ring.frameBytes;
+    if (ring->frameBytes > ring->frameBytesPeak)
+        ring->frameBytesPeak = ring->frameBytes;
+    allocator_ring_frame_end(&ring->ring, ring->slot);
+}
+
+void* uniform_ring_alloc(struct UniformRing* ring, VkDeviceSize size, uint32_t* offset)
+{
+    VkDeviceSize ringOffset;
+    if (!allocator_ring_alloc(&ring->ring, size, ring->alignment, &ringOffset))
+        return NULL;
+
+    *offset = (uint32_t) ringOffset;
+    return (char*) ring->ring.allocation.mapped + ringOffset;
+}
+
+bool uniform_ring_write(struct UniformRing* ring,
+                        const void*         data,
+                        VkDeviceSize        size,
+                        uint32_t*           offset)
+{
+    void* mapped = uniform_ring_alloc(ring, size, offset);
+    if (mapped == NULL)
+        return false;
+
+    memcpy(mapped, data, size);
+    return true;
+}
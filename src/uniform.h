@@ -0,0 +1,61 @@
+#pragma once
+
+#include "allocator.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define UNIFORM_RING_SIZE (4u << 20) /* bytes shared by every frame in flight */
+#define UNIFORM_RANGE     256        /* bytes the dynamic descriptor reads from its offset */
+/* clang-format on */
+
+/* per-frame uniform data in one persistently mapped, HOST_COHERENT
+ * buffer. a frame slot allocates aligned sub-ranges between
+ * uniform_ring_frame_begin and uniform_ring_frame_end, and they are
+ * released once the slot comes around again, so a write is a pointer bump
+ * and a memcpy: nothing is mapped, allocated or written to a descriptor
+ * per frame. set (binding 0, UNIFORM_BUFFER_DYNAMIC of UNIFORM_RANGE
+ * bytes, vertex and fragment) is bound with the offset of a sub-range as
+ * its dynamic offset. the buffer has STORAGE_BUFFER usage as well, and
+ * offsets meet both alignments. not thread safe */
+struct UniformRing
+{
+    VkDevice              device;
+    struct AllocatorRing  ring;
+    VkBuffer              buffer;
+    VkDeviceSize          alignment; /* of every offset handed out */
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorPool      descriptorPool;
+    VkDescriptorSet       set;
+    uint32_t              slot; /* frame recording, between begin and end */
+    VkDeviceSize          frameBytes;
+    VkDeviceSize          frameBytesPeak;
+};
+
+/* ring of size bytes, exits on failure */
+void uniform_ring_init(struct UniformRing*           ring,
+                       struct Allocator*             allocator,
+                       const VkPhysicalDeviceLimits* limits,
+                       VkDeviceSize                  size);
+
+/* the device must be idle */
+void uniform_ring_destroy(struct UniformRing* ring, struct Allocator* allocator);
+
+/* call once the fence of frame slot has signaled, before allocating for it */
+void uniform_ring_frame_begin(struct UniformRing* ring, uint32_t slot);
+
+/* call after the last allocation of the frame */
+void uniform_ring_frame_end(struct UniformRing* ring);
+
+/* mapped pointer to size bytes for the current frame, valid until its
+ * slot begins again. *offset is the dynamic offset to bind them with.
+ * NULL if the ring is full */
+void* uniform_ring_alloc(struct UniformRing* ring, VkDeviceSize size, uint32_t* offset);
+
+/* uniform_ring_alloc and a copy of data, false if the ring is full */
+bool uniform_ring_write(struct UniformRing* ring,
+                        const void*         data,
+                        VkDeviceSize        size,
+                        uint32_t*           offset);
@@ -0,0 +1,335 @@
+#include "upload.h"
+
+#include "buffer.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void upload_init(struct Uploader*  uploader,
+                 struct Allocator* allocator,
+                 VkQueue           queue,
+                 uint32_t          transferFamily,
+                 uint32_t          graphicsFamily,
+                 VkDeviceSize      stagingSize)
+{
+    *uploader                = (struct Uploader){};
+    uploader->device         = allocator->device;
+    uploader->allocator      = allocator;
+    uploader->queue          = queue;
+    uploader->transferFamily = transferFamily;
+    uploader->graphicsFamily = graphicsFamily;
+    uploader->ticketNext     = 1;
+
+    buffer_ring_create(allocator,
+                       stagingSize,
+                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       &uploader->ring,
+                       &uploader->staging);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex        = transferFamily;
+    poolInfo.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    for (uint32_t i = 0; i < UPLOAD_BATCHES; ++i)
+    {
+        struct UploadBatch* batch = &uploader->batches[i];
+        if (vkCreateCommandPool(uploader->device, &poolInfo, NULL, &batch->commandPool) !=
+            VK_SUCCESS)
+        {
+            fprintf(stderr, "upload commandPool create error\n");
+            exit(EXIT_FAILURE);
+        }
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool                 = batch->commandPool;
+        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount          = 1;
+
+        if (vkAllocateCommandBuffers(uploader->device, &allocInfo, &batch->commandBuffer) !=
+                VK_SUCCESS ||
+            vkCreateFence(uploader->device, &fenceInfo, NULL, &batch->fence) != VK_SUCCESS)
+        {
+            fprintf(stderr, "upload batch create error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void upload_destroy(struct Uploader* uploader)
+{
+    for (uint32_t i = 0; i < UPLOAD_BATCHES; ++i)
+    {
+        vkDestroyFence(uploader->device, uploader->batches[i].fence, NULL);
+        vkDestroyCommandPool(uploader->device, uploader->batches[i].commandPool, NULL);
+    }
+    buffer_ring_destroy(uploader->allocator, &uploader->ring, uploader->staging);
+    *uploader = (struct Uploader){};
+}
+
+/* the recording batch, opened if none is. NULL while every batch is in flight */
+static struct UploadBatch* upload_batch(struct Uploader* uploader)
+{
+    struct UploadBatch* batch = &uploader->batches[uploader->next];
+    if (uploader->open)
+        return batch;
+    if (uploader->inFlight == UPLOAD_BATCHES)
+        return NULL;
+
+    vkResetCommandPool(uploader->device, batch->commandPool, 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch->commandBuffer, &beginInfo);
+
+    batch->ticket       = uploader->ticketNext++;
+    batch->bytes        = 0;
+    batch->buffersCount = 0;
+    batch->imagesCount  = 0;
+    uploader->open      = true;
+    return batch;
+}
+
+static void upload_submit(struct Uploader* uploader)
+{
+    struct UploadBatch* batch = &uploader->batches[uploader->next];
+    if (!uploader->open || batch->buffersCount + batch->imagesCount == 0)
+        return;
+
+    /* the release half of the ownership transfer, the acquire half is
+     * recorded on the graphics queue once the fence signaled */
+    if (uploader->transferFamily != uploader->graphicsFamily)
+    {
+        VkBufferMemoryBarrier buffers[UPLOAD_BARRIERS_MAX];
+        VkImageMemoryBarrier  images[UPLOAD_BARRIERS_MAX];
+        for (uint32_t i = 0; i < batch->buffersCount; ++i)
+        {
+            buffers[i]               = batch->buffers[i];
+            buffers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            buffers[i].dstAccessMask = 0;
+        }
+        for (uint32_t i = 0; i < batch->imagesCount; ++i)
+        {
+            images[i]               = batch->images[i];
+            images[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            images[i].dstAccessMask = 0;
+        }
+        vkCmdPipelineBarrier(batch->commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             NULL,
+                             batch->buffersCount,
+                             buffers,
+                             batch->imagesCount,
+                             images);
+    }
+
+    if (vkEndCommandBuffer(batch->commandBuffer) != VK_SUCCESS)
+    {
+        fprintf(stderr, "upload commandBuffer record error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkSubmitInfo submitInfo       = {};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &batch->commandBuffer;
+    if (vkQueueSubmit(uploader->queue, 1, &submitInfo, batch->fence) != VK_SUCCESS)
+    {
+        fprintf(stderr, "upload submit error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    allocator_ring_frame_end(&uploader->ring, uploader->next);
+    if (uploader->inFlight++ == 0)
+        uploader->oldest = uploader->next;
+    uploader->next = (uploader->next + 1) % UPLOAD_BATCHES;
+    uploader->open = false;
+}
+
+/* stages size bytes of data for the recording batch, NULL batch if it can
+ * not take them now */
+static struct UploadBatch* upload_stage(struct Uploader* uploader,
+                                        const void*      data,
+                                        VkDeviceSize     size,
+                                        VkDeviceSize*    offset)
+{
+    struct UploadBatch* batch = upload_batch(uploader);
+    if (batch != NULL &&
+        (batch->buffersCount == UPLOAD_BARRIERS_MAX || batch->imagesCount == UPLOAD_BARRIERS_MAX))
+    {
+        upload_submit(uploader);
+        batch = upload_batch(uploader);
+    }
+    if (batch == NULL || !allocator_ring_alloc(&uploader->ring, size, UPLOAD_ALIGNMENT, offset))
+        return NULL;
+
+    memcpy((char*) uploader->ring.allocation.mapped + *offset, data, size);
+    batch->bytes += size;
+    return batch;
+}
+
+uint64_t upload_buffer(struct Uploader* uploader,
+                       VkBuffer         buffer,
+                       VkDeviceSize     offset,
+                       const void*      data,
+                       VkDeviceSize     size)
+{
+    VkDeviceSize        stagingOffset;
+    struct UploadBatch* batch = upload_stage(uploader, data, size, &stagingOffset);
+    if (batch == NULL)
+        return 0;
+
+    VkBufferCopy copy = {stagingOffset, offset, size};
+    vkCmdCopyBuffer(batch->commandBuffer, uploader->staging, buffer, 1, &copy);
+
+    bool                   transfer = uploader->transferFamily != uploader->graphicsFamily;
+    VkBufferMemoryBarrier* barrier  = &batch->buffers[batch->buffersCount++];
+    *barrier                        = (VkBufferMemoryBarrier){};
+    barrier->sType                  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier->srcAccessMask          = transfer ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier->dstAccessMask          = VK_ACCESS_MEMORY_READ_BIT;
+    barrier->srcQueueFamilyIndex = transfer ? uploader->transferFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier->dstQueueFamilyIndex = transfer ? uploader->graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier->buffer              = buffer;
+    barrier->offset              = offset;
+    barrier->size                = size;
+    return batch->ticket;
+}
+
+uint64_t upload_image(struct Uploader* uploader,
+                      VkImage          image,
+                      VkExtent3D       extent,
+                      uint32_t         levelsCount,
+                      const void*      data,
+                      VkDeviceSize     size)
+{
+    if (levelsCount > UPLOAD_LEVELS_MAX)
+    {
+        fprintf(stderr, "upload image has too many levels\n");
+        exit(EXIT_FAILURE);
+    }
+
+    VkDeviceSize        stagingOffset;
+    struct UploadBatch* batch = upload_stage(uploader, data, size, &stagingOffset);
+    if (batch == NULL)
+        return 0;
+
+    VkImageMemoryBarrier toTransfer            = {};
+    toTransfer.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask                   = 0;
+    toTransfer.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image                           = image;
+    toTransfer.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    toTransfer.subresourceRange.baseMipLevel   = 0;
+    toTransfer.subresourceRange.levelCount     = levelsCount;
+    toTransfer.subresourceRange.baseArrayLayer = 0;
+    toTransfer.subresourceRange.layerCount     = 1;
+    vkCmdPipelineBarrier(batch->commandBuffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         1,
+                         &toTransfer);
+
+    /* every level starts where the one before ends */
+    VkExtent3D   levelExtent = extent;
+    VkDeviceSize texels      = 0;
+    for (uint32_t level = 0; level < levelsCount; ++level)
+    {
+        texels += (VkDeviceSize) levelExtent.width * levelExtent.height * levelExtent.depth;
+        levelExtent.width  = levelExtent.width > 1 ? levelExtent.width / 2 : 1;
+        levelExtent.height = levelExtent.height > 1 ? levelExtent.height / 2 : 1;
+        levelExtent.depth  = levelExtent.depth > 1 ? levelExtent.depth / 2 : 1;
+    }
+    VkDeviceSize texelSize = size / texels;
+
+    VkBufferImageCopy copies[UPLOAD_LEVELS_MAX];
+    VkDeviceSize      levelOffset = stagingOffset;
+    for (uint32_t level = 0; level < levelsCount; ++level)
+    {
+        VkBufferImageCopy* copy               = &copies[level];
+        *copy                                 = (VkBufferImageCopy){};
+        copy->bufferOffset                    = levelOffset;
+        copy->imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy->imageSubresource.mipLevel       = level;
+        copy->imageSubresource.baseArrayLayer = 0;
+        copy->imageSubresource.layerCount     = 1;
+        copy->imageExtent                     = extent;
+        levelOffset += (VkDeviceSize) extent.width * extent.height * extent.depth * texelSize;
+
+        extent.width  = extent.width > 1 ? extent.width / 2 : 1;
+        extent.height = extent.height > 1 ? extent.height / 2 : 1;
+        extent.depth  = extent.depth > 1 ? extent.depth / 2 : 1;
+    }
+    vkCmdCopyBufferToImage(batch->commandBuffer,
+                           uploader->staging,
+                           image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           levelsCount,
+                           copies);
+
+    /* the layout transition rides on the ownership transfer */
+    bool                  transfer = uploader->transferFamily != uploader->graphicsFamily;
+    VkImageMemoryBarrier* barrier  = &batch->images[batch->imagesCount++];
+    *barrier                       = toTransfer;
+    barrier->srcAccessMask         = transfer ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier->dstAccessMask         = VK_ACCESS_SHADER_READ_BIT;
+    barrier->oldLayout             = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier->newLayout             = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier->srcQueueFamilyIndex = transfer ? uploader->transferFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier->dstQueueFamilyIndex = transfer ? uploader->graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+    return batch->ticket;
+}
+
+void upload_frame(struct Uploader* uploader, VkCommandBuffer commandBuffer)
+{
+    if (uploader == NULL)
+        return;
+    PROFILE_SCOPE("upload");
+
+    upload_submit(uploader);
+
+    /* batches finish in submission order */
+    while (uploader->inFlight > 0)
+    {
+        struct UploadBatch* batch = &uploader->batches[uploader->oldest];
+        if (vkGetFenceStatus(uploader->device, batch->fence) != VK_SUCCESS)
+            break;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             0,
+                             NULL,
+                             batch->buffersCount,
+                             batch->buffers,
+                             batch->imagesCount,
+                             batch->images);
+
+        vkResetFences(uploader->device, 1, &batch->fence);
+        allocator_ring_frame_begin(&uploader->ring, uploader->oldest);
+        uploader->ticketDone = batch->ticket;
+        uploader->bytesDone += batch->bytes;
+        uploader->oldest = (uploader->oldest + 1) % UPLOAD_BATCHES;
+        uploader->inFlight--;
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "allocator.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+/* clang-format off */
+#define UPLOAD_BATCHES      ALLOCATOR_RING_FRAMES /* batches in flight, one ring slot each */
+#define UPLOAD_BARRIERS_MAX 64                    /* buffers or images per batch */
+#define UPLOAD_ALIGNMENT    16                    /* staging offsets, any texel size up to 16 */
+#define UPLOAD_LEVELS_MAX   16                    /* mips per upload_image, up to 32768 wide */
+/* clang-format on */
+
+/* copies recorded into one command buffer and submitted together */
+struct UploadBatch
+{
+    VkCommandPool   commandPool; /* TRANSIENT, on the transfer family */
+    VkCommandBuffer commandBuffer;
+    VkFence         fence;
+    uint64_t        ticket;
+    VkDeviceSize    bytes;
+
+    /* acquire side of every copy, recorded on the graphics queue */
+    VkBufferMemoryBarrier buffers[UPLOAD_BARRIERS_MAX];
+    uint32_t              buffersCount;
+    VkImageMemoryBarrier  images[UPLOAD_BARRIERS_MAX];
+    uint32_t              imagesCount;
+};
+
+/* streams buffer and image contents through a persistently mapped staging
+ * ring on the transfer queue, so uploads overlap rendering instead of
+ * waiting for it. every call returns at once: a full ring or all batches
+ * in flight return ticket 0 and the caller retries next frame. a batch is
+ * submitted and finished ones are polled (vkGetFenceStatus, never a wait)
+ * in upload_frame, which also records the queue family ownership acquire
+ * into the graphics command buffer. not thread safe. */
+struct Uploader
+{
+    VkDevice             device;
+    struct Allocator*    allocator;
+    VkQueue              queue;
+    uint32_t             transferFamily;
+    uint32_t             graphicsFamily;
+    struct AllocatorRing ring;
+    VkBuffer             staging;
+
+    struct UploadBatch batches[UPLOAD_BATCHES];
+    uint32_t           next;     /* batch recording or to be opened */
+    bool               open;     /* batches[next] is recording */
+    uint32_t           oldest;   /* first submitted batch */
+    uint32_t           inFlight; /* submitted, not acquired yet */
+    uint64_t           ticketNext;
+    uint64_t           ticketDone; /* last acquired batch */
+
+    uint64_t bytesDone; /* acquired so far */
+};
+
+void upload_init(struct Uploader*  uploader,
+                 struct Allocator* allocator,
+                 VkQueue           queue,
+                 uint32_t          transferFamily,
+                 uint32_t          graphicsFamily,
+                 VkDeviceSize      stagingSize);
+
+/* the device must be idle */
+void upload_destroy(struct Uploader* uploader);
+
+/* copies size bytes of data into buffer at offset. buffer must not be in
+ * use by the graphics queue: its contents are replaced, so it needs no
+ * release from there. returns the ticket of the copy, 0 if it has to be
+ * retried later. size must fit the staging ring */
+uint64_t upload_buffer(struct Uploader* uploader,
+                       VkBuffer         buffer,
+                       VkDeviceSize     offset,
+                       const void*      data,
+                       VkDeviceSize     size);
+
+/* copies tightly packed texels into mips 0 to levelsCount - 1 of a single
+ * layer color image created with TRANSFER_DST usage, whose texel size
+ * divides UPLOAD_ALIGNMENT. data holds the levels one after the other,
+ * each half the extent of the one before (at least 1), so with more than
+ * one level the texel size must be a multiple of 4. the old contents are
+ * dropped, the levels end up in SHADER_READ_ONLY_OPTIMAL. size must fit
+ * the staging ring: all levels go in one copy or none does */
+uint64_t upload_image(struct Uploader* uploader,
+                      VkImage          image,
+                      VkExtent3D       extent,
+                      uint32_t         levelsCount,
+                      const void*      data,
+                      VkDeviceSize     size);
+
+/* call once per frame while recording the graphics command buffer, outside
+ * a render pass: submits the copies made since the last call and acquires
+ * the buffers and images of every finished batch into commandBuffer.
+ * commands recorded after it may use them. NULL uploader is a no-op */
+void upload_frame(struct Uploader* uploader, VkCommandBuffer commandBuffer);
+
+/* true once commands recorded after the upload_frame that acquired ticket
+ * may use its resources */
+static inline bool upload_done(const struct Uploader* uploader, uint64_t ticket)
+{
+    return ticket != 0 && ticket <= uploader->ticketDone;
+}
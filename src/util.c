@@ -1,25 +1,93 @@
+#include "util.h"
+
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 int ae_load_file_to_memory(const char* filename, char** result)
 {
-    int   size = 0;
-    FILE* f    = fopen(filename, "rb");
+    *result = NULL;
+    FILE* f = fopen(filename, "rb");
     if (f == NULL)
     {
-        *result = NULL;
         return -1;    // -1 means file opening fail
     }
-    fseek(f, 0, SEEK_END);
-    size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    *result = (char*) malloc(size + 1);
-    if (size != fread(*result, sizeof(char), size, f))
+    /* ftell fails (-1) on pipes and past INT_MAX the size does not fit */
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+        size = ftell(f);
+    if (size < 0 || size > INT_MAX - 1 || fseek(f, 0, SEEK_SET) != 0)
     {
-        free(*result);
+        fclose(f);
         return -2;    // -2 means file reading fail
     }
+    *result = (char*) malloc((size_t) size + 1);
+    if (*result == NULL || fread(*result, 1, (size_t) size, f) != (size_t) size)
+    {
+        free(*result);
+        *result = NULL;
+        fclose(f);
+        return -2;
+    }
     fclose(f);
     (*result)[size] = 0;
-    return size;
+    return (int) size;
+}
+
+uint64_t util_time_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+static int util_compare_double(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+double util_percentile(double* values, size_t count, double p)
+{
+    if (count == 0)
+        return 0.0;
+
+    qsort(values, count, sizeof(values[0]), util_compare_double);
+
+    size_t index = (size_t)(p * (double) (count - 1) + 0.5);
+    if (index >= count)
+        index = count - 1;
+    return values[index];
+}
+
+void samples_init(struct Samples* samples, uint32_t capacity)
+{
+    samples->values   = malloc(capacity * sizeof(samples->values[0]));
+    samples->count    = 0;
+    samples->capacity = samples->values != NULL ? capacity : 0;
+}
+
+void samples_push(struct Samples* samples, double value)
+{
+    if (samples->count < samples->capacity)
+        samples->values[samples->count++] = value;
+}
+
+void samples_destroy(struct Samples* samples)
+{
+    free(samples->values);
+    *samples = (struct Samples){};
 }
@@ -1,4 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
 /* source: */
 /* http://www.anyexample.com/programming/c/how_to_load_file_into_memory_using_plain_ansi_c_language.xml
  */
+/* returns the size, -1 if filename can not be opened, -2 if it can not be
+ * read. *result is malloc'ed, NUL terminated and freed by the caller, NULL
+ * on error */
 int ae_load_file_to_memory(const char* filename, char** result);
+
+/* monotonic clock in nanoseconds, only meaningful as a difference */
+uint64_t util_time_ns(void);
+
+/* sorts values in place and returns the p-th percentile (p in [0, 1]) */
+double util_percentile(double* values, size_t count, double p);
+
+/* measurements kept up to capacity, later ones are dropped */
+struct Samples
+{
+    double*  values;
+    uint32_t count;
+    uint32_t capacity;
+};
+
+void samples_init(struct Samples* samples, uint32_t capacity);
+
+void samples_push(struct Samples* samples, double value);
+
+void samples_destroy(struct Samples* samples);
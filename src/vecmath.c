@@ -0,0 +1,605 @@
+#include "vecmath.h"
+
+#include <string.h>
+
+#if VECMATH_SIMD && (defined(__SSE2__) || defined(_M_X64) || (_M_IX86_FP >= 2))
+#define VECMATH_SSE2_BUILT 1
+#include <emmintrin.h>
+#else
+#define VECMATH_SSE2_BUILT 0
+#endif
+
+/* gcc and clang compile the AVX2 functions for their own target and
+ * check the CPU at runtime, msvc only has them in /arch:AVX2 builds */
+#if VECMATH_SSE2_BUILT && (defined(__GNUC__) || defined(__AVX2__))
+#define VECMATH_AVX2_BUILT 1
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define VECMATH_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define VECMATH_AVX2_TARGET
+#endif
+#else
+#define VECMATH_AVX2_BUILT 0
+#endif
+
+struct VecmathKernels
+{
+    void (*pointsTransform)(const struct Mat4*, const struct Vec3Soa*, const struct Vec3Soa*,
+                            uint32_t, uint32_t);
+    void (*mat4Mul)(const struct Mat4*, const struct Mat4*, struct Mat4*, uint32_t);
+    void (*trs)(const struct Vec3Soa*, const struct QuatSoa*, const struct Vec3Soa*, float*,
+                size_t, uint32_t, uint32_t);
+    uint32_t (*spheresFrustum)(const float[VECMATH_FRUSTUM_PLANES][4], const struct Vec3Soa*,
+                               const float*, uint8_t*, uint32_t, uint32_t);
+    uint32_t width; /* elements per step, the rest goes through the scalar kernel */
+};
+
+static const char* const vecmathPathNames[VECMATH_PATHS_COUNT] = {"scalar", "sse2", "avx2"};
+
+/* mat4 **********************************************************************/
+struct Mat4 mat4_identity(void)
+{
+    struct Mat4 m = {};
+    m.m[0]        = 1.0f;
+    m.m[5]        = 1.0f;
+    m.m[10]       = 1.0f;
+    m.m[15]       = 1.0f;
+    return m;
+}
+
+struct Mat4 mat4_mul(const struct Mat4* a, const struct Mat4* b)
+{
+    struct Mat4 out;
+    for (uint32_t column = 0; column < 4; ++column)
+        for (uint32_t row = 0; row < 4; ++row)
+            out.m[column * 4 + row] = a->m[row] * b->m[column * 4] +
+                                      a->m[4 + row] * b->m[column * 4 + 1] +
+                                      a->m[8 + row] * b->m[column * 4 + 2] +
+                                      a->m[12 + row] * b->m[column * 4 + 3];
+    return out;
+}
+
+struct Vec3 mat4_transform_point(const struct Mat4* m, struct Vec3 p)
+{
+    const float* e = m->m;
+    return (struct Vec3){e[0] * p.x + e[4] * p.y + e[8] * p.z + e[12],
+                         e[1] * p.x + e[5] * p.y + e[9] * p.z + e[13],
+                         e[2] * p.x + e[6] * p.y + e[10] * p.z + e[14]};
+}
+
+struct Vec4 mat4_transform(const struct Mat4* m, struct Vec4 v)
+{
+    const float* e = m->m;
+    return (struct Vec4){e[0] * v.x + e[4] * v.y + e[8] * v.z + e[12] * v.w,
+                         e[1] * v.x + e[5] * v.y + e[9] * v.z + e[13] * v.w,
+                         e[2] * v.x + e[6] * v.y + e[10] * v.z + e[14] * v.w,
+                         e[3] * v.x + e[7] * v.y + e[11] * v.z + e[15] * v.w};
+}
+
+struct Mat4 mat4_trs(struct Vec3 translation, struct Quat rotation, struct Vec3 scale)
+{
+    float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+
+    struct Mat4 m = {};
+    m.m[0]        = (1.0f - 2.0f * (y * y + z * z)) * scale.x;
+    m.m[1]        = 2.0f * (x * y + w * z) * scale.x;
+    m.m[2]        = 2.0f * (x * z - w * y) * scale.x;
+    m.m[4]        = 2.0f * (x * y - w * z) * scale.y;
+    m.m[5]        = (1.0f - 2.0f * (x * x + z * z)) * scale.y;
+    m.m[6]        = 2.0f * (y * z + w * x) * scale.y;
+    m.m[8]        = 2.0f * (x * z + w * y) * scale.z;
+    m.m[9]        = 2.0f * (y * z - w * x) * scale.z;
+    m.m[10]       = (1.0f - 2.0f * (x * x + y * y)) * scale.z;
+    m.m[12]       = translation.x;
+    m.m[13]       = translation.y;
+    m.m[14]       = translation.z;
+    m.m[15]       = 1.0f;
+    return m;
+}
+
+/* scalar ********************************************************************/
+/* every kernel handles elements [first, count), so the SIMD ones finish
+ * their tail here */
+static void points_transform_scalar(const struct Mat4*    matrix,
+                                    const struct Vec3Soa* points,
+                                    const struct Vec3Soa* out,
+                                    uint32_t              first,
+                                    uint32_t              count)
+{
+    const float* m = matrix->m;
+    for (uint32_t i = first; i < count; ++i)
+    {
+        float x   = points->x[i];
+        float y   = points->y[i];
+        float z   = points->z[i];
+        out->x[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+        out->y[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+        out->z[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    }
+}
+
+static void mat4_mul_scalar(const struct Mat4* a,
+                            const struct Mat4* b,
+                            struct Mat4*       out,
+                            uint32_t           count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        out[i] = mat4_mul(&a[i], &b[i]);
+}
+
+static void trs_scalar(const struct Vec3Soa* translations,
+                       const struct QuatSoa* rotations,
+                       const struct Vec3Soa* scales,
+                       float*                out,
+                       size_t                stride,
+                       uint32_t              first,
+                       uint32_t              count)
+{
+    for (uint32_t i = first; i < count; ++i)
+    {
+        struct Vec3 translation = {translations->x[i], translations->y[i], translations->z[i]};
+        struct Quat rotation = {rotations->x[i], rotations->y[i], rotations->z[i], rotations->w[i]};
+        struct Vec3 scale    = {scales->x[i], scales->y[i], scales->z[i]};
+        struct Mat4 m        = mat4_trs(translation, rotation, scale);
+        memcpy((char*) out + i * stride, m.m, sizeof(m.m));
+    }
+}
+
+static uint32_t spheres_frustum_scalar(const float           planes[VECMATH_FRUSTUM_PLANES][4],
+                                       const struct Vec3Soa* centers,
+                                       const float*          radii,
+                                       uint8_t*              visible,
+                                       uint32_t              first,
+                                       uint32_t              count)
+{
+    uint32_t visibleCount = 0;
+    for (uint32_t i = first; i < count; ++i)
+    {
+        bool inside = true;
+        for (uint32_t p = 0; p < VECMATH_FRUSTUM_PLANES; ++p)
+        {
+            const float* plane = planes[p];
+            float distance     = plane[0] * centers->x[i] + plane[1] * centers->y[i] +
+                             plane[2] * centers->z[i] + plane[3];
+            inside = inside && distance >= -radii[i];
+        }
+        visible[i] = inside;
+        visibleCount += inside;
+    }
+    return visibleCount;
+}
+
+/* sse2 **********************************************************************/
+#if VECMATH_SSE2_BUILT
+static void points_transform_sse2(const struct Mat4*    matrix,
+                                  const struct Vec3Soa* points,
+                                  const struct Vec3Soa* out,
+                                  uint32_t              first,
+                                  uint32_t              count)
+{
+    const float* m = matrix->m;
+    __m128       e[16];
+    for (uint32_t i = 0; i < 16; ++i)
+        e[i] = _mm_set1_ps(m[i]);
+
+    for (uint32_t i = first; i < count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&points->x[i]);
+        __m128 y = _mm_loadu_ps(&points->y[i]);
+        __m128 z = _mm_loadu_ps(&points->z[i]);
+        for (uint32_t row = 0; row < 3; ++row)
+        {
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[row], x), _mm_mul_ps(e[4 + row], y)),
+                                  _mm_add_ps(_mm_mul_ps(e[8 + row], z), e[12 + row]));
+            float* o = row == 0 ? out->x : row == 1 ? out->y : out->z;
+            _mm_storeu_ps(&o[i], r);
+        }
+    }
+}
+
+static void mat4_mul_sse2(const struct Mat4* a,
+                          const struct Mat4* b,
+                          struct Mat4*       out,
+                          uint32_t           count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float* am   = a[i].m;
+        const float* bm   = b[i].m;
+        __m128       a0   = _mm_loadu_ps(&am[0]);
+        __m128       a1   = _mm_loadu_ps(&am[4]);
+        __m128       a2   = _mm_loadu_ps(&am[8]);
+        __m128       a3   = _mm_loadu_ps(&am[12]);
+        for (uint32_t column = 0; column < 4; ++column)
+        {
+            const float* bc = &bm[column * 4];
+            __m128       r  = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bc[0])), _mm_mul_ps(a1, _mm_set1_ps(bc[1]))),
+                _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bc[2])), _mm_mul_ps(a3, _mm_set1_ps(bc[3]))));
+            _mm_storeu_ps(&out[i].m[column * 4], r);
+        }
+    }
+}
+
+/* components of the columns of 4 matrices, lane l of c[column][row] belongs
+ * to matrix first + l: transposed into one column per matrix */
+static void trs_store_sse2(__m128 c[4][4], float* out, size_t stride, uint32_t first)
+{
+    for (uint32_t column = 0; column < 4; ++column)
+    {
+        __m128 r0 = c[column][0], r1 = c[column][1], r2 = c[column][2], r3 = c[column][3];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        char* base = (char*) out + first * stride + column * 4 * sizeof(float);
+        _mm_storeu_ps((float*) (base), r0);
+        _mm_storeu_ps((float*) (base + stride), r1);
+        _mm_storeu_ps((float*) (base + 2 * stride), r2);
+        _mm_storeu_ps((float*) (base + 3 * stride), r3);
+    }
+}
+
+static void trs_sse2(const struct Vec3Soa* translations,
+                     const struct QuatSoa* rotations,
+                     const struct Vec3Soa* scales,
+                     float*                out,
+                     size_t                stride,
+                     uint32_t              first,
+                     uint32_t              count)
+{
+    const __m128 one  = _mm_set1_ps(1.0f);
+    const __m128 two  = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (uint32_t i = first; i < count; i += 4)
+    {
+        __m128 x  = _mm_loadu_ps(&rotations->x[i]);
+        __m128 y  = _mm_loadu_ps(&rotations->y[i]);
+        __m128 z  = _mm_loadu_ps(&rotations->z[i]);
+        __m128 w  = _mm_loadu_ps(&rotations->w[i]);
+        __m128 sx = _mm_loadu_ps(&scales->x[i]);
+        __m128 sy = _mm_loadu_ps(&scales->y[i]);
+        __m128 sz = _mm_loadu_ps(&scales->z[i]);
+
+        __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+        __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+        __m128 c[4][4] = {
+            {_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+             _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+             _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+             zero},
+            {_mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+             _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+             zero},
+            {_mm_mul_ps(_mm_add_ps(xz, wy), sz),
+             _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+             zero},
+            {_mm_loadu_ps(&translations->x[i]),
+             _mm_loadu_ps(&translations->y[i]),
+             _mm_loadu_ps(&translations->z[i]),
+             one},
+        };
+        trs_store_sse2(c, out, stride, i);
+    }
+}
+
+static uint32_t spheres_frustum_sse2(const float           planes[VECMATH_FRUSTUM_PLANES][4],
+                                     const struct Vec3Soa* centers,
+                                     const float*          radii,
+                                     uint8_t*              visible,
+                                     uint32_t              first,
+                                     uint32_t              count)
+{
+    uint32_t visibleCount = 0;
+    for (uint32_t i = first; i < count; i += 4)
+    {
+        __m128 x      = _mm_loadu_ps(&centers->x[i]);
+        __m128 y      = _mm_loadu_ps(&centers->y[i]);
+        __m128 z      = _mm_loadu_ps(&centers->z[i]);
+        __m128 radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radii[i]));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t p = 0; p < VECMATH_FRUSTUM_PLANES; ++p)
+        {
+            const float* plane    = planes[p];
+            __m128       distance = _mm_set1_ps(plane[3]);
+            distance              = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[2]), z));
+            distance              = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[1]), y));
+            distance              = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[0]), x));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, radius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (uint32_t l = 0; l < 4; ++l)
+        {
+            visible[i + l] = (mask >> l) & 1;
+            visibleCount += visible[i + l];
+        }
+    }
+    return visibleCount;
+}
+#endif
+
+/* avx2 **********************************************************************/
+#if VECMATH_AVX2_BUILT
+VECMATH_AVX2_TARGET
+static void points_transform_avx2(const struct Mat4*    matrix,
+                                  const struct Vec3Soa* points,
+                                  const struct Vec3Soa* out,
+                                  uint32_t              first,
+                                  uint32_t              count)
+{
+    const float* m = matrix->m;
+    __m256       e[16];
+    for (uint32_t i = 0; i < 16; ++i)
+        e[i] = _mm256_set1_ps(m[i]);
+
+    for (uint32_t i = first; i < count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(&points->x[i]);
+        __m256 y = _mm256_loadu_ps(&points->y[i]);
+        __m256 z = _mm256_loadu_ps(&points->z[i]);
+        for (uint32_t row = 0; row < 3; ++row)
+        {
+            __m256 r = _mm256_fmadd_ps(e[8 + row], z, e[12 + row]);
+            r        = _mm256_fmadd_ps(e[4 + row], y, r);
+            r        = _mm256_fmadd_ps(e[row], x, r);
+            float* o = row == 0 ? out->x : row == 1 ? out->y : out->z;
+            _mm256_storeu_ps(&o[i], r);
+        }
+    }
+}
+
+/* two columns of the product per step: the columns of a in both halves
+ * times an element of each of two columns of b */
+VECMATH_AVX2_TARGET
+static void mat4_mul_avx2(const struct Mat4* a,
+                          const struct Mat4* b,
+                          struct Mat4*       out,
+                          uint32_t           count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float* am = a[i].m;
+        const float* bm = b[i].m;
+        __m256       a0 = _mm256_broadcast_ps((const __m128*) &am[0]);
+        __m256       a1 = _mm256_broadcast_ps((const __m128*) &am[4]);
+        __m256       a2 = _mm256_broadcast_ps((const __m128*) &am[8]);
+        __m256       a3 = _mm256_broadcast_ps((const __m128*) &am[12]);
+        for (uint32_t column = 0; column < 4; column += 2)
+        {
+            __m256 bc = _mm256_loadu_ps(&bm[column * 4]);
+            __m256 r  = _mm256_mul_ps(a0, _mm256_shuffle_ps(bc, bc, 0x00));
+            r         = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(bc, bc, 0x55), r);
+            r         = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(bc, bc, 0xaa), r);
+            r         = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(bc, bc, 0xff), r);
+            _mm256_storeu_ps(&out[i].m[column * 4], r);
+        }
+    }
+}
+
+/* trs_store_sse2 for 8 matrices, the low halves are matrices first..first
+ * + 3 and the high ones first + 4..first + 7. compiled for AVX itself, legacy
+ * SSE code in between would stall on the upper halves */
+VECMATH_AVX2_TARGET
+static void trs_store_avx2(__m256 c[4][4], float* out, size_t stride, uint32_t first)
+{
+    for (uint32_t column = 0; column < 4; ++column)
+        for (uint32_t half = 0; half < 2; ++half)
+        {
+            __m128 r0 = half ? _mm256_extractf128_ps(c[column][0], 1)
+                             : _mm256_castps256_ps128(c[column][0]);
+            __m128 r1 = half ? _mm256_extractf128_ps(c[column][1], 1)
+                             : _mm256_castps256_ps128(c[column][1]);
+            __m128 r2 = half ? _mm256_extractf128_ps(c[column][2], 1)
+                             : _mm256_castps256_ps128(c[column][2]);
+            __m128 r3 = half ? _mm256_extractf128_ps(c[column][3], 1)
+                             : _mm256_castps256_ps128(c[column][3]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            char* base = (char*) out + (first + 4 * half) * stride + column * 4 * sizeof(float);
+            _mm_storeu_ps((float*) (base), r0);
+            _mm_storeu_ps((float*) (base + stride), r1);
+            _mm_storeu_ps((float*) (base + 2 * stride), r2);
+            _mm_storeu_ps((float*) (base + 3 * stride), r3);
+        }
+}
+
+VECMATH_AVX2_TARGET
+static void trs_avx2(const struct Vec3Soa* translations,
+                     const struct QuatSoa* rotations,
+                     const struct Vec3Soa* scales,
+                     float*                out,
+                     size_t                stride,
+                     uint32_t              first,
+                     uint32_t              count)
+{
+    const __m256 one  = _mm256_set1_ps(1.0f);
+    const __m256 two  = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    for (uint32_t i = first; i < count; i += 8)
+    {
+        __m256 x  = _mm256_loadu_ps(&rotations->x[i]);
+        __m256 y  = _mm256_loadu_ps(&rotations->y[i]);
+        __m256 z  = _mm256_loadu_ps(&rotations->z[i]);
+        __m256 w  = _mm256_loadu_ps(&rotations->w[i]);
+        __m256 sx = _mm256_loadu_ps(&scales->x[i]);
+        __m256 sy = _mm256_loadu_ps(&scales->y[i]);
+        __m256 sz = _mm256_loadu_ps(&scales->z[i]);
+
+        __m256 x2 = _mm256_mul_ps(x, two), y2 = _mm256_mul_ps(y, two), z2 = _mm256_mul_ps(z, two);
+        __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+        __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+        __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+        __m256 c[4][4] = {
+            {_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+             _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+             _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+             zero},
+            {_mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+             _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+             _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+             zero},
+            {_mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+             _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+             _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+             zero},
+            {_mm256_loadu_ps(&translations->x[i]),
+             _mm256_loadu_ps(&translations->y[i]),
+             _mm256_loadu_ps(&translations->z[i]),
+             one},
+        };
+
+        trs_store_avx2(c, out, stride, i);
+    }
+}
+
+VECMATH_AVX2_TARGET
+static uint32_t spheres_frustum_avx2(const float           planes[VECMATH_FRUSTUM_PLANES][4],
+                                     const struct Vec3Soa* centers,
+                                     const float*          radii,
+                                     uint8_t*              visible,
+                                     uint32_t              first,
+                                     uint32_t              count)
+{
+    uint32_t visibleCount = 0;
+    for (uint32_t i = first; i < count; i += 8)
+    {
+        __m256 x      = _mm256_loadu_ps(&centers->x[i]);
+        __m256 y      = _mm256_loadu_ps(&centers->y[i]);
+        __m256 z      = _mm256_loadu_ps(&centers->z[i]);
+        __m256 radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&radii[i]));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t p = 0; p < VECMATH_FRUSTUM_PLANES; ++p)
+        {
+            const float* plane    = planes[p];
+            __m256       distance = _mm256_set1_ps(plane[3]);
+            distance              = _mm256_fmadd_ps(_mm256_set1_ps(plane[2]), z, distance);
+            distance              = _mm256_fmadd_ps(_mm256_set1_ps(plane[1]), y, distance);
+            distance              = _mm256_fmadd_ps(_mm256_set1_ps(plane[0]), x, distance);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, radius, _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        for (uint32_t l = 0; l < 8; ++l)
+        {
+            visible[i + l] = (mask >> l) & 1;
+            visibleCount += visible[i + l];
+        }
+    }
+    return visibleCount;
+}
+#endif
+
+/* dispatch ******************************************************************/
+static const struct VecmathKernels vecmathKernels[VECMATH_PATHS_COUNT] = {
+    {points_transform_scalar, mat4_mul_scalar, trs_scalar, spheres_frustum_scalar, 1},
+#if VECMATH_SSE2_BUILT
+    {points_transform_sse2, mat4_mul_sse2, trs_sse2, spheres_frustum_sse2, 4},
+#else
+    {},
+#endif
+#if VECMATH_AVX2_BUILT
+    {points_transform_avx2, mat4_mul_avx2, trs_avx2, spheres_frustum_avx2, 8},
+#else
+    {},
+#endif
+};
+
+static enum VecmathPath vecmathPath = VECMATH_SCALAR;
+
+bool vecmath_path_supported(enum VecmathPath path)
+{
+    if (path == VECMATH_SCALAR)
+        return true;
+    if (path == VECMATH_SSE2)
+        return VECMATH_SSE2_BUILT;
+#if VECMATH_AVX2_BUILT && defined(__GNUC__)
+    if (path == VECMATH_AVX2)
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+#elif VECMATH_AVX2_BUILT
+    if (path == VECMATH_AVX2)
+        return true;
+#endif
+    return false;
+}
+
+enum VecmathPath vecmath_init(void)
+{
+    vecmathPath = VECMATH_SCALAR;
+    for (uint32_t path = VECMATH_SSE2; path < VECMATH_PATHS_COUNT; ++path)
+        if (vecmath_path_supported(path))
+            vecmathPath = path;
+    return vecmathPath;
+}
+
+bool vecmath_path_set(enum VecmathPath path)
+{
+    if (path >= VECMATH_PATHS_COUNT || !vecmath_path_supported(path))
+        return false;
+    vecmathPath = path;
+    return true;
+}
+
+enum VecmathPath vecmath_path(void)
+{
+    return vecmathPath;
+}
+
+const char* vecmath_path_name(enum VecmathPath path)
+{
+    return path < VECMATH_PATHS_COUNT ? vecmathPathNames[path] : "unknown";
+}
+
+/* the first count rounded down to the path's width go through its kernel */
+static uint32_t vecmath_body(const struct VecmathKernels* kernels, uint32_t count)
+{
+    return count - count % kernels->width;
+}
+
+void vecmath_points_transform(const struct Mat4*    matrix,
+                              const struct Vec3Soa* points,
+                              const struct Vec3Soa* out,
+                              uint32_t              count)
+{
+    const struct VecmathKernels* kernels = &vecmathKernels[vecmathPath];
+    uint32_t                     body    = vecmath_body(kernels, count);
+    kernels->pointsTransform(matrix, points, out, 0, body);
+    points_transform_scalar(matrix, points, out, body, count);
+}
+
+void vecmath_mat4_mul_batch(const struct Mat4* a,
+                            const struct Mat4* b,
+                            struct Mat4*       out,
+                            uint32_t           count)
+{
+    vecmathKernels[vecmathPath].mat4Mul(a, b, out, count);
+}
+
+void vecmath_trs_batch(const struct Vec3Soa* translations,
+                       const struct QuatSoa* rotations,
+                       const struct Vec3Soa* scales,
+                       float*                out,
+                       size_t                stride,
+                       uint32_t              count)
+{
+    const struct VecmathKernels* kernels = &vecmathKernels[vecmathPath];
+    uint32_t                     body    = vecmath_body(kernels, count);
+    kernels->trs(translations, rotations, scales, out, stride, 0, body);
+    trs_scalar(translations, rotations, scales, out, stride, body, count);
+}
+
+uint32_t vecmath_spheres_frustum(const float           planes[VECMATH_FRUSTUM_PLANES][4],
+                                 const struct Vec3Soa* centers,
+                                 const float*          radii,
+                                 uint8_t*              visible,
+                                 uint32_t              count)
+{
+    const struct VecmathKernels* kernels = &vecmathKernels[vecmathPath];
+    uint32_t                     body    = vecmath_body(kernels, count);
+    return kernels->spheresFrustum(planes, centers, radii, visible, 0, body) +
+           spheres_frustum_scalar(planes, centers, radii, visible, body, count);
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* vector, matrix and quaternion math. the single value functions are plain
+ * scalar code, the batch kernels work on structure of arrays input and
+ * have SSE2 and AVX2+FMA paths picked at runtime by vecmath_init. built
+ * with VECMATH_SIMD=0 (cmake -DTJTECH1_SIMD=OFF) only the scalar path
+ * exists. */
+
+#ifndef VECMATH_SIMD
+#define VECMATH_SIMD 1
+#endif
+
+/* clang-format off */
+#define VECMATH_FRUSTUM_PLANES 6
+/* clang-format on */
+
+enum VecmathPath
+{
+    VECMATH_SCALAR,
+    VECMATH_SSE2,
+    VECMATH_AVX2,
+    VECMATH_PATHS_COUNT
+};
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+struct Vec4
+{
+    float x, y, z, w;
+};
+
+/* rotation, unit length */
+struct Quat
+{
+    float x, y, z, w;
+};
+
+/* column major like Instance.model, translation in m[12..14] */
+struct Mat4
+{
+    float m[16];
+};
+
+/* count elements spread over one array per component */
+struct Vec3Soa
+{
+    float* x;
+    float* y;
+    float* z;
+};
+
+struct QuatSoa
+{
+    float* x;
+    float* y;
+    float* z;
+    float* w;
+};
+
+/* vec3 **********************************************************************/
+static inline struct Vec3 vec3_add(struct Vec3 a, struct Vec3 b)
+{
+    return (struct Vec3){a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+static inline struct Vec3 vec3_sub(struct Vec3 a, struct Vec3 b)
+{
+    return (struct Vec3){a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+static inline struct Vec3 vec3_scale(struct Vec3 v, float s)
+{
+    return (struct Vec3){v.x * s, v.y * s, v.z * s};
+}
+
+static inline float vec3_dot(struct Vec3 a, struct Vec3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline struct Vec3 vec3_cross(struct Vec3 a, struct Vec3 b)
+{
+    return (struct Vec3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+static inline float vec3_length(struct Vec3 v)
+{
+    return sqrtf(vec3_dot(v, v));
+}
+
+/* v unchanged if it has no length */
+static inline struct Vec3 vec3_normalize(struct Vec3 v)
+{
+    float length = vec3_length(v);
+    return length > 0.0f ? vec3_scale(v, 1.0f / length) : v;
+}
+
+/* vec4 **********************************************************************/
+static inline struct Vec4 vec4_add(struct Vec4 a, struct Vec4 b)
+{
+    return (struct Vec4){a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+}
+
+static inline struct Vec4 vec4_scale(struct Vec4 v, float s)
+{
+    return (struct Vec4){v.x * s, v.y * s, v.z * s, v.w * s};
+}
+
+static inline float vec4_dot(struct Vec4 a, struct Vec4 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+/* quat **********************************************************************/
+static inline struct Quat quat_identity(void)
+{
+    return (struct Quat){0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+/* rotation by radians around axis, which is unit length */
+static inline struct Quat quat_axis_angle(struct Vec3 axis, float radians)
+{
+    float s = sinf(0.5f * radians);
+    return (struct Quat){axis.x * s, axis.y * s, axis.z * s, cosf(0.5f * radians)};
+}
+
+/* rotation by b, then by a */
+static inline struct Quat quat_mul(struct Quat a, struct Quat b)
+{
+    return (struct Quat){a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                         a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                         a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                         a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+static inline struct Quat quat_normalize(struct Quat q)
+{
+    float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (length <= 0.0f)
+        return quat_identity();
+    float s = 1.0f / length;
+    return (struct Quat){q.x * s, q.y * s, q.z * s, q.w * s};
+}
+
+static inline struct Vec3 quat_rotate(struct Quat q, struct Vec3 v)
+{
+    /* v + 2w (u x v) + 2u x (u x v), u = q.xyz */
+    struct Vec3 u = {q.x, q.y, q.z};
+    struct Vec3 t = vec3_scale(vec3_cross(u, v), 2.0f);
+    return vec3_add(vec3_add(v, vec3_scale(t, q.w)), vec3_cross(u, t));
+}
+
+/* mat4 **********************************************************************/
+struct Mat4 mat4_identity(void);
+
+/* a * b: b applied first */
+struct Mat4 mat4_mul(const struct Mat4* a, const struct Mat4* b);
+
+/* m * (p, 1), the projective divide left out */
+struct Vec3 mat4_transform_point(const struct Mat4* m, struct Vec3 p);
+
+struct Vec4 mat4_transform(const struct Mat4* m, struct Vec4 v);
+
+/* translation * rotation * scale */
+struct Mat4 mat4_trs(struct Vec3 translation, struct Quat rotation, struct Vec3 scale);
+
+/* batch kernels *************************************************************/
+/* selects the widest path the build and CPU support, call once at startup
+ * before any thread runs a kernel. kernels run scalar until then */
+enum VecmathPath vecmath_init(void);
+
+bool vecmath_path_supported(enum VecmathPath path);
+
+/* false and unchanged if path is not supported, for comparing paths. not
+ * thread safe */
+bool vecmath_path_set(enum VecmathPath path);
+
+enum VecmathPath vecmath_path(void);
+
+const char* vecmath_path_name(enum VecmathPath path);
+
+/* out[i] = matrix * (points[i], 1), out may be points */
+void vecmath_points_transform(const struct Mat4*    matrix,
+                              const struct Vec3Soa* points,
+                              const struct Vec3Soa* out,
+                              uint32_t              count);
+
+/* out[i] = a[i] * b[i], out may not overlap a or b */
+void vecmath_mat4_mul_batch(const struct Mat4* a,
+                            const struct Mat4* b,
+                            struct Mat4*       out,
+                            uint32_t           count);
+
+/* world matrices from translation, rotation and scale. matrix i is written
+ * stride bytes after matrix i - 1, so they can go straight into the model
+ * of struct Instance (stride sizeof(struct Instance)) or a mapped buffer */
+void vecmath_trs_batch(const struct Vec3Soa* translations,
+                       const struct QuatSoa* rotations,
+                       const struct Vec3Soa* scales,
+                       float*                out,
+                       size_t                stride,
+                       uint32_t              count);
+
+/* visible[i] = 1 if sphere i, center centers[i] and radius radii[i], is on
+ * the inner side of every plane (xyz . p + w >= -radius), else 0. returns
+ * the number of visible spheres */
+uint32_t vecmath_spheres_frustum(const float           planes[VECMATH_FRUSTUM_PLANES][4],
+                                 const struct Vec3Soa* centers,
+                                 const float*          radii,
+                                 uint8_t*              visible,
+                                 uint32_t              count);